@@ -0,0 +1,134 @@
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <stdexcept>
+#include <sys/socket.h>
+
+#include "server/EventLoop.hpp"
+
+/*
+	Simulates high connection churn: every request registers a new
+	connection, waits for its request byte, switches it to POLLOUT,
+	writes the response byte and removes it again. Reports how many
+	readiness syscalls each backend needs per request, and the total
+	once the socket read and write of every request are added.
+
+	Every backend, io_uring included, only reports readiness: the reads
+	and writes are the same two syscalls whichever backend is used.
+	io_uring batches its registration changes into the wait, which is
+	what epoll pays for with an epoll_ctl() per change, but it makes no
+	fewer syscalls than poll, which has no registration to change at all.
+*/
+
+static constexpr size_t _CHURN_REQUESTS		= 200000;
+static constexpr size_t _CHURN_CONCURRENCY	= 64;
+
+struct ChurnResult
+{
+	double	syscalls_per_request;
+	double	total_syscalls_per_request;	/* Including the socket reads and writes */
+	double	nanoseconds_per_request;
+};
+
+static ChurnResult measure_churn(EventLoop& event_loop)
+{
+	std::vector<EventLoopEvent>	ready_events;
+	std::vector<int>			peer_file_descriptors(1024, -1);
+
+	size_t	started_requests	= 0;
+	size_t	finished_requests	= 0;
+	size_t	socket_syscalls		= 0;	/* Reads and writes of the server side */
+	char	byte				= 'x';
+
+	const size_t	syscalls_before	= event_loop.get_backend_syscall_count();
+	const auto		start_time		= std::chrono::steady_clock::now();
+
+	while (finished_requests < _CHURN_REQUESTS)
+	{
+		while (started_requests - finished_requests < _CHURN_CONCURRENCY &&
+			started_requests < _CHURN_REQUESTS)
+		{
+			int connection_pair[2];
+
+			if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, connection_pair))
+				throw std::runtime_error("Failed to create connection pair");
+
+			if (static_cast<size_t>(connection_pair[0]) >= peer_file_descriptors.size())
+				peer_file_descriptors.resize(static_cast<size_t>(connection_pair[0]) + 1, -1);
+
+			peer_file_descriptors[static_cast<size_t>(connection_pair[0])] = connection_pair[1];
+
+			event_loop.add_file_descriptor(connection_pair[0], POLLIN);
+
+			if (write(connection_pair[1], &byte, 1) != 1)
+				throw std::runtime_error("Failed to write request byte");
+
+			++started_requests;
+		}
+
+		event_loop.wait_for_events(ready_events, -1);
+
+		for (const EventLoopEvent& ready_event : ready_events)
+		{
+			if (ready_event.events & POLLIN)
+			{
+				if (read(ready_event.fd, &byte, 1) != 1)
+					throw std::runtime_error("Failed to read request byte");
+
+				++socket_syscalls;
+
+				event_loop.modify_file_descriptor(ready_event.fd, POLLOUT);
+			}
+			else if (ready_event.events & POLLOUT)
+			{
+				if (write(ready_event.fd, &byte, 1) != 1)
+					throw std::runtime_error("Failed to write response byte");
+
+				++socket_syscalls;
+
+				event_loop.remove_file_descriptor(ready_event.fd);
+
+				close(peer_file_descriptors[static_cast<size_t>(ready_event.fd)]);
+				close(ready_event.fd);
+
+				++finished_requests;
+			}
+		}
+	}
+
+	const auto end_time = std::chrono::steady_clock::now();
+
+	const size_t backend_syscalls = event_loop.get_backend_syscall_count() - syscalls_before;
+
+	return {
+		static_cast<double>(backend_syscalls) / static_cast<double>(_CHURN_REQUESTS),
+		static_cast<double>(backend_syscalls + socket_syscalls) / static_cast<double>(_CHURN_REQUESTS),
+		static_cast<double>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count()
+		) / static_cast<double>(_CHURN_REQUESTS)
+	};
+}
+
+int main()
+{
+	std::printf("=== Event loop churn (%zu requests, %zu concurrent) ===\n",
+		_CHURN_REQUESTS, _CHURN_CONCURRENCY);
+	std::printf("%-10s %18s %16s %16s\n", "backend", "syscalls/request", "with socket I/O", "ns/request");
+
+	for (const EventLoopBackend backend : {EventLoopBackend::POLL, EventLoopBackend::EPOLL, EventLoopBackend::IO_URING})
+	{
+		std::unique_ptr<EventLoop> event_loop = EventLoop::create(backend);
+
+		const ChurnResult result = measure_churn(*event_loop);
+
+		std::printf("%-10s %18.3f %16.3f %16.0f\n",
+			event_loop->get_backend_name(),
+			result.syscalls_per_request,
+			result.total_syscalls_per_request,
+			result.nanoseconds_per_request);
+	}
+
+	return EXIT_SUCCESS;
+}
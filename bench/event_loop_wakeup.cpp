@@ -0,0 +1,122 @@
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+
+#include "server/EventLoop.hpp"
+
+/*
+	Measures the cost of one event loop wakeup while a growing
+	number of idle connections is registered next to a single
+	active one. The poll backend scales with the idle count,
+	the epoll and io_uring backends should stay flat.
+*/
+
+static constexpr size_t	_WAKEUP_ITERATIONS			= 20000;
+static constexpr size_t	_IDLE_CONNECTION_COUNTS[]	= {0, 100, 1000, 10000};
+
+static size_t raise_file_descriptor_limit()
+{
+	rlimit limit = {};
+
+	if (getrlimit(RLIMIT_NOFILE, &limit))
+		return 1024;
+
+	limit.rlim_cur = limit.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &limit);
+
+	getrlimit(RLIMIT_NOFILE, &limit);
+	return static_cast<size_t>(limit.rlim_cur);
+}
+
+static double measure_wakeup_nanoseconds(
+	const EventLoopBackend	backend,
+	const size_t			idle_connection_count)
+{
+	std::unique_ptr<EventLoop>	event_loop = EventLoop::create(backend);
+	std::vector<int>			idle_file_descriptors;
+
+	/* An eventfd that is never signalled behaves like an idle keep-alive socket */
+	for (size_t i = 0; i < idle_connection_count; ++i)
+	{
+		const int idle_file_descriptor = eventfd(0, EFD_NONBLOCK);
+
+		if (idle_file_descriptor < 0)
+			break;
+
+		event_loop->add_file_descriptor(idle_file_descriptor, POLLIN);
+		idle_file_descriptors.push_back(idle_file_descriptor);
+	}
+
+	int active_pair[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, active_pair))
+		throw std::runtime_error("Failed to create active socket pair");
+
+	event_loop->add_file_descriptor(active_pair[0], POLLIN);
+
+	std::vector<EventLoopEvent> ready_events;
+
+	char byte = 'x';
+
+	const auto start_time = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < _WAKEUP_ITERATIONS; ++i)
+	{
+		if (write(active_pair[1], &byte, 1) != 1)
+			throw std::runtime_error("Failed to write wakeup byte");
+
+		event_loop->wait_for_events(ready_events, -1);
+
+		for (const EventLoopEvent& ready_event : ready_events)
+			if (read(ready_event.fd, &byte, 1) != 1)
+				throw std::runtime_error("Failed to read wakeup byte");
+	}
+
+	const auto end_time = std::chrono::steady_clock::now();
+
+	close(active_pair[0]);
+	close(active_pair[1]);
+
+	for (const int idle_file_descriptor : idle_file_descriptors)
+		close(idle_file_descriptor);
+
+	return static_cast<double>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count()
+	) / static_cast<double>(_WAKEUP_ITERATIONS);
+}
+
+int main()
+{
+	const size_t file_descriptor_limit = raise_file_descriptor_limit();
+
+	std::printf("=== Event loop wakeup cost (1 active, N idle connections) ===\n");
+	std::printf("%-8s %12s %16s\n", "backend", "idle", "ns/wakeup");
+
+	for (const EventLoopBackend backend : {EventLoopBackend::POLL, EventLoopBackend::EPOLL, EventLoopBackend::IO_URING})
+	{
+		for (const size_t idle_connection_count : _IDLE_CONNECTION_COUNTS)
+		{
+			/* Keep headroom for stdio, the loop and the active pair */
+			if (idle_connection_count + 16 > file_descriptor_limit)
+			{
+				std::printf("skipping %zu idle connections, descriptor limit is %zu\n",
+					idle_connection_count, file_descriptor_limit);
+				continue;
+			}
+
+			const double nanoseconds = measure_wakeup_nanoseconds(backend, idle_connection_count);
+
+			std::printf("%-8s %12zu %16.0f\n",
+				get_event_loop_backend_name(backend),
+				idle_connection_count, nanoseconds);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+#include <chrono>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "http/HttpRequest.hpp"
+
+/*
+	Feeds requests of growing size to HttpRequest in fixed size reads, the
+	way the server receives them, and reports the parsing cost per byte.
+	A parser that keeps its position between reads stays flat as the size
+	doubles, one that rescans the buffered bytes on every read grows with it.
+*/
+
+static constexpr size_t _READ_SIZE			= 4096;
+static constexpr size_t _HEADER_READ_SIZE	= 1;	/* Worst case, a client trickling its header */
+
+static std::string make_multipart_request(const size_t body_size)
+{
+	const std::string boundary = "----benchboundary7MA4YWxkTrZu0gW";
+
+	std::string body
+		= "--" + boundary + "\r\n"
+		+ "Content-Disposition: form-data; name=\"file\"; filename=\"bench.bin\"\r\n"
+		+ "Content-Type: application/octet-stream\r\n\r\n";
+
+	body.append(body_size, 'x');
+	body += "\r\n--" + boundary + "--\r\n";
+
+	/* No Content-Length, the end of the request is found by scanning for the closing boundary */
+	return "POST /upload HTTP/1.1\r\n"
+		   "Host: localhost\r\n"
+		   "Content-Type: multipart/form-data; boundary=" + boundary + "\r\n"
+		   "\r\n" + body;
+}
+
+static constexpr size_t _HEADER_LINE_COUNT = 64;	/* Well under _MAX_HTTP_REQUEST_HEADER_COUNT, values grow instead */
+
+static std::string make_large_header_request(const size_t header_size)
+{
+	std::string request = "GET /index.html HTTP/1.1\r\nHost: localhost\r\n";
+
+	const std::string header_value(header_size / _HEADER_LINE_COUNT, 'v');
+
+	for (size_t header_index = 0; header_index < _HEADER_LINE_COUNT; ++header_index)
+		request += "X-Bench-" + std::to_string(header_index) + ": " + header_value + "\r\n";
+
+	return request + "\r\n";
+}
+
+static double measure_nanoseconds_per_byte(const std::string& request, const size_t read_size)
+{
+	HttpRequest http_request;
+
+	bool is_http_request_complete = false;
+
+	const auto start_time = std::chrono::steady_clock::now();
+
+	for (size_t offset = 0; offset < request.length(); offset += read_size)
+		is_http_request_complete = http_request.process_incoming_http_request(
+			request.substr(offset, read_size)
+		);
+
+	const auto end_time = std::chrono::steady_clock::now();
+
+	if (!is_http_request_complete)
+		throw std::runtime_error("Request was not recognized as complete");
+
+	return static_cast<double>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count()
+	) / static_cast<double>(request.length());
+}
+
+int main()
+{
+	std::printf("=== Multipart upload, %zu byte reads ===\n", _READ_SIZE);
+	std::printf("%-12s %12s\n", "body bytes", "ns/byte");
+
+	for (size_t body_size = size_t(1) << 20; body_size <= size_t(16) << 20; body_size <<= 1)
+		std::printf("%-12zu %12.2f\n",
+			body_size,
+			measure_nanoseconds_per_byte(make_multipart_request(body_size), _READ_SIZE));
+
+	std::printf("\n=== Header block, %zu byte reads ===\n", _HEADER_READ_SIZE);
+	std::printf("%-12s %12s\n", "header bytes", "ns/byte");
+
+	/* Stays under _MAX_HTTP_REQUEST_HEADER_SIZE */
+	for (size_t header_size = size_t(1) << 10; header_size <= size_t(16) << 10; header_size <<= 1)
+		std::printf("%-12zu %12.2f\n",
+			header_size,
+			measure_nanoseconds_per_byte(make_large_header_request(header_size), _HEADER_READ_SIZE));
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "http_request_corpus.hpp"
+
+/*
+	Parses every request of the corpus over and over, delivered in reads of
+	a fixed size, and reports requests and megabytes per second. The whole
+	request in one read is the best case, 1460 bytes is one TCP segment and
+	1 byte a client trickling its request.
+*/
+
+static constexpr size_t _READ_SIZES[]				= {0, 1460, 512, 64, 8, 1};	/* 0: the whole request in one read */
+static constexpr double	_MEASUREMENT_SECONDS		= 0.05;
+
+static std::vector<std::string> split_http_request(const std::string& request, const size_t read_size)
+{
+	if (!read_size)
+		return {request};
+
+	std::vector<std::string> reads;
+
+	for (size_t offset = 0; offset < request.length(); offset += read_size)
+		reads.push_back(request.substr(offset, read_size));
+
+	return reads;
+}
+
+struct Throughput
+{
+	double	requests_per_second;
+	double	megabytes_per_second;
+};
+
+static Throughput measure_throughput(const std::string& request, const size_t read_size)
+{
+	/* Split beforehand, only the parser is timed */
+	const std::vector<std::string> reads = split_http_request(request, read_size);
+
+	HttpRequest http_request;
+
+	size_t	request_count	= 0;
+	size_t	iteration_count	= 0;
+	double	elapsed_seconds	= 0;
+
+	const auto start_time = std::chrono::steady_clock::now();
+
+	/* Batches between clock reads, enough iterations to time even the slowest split */
+	for (size_t batch_size = 1; elapsed_seconds < _MEASUREMENT_SECONDS; batch_size *= 2)
+	{
+		for (size_t iteration = 0; iteration < batch_size; ++iteration)
+		{
+			const size_t parsed_count = feed_http_request_reads(http_request, reads, [](const HttpRequest&) {});
+
+			if (!parsed_count || http_request.has_http_request_data())
+				throw std::runtime_error("Request was not parsed to the end");
+
+			request_count += parsed_count;
+		}
+
+		iteration_count += batch_size;
+		elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	}
+
+	return {
+		static_cast<double>(request_count) / elapsed_seconds,
+		static_cast<double>(iteration_count * request.length()) / elapsed_seconds / 1e6
+	};
+}
+
+int main()
+{
+	const std::vector<HttpRequestSample> corpus = make_http_request_corpus();
+
+	std::printf("=== HttpRequest parse throughput, requests/s and MB/s by read size ===\n");
+	std::printf("%-16s %7s", "request", "bytes");
+
+	for (const size_t read_size : _READ_SIZES)
+	{
+		if (read_size)
+			std::printf(" %14zu B", read_size);
+		else
+			std::printf(" %16s", "whole");
+	}
+
+	std::printf("\n");
+
+	for (const HttpRequestSample& sample : corpus)
+	{
+		std::printf("%-16s %7zu", sample.name, sample.request.length());
+
+		for (const size_t read_size : _READ_SIZES)
+		{
+			const Throughput throughput = measure_throughput(sample.request, read_size);
+
+			std::printf(" %9.0f/%6.1f", throughput.requests_per_second, throughput.megabytes_per_second);
+		}
+
+		std::printf("\n");
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+#include <new>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+#include "http/HttpUrl.hpp"
+
+/*
+	Decodes and normalizes the paths of request targets real clients send,
+	with HttpUrl and with the decoder it replaced (a new string built one
+	character at a time, substr() and std::stoi() for every escape). Every
+	operator new is counted, a decoder reusing its buffer allocates nothing
+	once the buffer has grown to the longest path.
+*/
+
+static constexpr size_t _DECODE_ITERATIONS = 1000000;
+
+static size_t allocation_count = 0;
+
+void* operator new(const size_t size)
+{
+	++allocation_count;
+
+	if (void* const pointer = std::malloc(size ? size : 1))
+		return pointer;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* const pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* const pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
+
+struct UrlSet
+{
+	const char*	name;
+	std::string	target;
+};
+
+static std::vector<UrlSet> make_url_sets()
+{
+	return {
+		{"plain",		"/static/js/app.3f9c2b.js"},
+		{"query",		"/search/results.html?q=web+server&page=2&sort=desc"},
+		{"escaped",		"/upload/Quarterly%20Report%20%282025%29%20-%20Final%20Version.pdf"},
+		{"utf8",		"/files/%E6%97%A5%E6%9C%AC%E8%AA%9E/%C3%A9t%C3%A9%20%C3%A0%20Paris.txt"},
+		{"dot-segs",	"/a/b/./c/../../d//e/./f/../index.html"},
+		{"long",		"/assets/images/gallery/2025/october/holidays/mountains/"
+						"lake-view/panorama/high-resolution/original/IMG_20251016_101502%20%281%29.jpg"}
+	};
+}
+
+/* What RequestManager did before: no normalization, a new string per call */
+static std::string decode_url_with_stoi(const std::string& encoded)
+{
+	std::string decoded;
+
+	for (size_t i = 0; i < encoded.length(); ++i)
+	{
+		if (encoded[i] == '%' && i + 2 < encoded.length())
+		{
+			std::string hex_str = encoded.substr(i + 1, 2);
+
+			decoded	+= static_cast<char>(std::stoi(hex_str, nullptr, 16));
+			i		+= 2;
+		}
+		else if (encoded[i] == '+')
+			decoded += ' ';
+		else
+			decoded += encoded[i];
+	}
+
+	return decoded;
+}
+
+struct Measurement
+{
+	double	nanoseconds;
+	double	allocations;
+};
+
+template <typename Decoder>
+static Measurement measure(const Decoder& decoder)
+{
+	/* Keeps the compiler from dropping the loop */
+	volatile size_t checksum = 0;
+
+	const size_t	start_allocation_count	= allocation_count;
+	const auto		start_time				= std::chrono::steady_clock::now();
+
+	for (size_t iteration = 0; iteration < _DECODE_ITERATIONS; ++iteration)
+		checksum = checksum + decoder();
+
+	const auto end_time = std::chrono::steady_clock::now();
+
+	return {
+		static_cast<double>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count()
+		) / static_cast<double>(_DECODE_ITERATIONS),
+		static_cast<double>(allocation_count - start_allocation_count) / static_cast<double>(_DECODE_ITERATIONS)
+	};
+}
+
+int main()
+{
+	const std::vector<UrlSet> url_sets = make_url_sets();
+
+	/* One buffer for every request, like the member of HttpRequest */
+	std::string path;
+	path.reserve(256);
+
+	std::printf("=== URL path decoding (ns and allocations per request target) ===\n");
+	std::printf("%-10s %6s %12s %12s %12s %12s\n", "set", "bytes", "stoi ns", "stoi allocs", "HttpUrl ns", "HttpUrl allocs");
+
+	for (const UrlSet& url_set : url_sets)
+	{
+		const Measurement stoi_measurement = measure([&url_set]()
+		{
+			return decode_url_with_stoi(url_set.target).length();
+		});
+
+		const Measurement http_url_measurement = measure([&url_set, &path]()
+		{
+			path.assign(HttpUrl::get_http_url_path(url_set.target));
+			HttpUrl::normalize_http_url_path(path);
+
+			return path.length();
+		});
+
+		std::printf("%-10s %6zu %12.1f %12.2f %12.1f %12.2f\n",
+			url_set.name, url_set.target.length(),
+			stoi_measurement.nanoseconds, stoi_measurement.allocations,
+			http_url_measurement.nanoseconds, http_url_measurement.allocations);
+	}
+
+	return EXIT_SUCCESS;
+}
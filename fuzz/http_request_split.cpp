@@ -0,0 +1,231 @@
+#include <random>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "../bench/http_request_corpus.hpp"
+
+/*
+	The bytes of a connection arrive in reads of any size, the parser must
+	reach the same result however they are cut. Every request of the corpus,
+	and mutations of them, is parsed in one read and then cut at every
+	position and at random positions. The requests it completes, their heads,
+	bodies and multipart parts, and the error that stops it must not change.
+
+	Usage: fuzz_http_request_split [seed] [iterations]
+*/
+
+static constexpr size_t _DEFAULT_ITERATIONS		= 2000;
+static constexpr size_t _RANDOM_SPLITS			= 8;	/* Random cuts of every input, on top of the exhaustive ones */
+static constexpr size_t _BODY_BUFFER_SIZE		= 4096;	/* Small enough for the larger bodies to be spooled */
+static constexpr size_t _MAX_BODY_SIZE			= 65536;
+
+static std::string describe_body_spool(const HttpBodySpool& body_spool)
+{
+	return body_spool.read(0, body_spool.size());
+}
+
+/* Everything the handlers read from a complete request */
+static std::string describe_http_request(const HttpRequest& http_request)
+{
+	std::string description
+		= std::to_string(static_cast<int>(http_request.get_http_request_method())) + " "
+		+ http_request.get_http_request_url() + " "
+		+ http_request.get_http_request_path() + " "
+		+ http_request.get_http_request_version() + "\n";
+
+	http_request.for_each_http_request_header([&description](const std::string_view name, const std::string_view value)
+	{
+		description.append(name).append(": ").append(value).append("\n");
+	});
+
+	description += "keep-alive " + std::to_string(http_request.is_keep_alive_requested()) + "\n";
+	description += "body " + std::to_string(http_request.get_http_request_body_length()) + "\n";
+
+	description += http_request.is_http_request_body_spooled()
+		? describe_body_spool(http_request.get_http_request_body_spool())
+		: http_request.get_http_request_body();
+
+	for (const HttpMultipartPart& part : http_request.get_http_request_multipart_parts())
+	{
+		description += "\npart " + part.name + " " + part.filename + " " + part.content_type + "\n";
+		description += part.content_spool.is_open() ? describe_body_spool(part.content_spool) : part.content;
+	}
+
+	return description + "\n";
+}
+
+static std::string parse_http_request_reads(const std::vector<std::string>& reads)
+{
+	HttpRequest http_request;
+
+	http_request.set_http_request_max_body_size(_MAX_BODY_SIZE, _MAX_BODY_SIZE);
+	http_request.set_http_request_body_spooling(_BODY_BUFFER_SIZE, "/tmp");
+
+	std::string result;
+
+	try
+	{
+		feed_http_request_reads(http_request, reads, [&result](const HttpRequest& complete_http_request)
+		{
+			result += describe_http_request(complete_http_request);
+		});
+
+		result += http_request.has_http_request_data() ? "incomplete\n" : "end\n";
+	}
+	catch (const HttpRequestError& e)
+	{
+		result += "error " + std::to_string(static_cast<int>(e.get_http_status_code())) + "\n";
+	}
+	/* Malformed heads are answered with 400 by the server whatever the message */
+	catch (const std::exception&)
+	{
+		result += "error 400\n";
+	}
+
+	return result;
+}
+
+static std::vector<std::string> split_at(const std::string& data, std::vector<size_t> positions)
+{
+	std::sort(positions.begin(), positions.end());
+
+	std::vector<std::string>	reads;
+	size_t						start = 0;
+
+	for (const size_t position : positions)
+	{
+		if (position <= start || position >= data.length())
+			continue;
+
+		reads.push_back(data.substr(start, position - start));
+		start = position;
+	}
+
+	reads.push_back(data.substr(start));
+
+	return reads;
+}
+
+static std::string mutate(std::string data, std::mt19937_64& random)
+{
+	static const char* const fragments[] = {
+		"\r\n", "\n", "\r\n\r\n", ":", " ", "\t", "0\r\n\r\n", "--", "%", "%2e%2e/", "../",
+		"Content-Length: 3\r\n", "Transfer-Encoding: chunked\r\n", "ffffffffffffffffff\r\n"
+	};
+
+	const size_t mutation_count = 1 + random() % 4;
+
+	for (size_t mutation = 0; mutation < mutation_count && !data.empty(); ++mutation)
+	{
+		const size_t position = random() % data.length();
+
+		switch (random() % 4)
+		{
+		case 0:
+			data[position] = static_cast<char>(random());
+			break;
+
+		case 1:
+			data.erase(position, 1 + random() % 16);
+			break;
+
+		case 2:
+			data.insert(position, fragments[random() % (sizeof(fragments) / sizeof(*fragments))]);
+			break;
+
+		default:
+		{
+			const size_t length = 1 + random() % 32;
+			data.insert(position, data.substr(position, length));
+		}
+		}
+	}
+
+	return data;
+}
+
+/* Compares every split with the single read, prints the first difference */
+static bool check_http_request_splits(const char* const name, const std::string& data, std::mt19937_64& random, const bool is_exhaustive)
+{
+	const std::string expected = parse_http_request_reads({data});
+
+	std::vector<std::vector<size_t>> splits;
+
+	/* Two reads cut at every position: a delimiter, a header or a chunk size cut anywhere */
+	if (is_exhaustive)
+		for (size_t position = 1; position < data.length(); ++position)
+			splits.push_back({position});
+
+	for (size_t split = 0; split < _RANDOM_SPLITS && data.length() > 1; ++split)
+	{
+		std::vector<size_t> positions(1 + random() % 32);
+
+		for (size_t& position : positions)
+			position = 1 + random() % (data.length() - 1);
+
+		splits.push_back(std::move(positions));
+	}
+
+	for (const std::vector<size_t>& positions : splits)
+	{
+		const std::string result = parse_http_request_reads(split_at(data, positions));
+
+		if (result == expected)
+			continue;
+
+		std::fprintf(stderr, "MISMATCH in %s (%zu bytes) cut at", name, data.length());
+
+		for (const size_t position : positions)
+			std::fprintf(stderr, " %zu", position);
+
+		std::fprintf(stderr, "\n--- one read ---\n%s\n--- split ---\n%s\n", expected.c_str(), result.c_str());
+
+		return false;
+	}
+
+	return true;
+}
+
+int main(const int argc, char** const argv)
+{
+	const unsigned long long	seed		= argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 42;
+	const size_t				iterations	= argc > 2 ? std::strtoull(argv[2], nullptr, 10) : _DEFAULT_ITERATIONS;
+
+	std::mt19937_64 random(seed);
+
+	const std::vector<HttpRequestSample> corpus = make_http_request_corpus();
+
+	std::string all_requests;
+
+	for (const HttpRequestSample& sample : corpus)
+	{
+		if (!check_http_request_splits(sample.name, sample.request, random, true))
+			return EXIT_FAILURE;
+
+		all_requests += sample.request;
+	}
+
+	/* The whole corpus on one connection, every request pipelined after the previous one */
+	if (!check_http_request_splits("corpus", all_requests, random, false))
+		return EXIT_FAILURE;
+
+	for (size_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		const HttpRequestSample& sample = corpus[random() % corpus.size()];
+
+		if (!check_http_request_splits(sample.name, mutate(sample.request, random), random, false))
+		{
+			std::fprintf(stderr, "Seed %llu, iteration %zu\n", seed, iteration);
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::printf("%zu corpus requests and %zu mutations parsed identically however they were split (seed %llu)\n",
+		corpus.size(), iterations, seed);
+
+	return EXIT_SUCCESS;
+}
@@ -89,51 +89,33 @@ private:
 	 * environment setup, and error handling during script execution.
 	 *
 	 * Steps performed:
+	 * - Verifies the existence and executability of the script and its interpreter.
+	 * - Builds the argument and environment arrays, so the child never allocates
+	 *   (other worker threads may hold allocator locks at the time of fork()).
 	 * - Creates input and output pipes for inter-process communication.
 	 * - Forks a child process to execute the CGI script.
 	 * - In the child process:
-	 *   - Sets up `stdin` and `stdout` to use the pipes.
+	 *   - Sets up `stdin` and `stdout` to use the pipes, `stdin` reads the spool file
+	 *     directly when the body was spooled.
 	 *   - Changes the working directory to the script's directory.
-	 *   - Verifies the existence and executability of the script and its interpreter.
-	 *   - Executes the CGI script via `execl`.
+	 *   - Executes the CGI script via `execve`.
 	 * - In the parent process:
 	 *   - Writes the request body to the child process's input pipe (if provided).
 	 *   - Reads the script's output from the output pipe.
 	 *   - Waits for the child process to complete.
 	 *
 	 * @param request_body The body of the HTTP request, which is sent to the CGI script if applicable.
+	 * @param request_body_file_descriptor The spool file holding the body instead, -1 if there is none.
 	 * @return The output of the CGI script as a string.
 	 *
 	 * @throws std::runtime_error If:
+	 * - The script or its interpreter is missing or not executable.
 	 * - Pipes or forking the process fails.
 	 * - Writing the request body to the input pipe fails.
 	 * - The CGI script execution fails (e.g., non-zero exit status).
 	 */
 	[[nodiscard]]
-	std::string execute_cgi_script(const std::string& request_body) const;
-
-	/**
-	 * @brief Converts a chunked HTTP request body into its original, unchunked form.
-	 *
-	 * This function processes a chunked HTTP request body as per the HTTP/1.1 specification,
-	 * decoding it into its original unchunked representation. Each chunk contains a hexadecimal
-	 * size followed by the chunk data and ends with a `\r\n`. The function reads each chunk, decodes
-	 * its size, and appends the corresponding data to the result string.
-	 *
-	 * Steps performed:
-	 * - Parses the hexadecimal size of each chunk from the input string.
-	 * - Reads the specified number of bytes for the chunk data.
-	 * - Ignores the trailing `\r\n` after each chunk.
-	 * - Stops processing when a chunk of size 0 is encountered, indicating the end of the body.
-	 *
-	 * @param chunked_body The chunked HTTP request body as a string.
-	 * @return The unchunked body as a string.
-	 *
-	 * @throws std::bad_alloc If memory allocation for chunk data fails.
-	 * @throws std::runtime_error If the chunk size is invalid or the data is incomplete.
-	 */
-	[[nodiscard]]
-	std::string unchunk_request_body(const std::string& chunked_body) const;
+	std::string execute_cgi_script(const std::string& request_body, int request_body_file_descriptor) const;
 
 	/**
 	 * @brief Checks if a file exists at the given file path.
@@ -203,6 +203,38 @@ private:
 	*/
 	void parse_directory_listing(const std::string& line) const;
 
+	/**
+	* @brief Parses the content cache setting for a route.
+	*
+	* Within a location block, 'on' serves the route's files up to
+	* content_cache_max_object_size from memory, 'off' (the default) with sendfile().
+	*
+	* @param line The configuration line containing the content cache setting
+	* @throws std::runtime_error If the setting is invalid or not within a location block
+	*/
+	void parse_content_cache(const std::string& line) const;
+
+	/**
+	* @brief Parses how much memory every worker may spend on cached file contents.
+	*
+	* Between 0 and _MAX_CONTENT_CACHE_SIZE bytes, 'K' and 'M' units are accepted.
+	* The least recently used files are dropped to make room.
+	*
+	* @param line The configuration line containing the size
+	* @throws std::runtime_error If the size is invalid
+	*/
+	void parse_content_cache_size(const std::string& line) const;
+
+	/**
+	* @brief Parses the size of the largest file the content cache keeps in memory.
+	*
+	* Between 0 and _MAX_CONTENT_CACHE_SIZE bytes, 'K' and 'M' units are accepted.
+	*
+	* @param line The configuration line containing the size
+	* @throws std::runtime_error If the size is invalid
+	*/
+	void parse_content_cache_max_object_size(const std::string& line) const;
+
 	/**
 	* @brief Parses the upload directory configuration for a route.
 	*
@@ -244,6 +276,132 @@ private:
 	 */
 	void parse_cgi_handler(const std::string& line) const;
 
+	/**
+	* @brief Parses the event loop backend selection from the configuration line.
+	*
+	* Selects the readiness mechanism used by the server main loop:
+	* - 'epoll' only returns ready descriptors, wakeup cost does not grow with idle connections
+	* - 'poll' scans every monitored descriptor on each wakeup
+	* - 'io_uring' batches every registration change into the wait syscall, falls back to 'poll'
+	*
+	* @param line The configuration line containing the event backend
+	* @throws std::runtime_error If the backend is unknown
+	*/
+	void parse_event_backend(const std::string& line) const;
+
+	/**
+	* @brief Parses the worker thread count from the configuration line.
+	*
+	* Each worker thread runs its own event loop with its own SO_REUSEPORT
+	* listening sockets, the kernel spreads new connections over them:
+	* - A number between 1 and _MAX_WORKER_THREADS
+	* - 'auto' uses one worker per available core
+	*
+	* @param line The configuration line containing the worker thread count
+	* @throws std::runtime_error If the count is invalid
+	*/
+	void parse_worker_threads(const std::string& line) const;
+
+	/**
+	* @brief Parses the keep-alive timeout from the configuration line.
+	*
+	* The number of seconds an idle persistent connection stays open
+	* waiting for its next request, between 0 and _MAX_KEEPALIVE_TIMEOUT.
+	* An optional 's' suffix is accepted, 0 disables persistent connections.
+	*
+	* @param line The configuration line containing the timeout
+	* @throws std::runtime_error If the timeout is invalid
+	*/
+	void parse_keepalive_timeout(const std::string& line) const;
+
+	/**
+	* @brief Parses the maximum number of requests served by one persistent connection.
+	*
+	* The connection is closed after the response to the last allowed request,
+	* the count must be between 1 and _MAX_KEEPALIVE_REQUESTS.
+	*
+	* @param line The configuration line containing the request count
+	* @throws std::runtime_error If the count is invalid
+	*/
+	void parse_keepalive_requests(const std::string& line) const;
+
+	/**
+	* @brief Parses the time a client may take to send the complete request header.
+	*
+	* Counted from the first byte of the request (or from accept), so a client
+	* trickling a header byte by byte cannot hold its connection forever.
+	* Between 1 and _MAX_CLIENT_TIMEOUT seconds, answered with 408 when exceeded.
+	*
+	* @param line The configuration line containing the timeout
+	* @throws std::runtime_error If the timeout is invalid
+	*/
+	void parse_client_header_timeout(const std::string& line) const;
+
+	/**
+	* @brief Parses the time a client may stay silent between two reads of the request body.
+	*
+	* Between 1 and _MAX_CLIENT_TIMEOUT seconds, answered with 408 when exceeded.
+	*
+	* @param line The configuration line containing the timeout
+	* @throws std::runtime_error If the timeout is invalid
+	*/
+	void parse_client_body_timeout(const std::string& line) const;
+
+	/**
+	* @brief Parses the time a client may take to accept more of the response.
+	*
+	* Between 1 and _MAX_CLIENT_TIMEOUT seconds, the connection is closed when exceeded.
+	*
+	* @param line The configuration line containing the timeout
+	* @throws std::runtime_error If the timeout is invalid
+	*/
+	void parse_send_timeout(const std::string& line) const;
+
+	/**
+	* @brief Parses how long a graceful shutdown waits for open connections.
+	*
+	* Between 0 and _MAX_CLIENT_TIMEOUT seconds, the connections still open
+	* when it runs out are closed. 0 closes them right away.
+	*
+	* @param line The configuration line containing the timeout
+	* @throws std::runtime_error If the timeout is invalid
+	*/
+	void parse_shutdown_timeout(const std::string& line) const;
+
+	/**
+	* @brief Parses the accept queue length passed to listen() for every port.
+	*
+	* Between 1 and _MAX_LISTEN_BACKLOG, the kernel silently caps it at
+	* net.core.somaxconn. A short queue makes connection bursts overflow it,
+	* the dropped handshakes are retransmitted by the clients seconds later.
+	*
+	* @param line The configuration line containing the backlog
+	* @throws std::runtime_error If the backlog is invalid
+	*/
+	void parse_listen_backlog(const std::string& line) const;
+
+	/**
+	* @brief Parses how much of a request body is kept in memory.
+	*
+	* Between 0 and _MAX_CLIENT_BODY_BUFFER_SIZE bytes, 'K' and 'M' units are
+	* accepted. Larger bodies are spooled to client_body_temp_path as they arrive.
+	*
+	* @param line The configuration line containing the size
+	* @throws std::runtime_error If the size is invalid
+	*/
+	void parse_client_body_buffer_size(const std::string& line) const;
+
+	/**
+	* @brief Parses the directory request bodies are spooled to.
+	*
+	* It must exist and be writable. On the filesystem of the upload
+	* directories, finished uploads are linked into place instead of copied.
+	*
+	* @param line The configuration line containing the directory
+	* @throws std::runtime_error If the path is not a writable directory
+	*/
+	void parse_client_body_temp_path(const std::string& line) const;
+
 	/**
 	* @brief Routes configuration lines to their specific parsing functions.
 	*
@@ -260,6 +418,13 @@ private:
 	* - Redirects
 	* - Upload directory
 	* - CGI handlers
+	* - Event loop backend
+	* - Worker threads
+	* - Keep-alive timeout and requests
+	* - Client header, client body and send timeouts
+	* - Listen backlog
+	* - Client body buffer size and temp path
+	* - Content cache, its size and largest object
 	*
 	* @param line The configuration line to be parsed
 	*/
@@ -155,6 +155,17 @@ public:
 		return directory_listing;
 	}
 
+	/**
+	* @brief Checks if the small files of this route are served from memory.
+	*
+	* @return bool True if the content cache is enabled, false otherwise
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	bool is_content_cache_enabled() const noexcept
+	{
+		return content_cache;
+	}
+
 	/**
 	* @brief Checks if a specific HTTP method is allowed for this route.
 	*
@@ -235,6 +246,17 @@ public:
 		directory_listing = enabled;
 	}
 
+	/**
+	* @brief Enables or disables the content cache for this route.
+	*
+	* @param enabled Flag to turn the content cache on or off
+	*/
+	__attribute__((always_inline))
+	void set_content_cache(bool enabled) noexcept
+	{
+		content_cache = enabled;
+	}
+
 	/**
 	* @brief Sets the upload directory for this route.
 	*
@@ -354,6 +376,7 @@ private:
 	std::string	index_file;
 	std::string	upload_directory;
 	bool		directory_listing;
+	bool		content_cache;
 	int			server_listening_port;
 
 	std::set<HttpMethod>				allowed_http_methods;
@@ -7,6 +7,7 @@
 #include <unordered_set>
 
 #include "configuration/Route.hpp"
+#include "server/EventLoopBackend.hpp"
 
 /*
 	Linux stack allocates 8MB, so this is safe,
@@ -19,6 +20,22 @@
 #define _MAX_POST_REQUEST_SIZE		10485760	/* 10MB */
 #define _MAX_REQUEST_READ_SIZE		65536		/* 64KB */
 #define _DEFAULT_REQUEST_READ_SIZE	4096		/* 1 page */
+#define _MAX_WORKER_THREADS			256
+#define _DEFAULT_KEEPALIVE_TIMEOUT	75			/* Seconds */
+#define _MAX_KEEPALIVE_TIMEOUT		3600		/* 1 hour */
+#define _DEFAULT_KEEPALIVE_REQUESTS	1000
+#define _MAX_KEEPALIVE_REQUESTS		1000000
+#define _DEFAULT_CLIENT_TIMEOUT		60			/* Seconds */
+#define _MAX_CLIENT_TIMEOUT			3600		/* 1 hour */
+#define _DEFAULT_LISTEN_BACKLOG		511			/* Capped by net.core.somaxconn */
+#define _MAX_LISTEN_BACKLOG			65535
+#define _DEFAULT_SHUTDOWN_TIMEOUT	30			/* Seconds */
+#define _DEFAULT_CLIENT_BODY_BUFFER_SIZE	16384		/* Larger bodies are spooled to a file */
+#define _MAX_CLIENT_BODY_BUFFER_SIZE		_MAX_POST_REQUEST_SIZE
+#define _DEFAULT_CLIENT_BODY_TEMP_PATH		"/tmp"
+#define _DEFAULT_CONTENT_CACHE_SIZE				16777216	/* 16MB per worker */
+#define _MAX_CONTENT_CACHE_SIZE					1073741824	/* 1GB per worker */
+#define _DEFAULT_CONTENT_CACHE_MAX_OBJECT_SIZE	262144		/* 256KB, larger files are sent with sendfile() */
 
 class ServerConfiguration
 {
@@ -96,6 +113,149 @@ public:
 		return request_read_size;
 	}
 
+	/**
+	 * @brief Gets the readiness mechanism used by the server event loop
+	 *
+	 * @return EventLoopBackend The configured backend (poll, epoll or io_uring)
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	EventLoopBackend get_event_loop_backend() const noexcept
+	{
+		return event_loop_backend;
+	}
+
+	/**
+	 * @brief Gets the number of worker threads, each running its own event loop
+	 *
+	 * @return size_t The worker thread count, always at least 1
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_worker_thread_count() const noexcept
+	{
+		return worker_thread_count;
+	}
+
+	/**
+	 * @brief Gets how long an idle persistent connection is kept open
+	 *
+	 * @return size_t The keep-alive timeout in seconds, 0 disables persistent connections
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_keepalive_timeout() const noexcept
+	{
+		return keepalive_timeout;
+	}
+
+	/**
+	 * @brief Gets how many requests a single persistent connection may serve
+	 *
+	 * @return size_t The maximum number of requests per connection
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_keepalive_requests() const noexcept
+	{
+		return keepalive_requests;
+	}
+
+	/**
+	 * @brief Gets how long a client may take to send the complete request header
+	 *
+	 * @return size_t The header timeout in seconds
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_client_header_timeout() const noexcept
+	{
+		return client_header_timeout;
+	}
+
+	/**
+	 * @brief Gets how long a client may stay silent between two reads of the request body
+	 *
+	 * @return size_t The body timeout in seconds
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_client_body_timeout() const noexcept
+	{
+		return client_body_timeout;
+	}
+
+	/**
+	 * @brief Gets how long a client may take to accept more response data
+	 *
+	 * @return size_t The send timeout in seconds
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_send_timeout() const noexcept
+	{
+		return send_timeout;
+	}
+
+	/**
+	 * @brief Gets how long a graceful shutdown waits for open connections to finish
+	 *
+	 * @return size_t The shutdown timeout in seconds
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_shutdown_timeout() const noexcept
+	{
+		return shutdown_timeout;
+	}
+
+	/**
+	 * @brief Gets the length of the accept queue requested for every listening socket
+	 *
+	 * @return int The listen() backlog
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	int get_listen_backlog() const noexcept
+	{
+		return listen_backlog;
+	}
+
+	/**
+	 * @brief Gets how much of a request body is kept in memory before it is spooled to a file
+	 *
+	 * @return size_t The threshold in bytes
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_client_body_buffer_size() const noexcept
+	{
+		return client_body_buffer_size;
+	}
+
+	/**
+	 * @brief Gets how much memory every worker may spend on cached file contents
+	 *
+	 * @return size_t The budget in bytes
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_content_cache_size() const noexcept
+	{
+		return content_cache_size;
+	}
+
+	/**
+	 * @brief Gets the size of the largest file the content cache keeps in memory
+	 *
+	 * @return size_t The size in bytes
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_content_cache_max_object_size() const noexcept
+	{
+		return content_cache_max_object_size;
+	}
+
+	/**
+	 * @brief Gets the directory request bodies are spooled to
+	 *
+	 * @return const std::string& The directory path
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	const std::string& get_client_body_temp_path() const noexcept
+	{
+		return client_body_temp_path;
+	}
+
 	/**
 	 * @brief Retrieves the root directory for the server configuration.
 	 *
@@ -230,6 +390,149 @@ public:
 		request_read_size = size;
 	}
 
+	/**
+	 * @brief Sets the readiness mechanism used by the server event loop
+	 *
+	 * @param backend The backend to use (poll, epoll or io_uring)
+	 */
+	__attribute__((always_inline))
+	void set_event_loop_backend(EventLoopBackend backend) noexcept
+	{
+		event_loop_backend = backend;
+	}
+
+	/**
+	 * @brief Sets the number of worker threads
+	 *
+	 * @param count The worker thread count, 0 is raised to 1
+	 */
+	__attribute__((always_inline))
+	void set_worker_thread_count(size_t count) noexcept
+	{
+		worker_thread_count = count ? count : 1;
+	}
+
+	/**
+	 * @brief Sets how long an idle persistent connection is kept open
+	 *
+	 * @param timeout The keep-alive timeout in seconds, 0 disables persistent connections
+	 */
+	__attribute__((always_inline))
+	void set_keepalive_timeout(size_t timeout) noexcept
+	{
+		keepalive_timeout = timeout;
+	}
+
+	/**
+	 * @brief Sets how many requests a single persistent connection may serve
+	 *
+	 * @param count The maximum number of requests per connection, 0 is raised to 1
+	 */
+	__attribute__((always_inline))
+	void set_keepalive_requests(size_t count) noexcept
+	{
+		keepalive_requests = count ? count : 1;
+	}
+
+	/**
+	 * @brief Sets how long a client may take to send the complete request header
+	 *
+	 * @param timeout The header timeout in seconds
+	 */
+	__attribute__((always_inline))
+	void set_client_header_timeout(size_t timeout) noexcept
+	{
+		client_header_timeout = timeout;
+	}
+
+	/**
+	 * @brief Sets how long a client may stay silent between two reads of the request body
+	 *
+	 * @param timeout The body timeout in seconds
+	 */
+	__attribute__((always_inline))
+	void set_client_body_timeout(size_t timeout) noexcept
+	{
+		client_body_timeout = timeout;
+	}
+
+	/**
+	 * @brief Sets how long a client may take to accept more response data
+	 *
+	 * @param timeout The send timeout in seconds
+	 */
+	__attribute__((always_inline))
+	void set_send_timeout(size_t timeout) noexcept
+	{
+		send_timeout = timeout;
+	}
+
+	/**
+	 * @brief Sets how long a graceful shutdown waits for open connections to finish
+	 *
+	 * @param timeout The shutdown timeout in seconds
+	 */
+	__attribute__((always_inline))
+	void set_shutdown_timeout(size_t timeout) noexcept
+	{
+		shutdown_timeout = timeout;
+	}
+
+	/**
+	 * @brief Sets the length of the accept queue requested for every listening socket
+	 *
+	 * @param backlog The listen() backlog
+	 */
+	__attribute__((always_inline))
+	void set_listen_backlog(int backlog) noexcept
+	{
+		listen_backlog = backlog;
+	}
+
+	/**
+	 * @brief Sets how much of a request body is kept in memory before it is spooled to a file
+	 *
+	 * @param size The threshold in bytes
+	 */
+	__attribute__((always_inline))
+	void set_client_body_buffer_size(size_t size) noexcept
+	{
+		client_body_buffer_size = size;
+	}
+
+	/**
+	 * @brief Sets how much memory every worker may spend on cached file contents
+	 *
+	 * @param size The budget in bytes
+	 */
+	__attribute__((always_inline))
+	void set_content_cache_size(size_t size) noexcept
+	{
+		content_cache_size = size;
+	}
+
+	/**
+	 * @brief Sets the size of the largest file the content cache keeps in memory
+	 *
+	 * @param size The size in bytes
+	 */
+	__attribute__((always_inline))
+	void set_content_cache_max_object_size(size_t size) noexcept
+	{
+		content_cache_max_object_size = size;
+	}
+
+	/**
+	 * @brief Sets the directory request bodies are spooled to
+	 *
+	 * @param directory_path The directory path
+	 */
+	__attribute__((always_inline))
+	void set_client_body_temp_path(const std::string& directory_path)
+	{
+		client_body_temp_path = directory_path;
+	}
+
 	/**
 	 * @brief Sets the root directory for the server configuration.
 	 *
@@ -315,6 +618,22 @@ private:
 	size_t max_request_body_size	= _MAX_REQUEST_BODY_SIZE;
 	size_t max_post_request_size	= _MAX_POST_REQUEST_SIZE;
 	size_t request_read_size		= _DEFAULT_REQUEST_READ_SIZE;
+	size_t client_body_buffer_size	= _DEFAULT_CLIENT_BODY_BUFFER_SIZE;
+
+	size_t content_cache_size				= _DEFAULT_CONTENT_CACHE_SIZE;
+	size_t content_cache_max_object_size	= _DEFAULT_CONTENT_CACHE_MAX_OBJECT_SIZE;
+
+	size_t worker_thread_count		= 1;
+	size_t keepalive_timeout		= _DEFAULT_KEEPALIVE_TIMEOUT;
+	size_t keepalive_requests		= _DEFAULT_KEEPALIVE_REQUESTS;
+	size_t client_header_timeout	= _DEFAULT_CLIENT_TIMEOUT;
+	size_t client_body_timeout		= _DEFAULT_CLIENT_TIMEOUT;
+	size_t send_timeout				= _DEFAULT_CLIENT_TIMEOUT;
+	size_t shutdown_timeout			= _DEFAULT_SHUTDOWN_TIMEOUT;
+
+	int listen_backlog				= _DEFAULT_LISTEN_BACKLOG;
+
+	EventLoopBackend event_loop_backend	= EventLoopBackend::EPOLL;
 
 	std::unordered_set<int>				server_listening_ports;
 	std::vector<Route>					url_routes;
@@ -322,5 +641,6 @@ private:
 
 	Route*		current_url_route;
 	std::string	default_error_page_path;
+	std::string	client_body_temp_path	= _DEFAULT_CLIENT_BODY_TEMP_PATH;
 	std::string	root_directory;
 };
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <string_view>
+
+#define _HTTP_BODY_SPOOL_BLOCK_SIZE		65536	/* Bytes read at a time when copying the file */
+#define _HTTP_BODY_SPOOL_LINK_ATTEMPTS	16		/* Random temporary names tried before giving up on linking */
+
+/**
+* @brief A request body too large to be kept in memory, written to a file as it arrives
+*
+* The file is created with O_TMPFILE, so it has no name and disappears with
+* its descriptor, even if the server dies. Filesystems without O_TMPFILE get
+* a mkstemp() file instead, which is unlinked when the spool is closed.
+*
+* Finished uploads are published with save_as(): the file is linked to a
+* random temporary name next to the destination when both are on the same
+* filesystem, or copied in the kernel with copy_file_range() into a mkostemp()
+* file there when they are not, then renamed into place. The temporary name is
+* created by the call that fills it, so no other file can take it in between. Memory use is
+* bounded by _HTTP_BODY_SPOOL_BLOCK_SIZE whatever the size of the body.
+*/
+class HttpBodySpool
+{
+public:
+	HttpBodySpool() noexcept;
+	~HttpBodySpool();
+
+	HttpBodySpool(HttpBodySpool&& other) noexcept;
+	HttpBodySpool& operator=(HttpBodySpool&& other) noexcept;
+
+	HttpBodySpool(const HttpBodySpool&)				= delete;
+	HttpBodySpool& operator=(const HttpBodySpool&)	= delete;
+
+	/**
+	* @brief Creates the spool file
+	*
+	* @param directory The directory the file is created in
+	* @throws std::runtime_error If the file cannot be created
+	*/
+	void open(const std::string& directory);
+
+	/**
+	* @brief Appends bytes at the end of the file
+	*
+	* @throws std::runtime_error If the write fails, e.g. the disk is full
+	*/
+	void write(std::string_view data);
+
+	/**
+	* @brief Closes the file, a named fallback file is removed
+	*/
+	void close() noexcept;
+
+	/**
+	* @brief Reads part of the file, short at the end of the file
+	*
+	* @throws std::runtime_error If the read fails
+	*/
+	[[nodiscard]]
+	std::string read(size_t offset, size_t length) const;
+
+	/**
+	* @brief Publishes the whole file at path, replacing what is there
+	*
+	* The replacement is atomic, concurrent readers never see a partial file.
+	* On failure path is left untouched and the temporary file is removed.
+	*
+	* @throws std::runtime_error If the file can neither be linked nor copied there
+	*/
+	void save_as(const std::string& path) const;
+
+	/**
+	* @brief Copies part of the file at the current offset of another descriptor
+	*
+	* @throws std::runtime_error If the copy fails
+	*/
+	void copy_range_to(int destination_file_descriptor, size_t offset, size_t length) const;
+
+	[[nodiscard]] __attribute__((always_inline))
+	bool is_open() const noexcept
+	{
+		return file_descriptor >= 0;
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	int get_file_descriptor() const noexcept
+	{
+		return file_descriptor;
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	size_t size() const noexcept
+	{
+		return file_size;
+	}
+
+private:
+	int			file_descriptor;
+	size_t		file_size;
+	std::string	file_path;	/* Empty for an O_TMPFILE file */
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+/**
+* @brief Request headers the server reads itself
+*
+* Each of them owns a fixed slot in HttpHeaderTable, so looking one up is
+* an array access instead of a search. Any other header is still stored,
+* in the table's overflow list.
+*/
+enum class HttpHeader : uint8_t
+{
+	HOST,
+	CONNECTION,
+	CONTENT_LENGTH,
+	CONTENT_TYPE,
+	TRANSFER_ENCODING,
+	EXPECT,
+	ACCEPT,
+	ACCEPT_ENCODING,
+	ACCEPT_LANGUAGE,
+	AUTHORIZATION,
+	COOKIE,
+	IF_MODIFIED_SINCE,
+	IF_NONE_MATCH,
+	RANGE,
+	REFERER,
+	USER_AGENT,
+	COUNT
+};
+
+/* Canonical lowercase names, in enum order */
+inline constexpr std::array<std::string_view, static_cast<size_t>(HttpHeader::COUNT)> _HTTP_HEADER_NAMES = {
+	"host",
+	"connection",
+	"content-length",
+	"content-type",
+	"transfer-encoding",
+	"expect",
+	"accept",
+	"accept-encoding",
+	"accept-language",
+	"authorization",
+	"cookie",
+	"if-modified-since",
+	"if-none-match",
+	"range",
+	"referer",
+	"user-agent"
+};
+
+[[nodiscard]] __attribute__((always_inline))
+inline constexpr std::string_view get_http_header_name(const HttpHeader http_header) noexcept
+{
+	return _HTTP_HEADER_NAMES[static_cast<size_t>(http_header)];
+}
+
+[[nodiscard]] __attribute__((always_inline))
+inline constexpr char to_lower_ascii(const char character) noexcept
+{
+	return character >= 'A' && character <= 'Z' ? static_cast<char>(character + ('a' - 'A')) : character;
+}
+
+/* ASCII only, header names and the tokens compared with it never contain anything else */
+[[nodiscard]]
+inline constexpr bool equals_ignore_case_ascii(const std::string_view left, const std::string_view right) noexcept
+{
+	if (left.length() != right.length())
+		return false;
+
+	for (size_t index = 0; index < left.length(); ++index)
+		if (to_lower_ascii(left[index]) != to_lower_ascii(right[index]))
+			return false;
+
+	return true;
+}
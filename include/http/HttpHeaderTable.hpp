@@ -0,0 +1,180 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+#include "http/HttpHeader.hpp"
+
+/**
+* @brief Header fields of one request, stored as positions in its receive buffer
+*
+* Nothing is copied: a field is the offset and length of its name and value
+* inside the buffer the request was parsed from. Offsets are kept instead of
+* pointers because that buffer still grows (and may reallocate) while the
+* body arrives, and because the owning request is moved around by the
+* connection table. Views are rebuilt from the buffer on every lookup,
+* which is why each accessor takes it as its first argument.
+*
+* Headers listed in HttpHeader land in a fixed slot indexed by the enum,
+* every other one in a small flat vector that keeps its capacity across
+* clear(), so a persistent connection stops allocating after its first request.
+* Names are matched case-insensitively. A known header that arrives again keeps
+* its last value and is flagged, so the request can tell a list split over
+* several lines (Transfer-Encoding) or two different values for a single
+* valued field (Content-Length) from a header that was sent once.
+*/
+class HttpHeaderTable
+{
+public:
+	HttpHeaderTable() noexcept;
+
+	/**
+	* @brief Maps a header name to its fixed slot
+	*
+	* @param name The header name, in any case
+	* @return HttpHeader The matching known header, HttpHeader::COUNT for any other name
+	*/
+	[[nodiscard]]
+	static HttpHeader get_known_http_header(std::string_view name) noexcept;
+
+	/**
+	* @brief Records a header field
+	*
+	* A repeated known header replaces the previous value and is marked
+	* as repeated, and also as conflicting when the two values differ.
+	*
+	* @param buffer The buffer the request is parsed from
+	* @param name The header name, a view into buffer
+	* @param value The trimmed header value, a view into buffer
+	*/
+	void insert(std::string_view buffer, std::string_view name, std::string_view value);
+
+	/**
+	* @brief Gets the value of a known header
+	*
+	* @return std::string_view A view into buffer, empty if the header is absent
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	std::string_view find(const std::string_view buffer, const HttpHeader http_header) const noexcept
+	{
+		return contains(http_header)
+			? get_view(buffer, known_header_values[static_cast<size_t>(http_header)])
+			: std::string_view();
+	}
+
+	/**
+	* @brief Gets the value of any header, known or not
+	*
+	* @return std::string_view A view into buffer, empty if the header is absent
+	*/
+	[[nodiscard]]
+	std::string_view find(std::string_view buffer, std::string_view name) const noexcept;
+
+	[[nodiscard]] __attribute__((always_inline))
+	bool contains(const HttpHeader http_header) const noexcept
+	{
+		return known_header_mask & (uint32_t(1) << static_cast<unsigned>(http_header));
+	}
+
+	[[nodiscard]]
+	bool contains(std::string_view buffer, std::string_view name) const noexcept;
+
+	/**
+	* @brief Tells whether a known header was sent on more than one line
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	bool is_repeated(const HttpHeader http_header) const noexcept
+	{
+		return repeated_header_mask & (uint32_t(1) << static_cast<unsigned>(http_header));
+	}
+
+	/**
+	* @brief Tells whether two lines of a known header carried different values
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	bool is_conflicting(const HttpHeader http_header) const noexcept
+	{
+		return conflicting_header_mask & (uint32_t(1) << static_cast<unsigned>(http_header));
+	}
+
+	/**
+	* @brief Calls visitor(name, value) for every header
+	*
+	* Known headers come first, under their canonical lowercase name, then the
+	* other ones in arrival order, under the name the client sent.
+	*/
+	template <typename Visitor>
+	void for_each(const std::string_view buffer, Visitor&& visitor) const
+	{
+		for (size_t index = 0; index < known_header_values.size(); ++index)
+			if (contains(static_cast<HttpHeader>(index)))
+				visitor(_HTTP_HEADER_NAMES[index], get_view(buffer, known_header_values[index]));
+
+		for (const HttpHeaderField& other_header_field : other_header_fields)
+			visitor(get_view(buffer, other_header_field.name), get_view(buffer, other_header_field.value));
+	}
+
+	/**
+	* @brief Forgets every header, the overflow vector keeps its capacity
+	*/
+	__attribute__((always_inline))
+	void clear() noexcept
+	{
+		known_header_mask		= 0;
+		repeated_header_mask	= 0;
+		conflicting_header_mask	= 0;
+		other_header_fields.clear();
+	}
+
+private:
+	static_assert(static_cast<size_t>(HttpHeader::COUNT) <= 32, "the header masks hold one bit per known header");
+
+	/* 32 bits each, the header block of a request is far below 4 GiB */
+	struct HttpHeaderSpan
+	{
+		uint32_t	offset = 0;
+		uint32_t	length = 0;
+	};
+
+	struct HttpHeaderField
+	{
+		HttpHeaderSpan	name;
+		HttpHeaderSpan	value;
+	};
+
+	std::array<HttpHeaderSpan, static_cast<size_t>(HttpHeader::COUNT)>	known_header_values;
+	uint32_t															known_header_mask;
+	uint32_t															repeated_header_mask;
+	uint32_t															conflicting_header_mask;
+	std::vector<HttpHeaderField>										other_header_fields;
+
+	[[nodiscard]] __attribute__((always_inline))
+	static HttpHeaderSpan get_span(const std::string_view buffer, const std::string_view part) noexcept
+	{
+		/* An empty value may not point into the buffer at all, e.g. a trimmed "Host: " */
+		if (part.empty())
+			return {};
+
+		return {
+			static_cast<uint32_t>(part.data() - buffer.data()),
+			static_cast<uint32_t>(part.length())
+		};
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	static std::string_view get_view(const std::string_view buffer, const HttpHeaderSpan span) noexcept
+	{
+		return buffer.substr(span.offset, span.length);
+	}
+
+	/**
+	* @brief Finds the last overflow field with this name
+	*
+	* @return HttpHeaderField* The field, nullptr if there is none
+	*/
+	[[nodiscard]]
+	const HttpHeaderField* find_other_header_field(std::string_view buffer, std::string_view name) const noexcept;
+};
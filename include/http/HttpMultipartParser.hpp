@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+#include "http/HttpBodySpool.hpp"
+
+#define _MAX_MULTIPART_BOUNDARY_LENGTH		70		/* RFC 2046 section 5.1.1 */
+#define _MAX_MULTIPART_PART_HEADER_LENGTH	8192	/* Header block of one part */
+#define _MAX_MULTIPART_PART_COUNT			1024
+
+/**
+* @brief Where the multipart parser currently is, it resumes there on the next read
+*/
+enum class HttpMultipartParseState : uint8_t
+{
+	PREAMBLE,		/* Before the first delimiter, ignored */
+	DELIMITER_END,	/* After a delimiter, "--" closes the body, a line ending starts a part */
+	PART_HEADERS,
+	PART_DATA,
+	EPILOGUE,		/* After the closing delimiter, ignored up to the line feed */
+	COMPLETE
+};
+
+/**
+* @brief One part of a multipart/form-data body
+*
+* The content stays in memory while every part of the request fits in the
+* body buffer, the parts that do not are written to their own spool file.
+*/
+struct HttpMultipartPart
+{
+	std::string		name;
+	std::string		filename;		/* Empty for a plain form field */
+	std::string		content_type;
+	std::string		content;		/* The content while it fits in memory */
+	HttpBodySpool	content_spool;	/* The content once it did not */
+
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_content_length() const noexcept
+	{
+		return content_spool.is_open() ? content_spool.size() : content.length();
+	}
+};
+
+/**
+* @brief Splits a multipart/form-data body into its parts as the body arrives
+*
+* Delimiters are found with Boyer-Moore-Horspool, the bytes at the end of a
+* read that could start a delimiter are held back until the next read
+* decides, so a delimiter cut anywhere by the network is still found and
+* no byte of content is ever scanned twice.
+*/
+class HttpMultipartParser
+{
+public:
+	HttpMultipartParser();
+
+	/**
+	* @brief Prepares the parser for a new body
+	*
+	* @param boundary The boundary parameter of the Content-Type header
+	* @param memory_limit Bytes of content kept in memory across all parts
+	* @param temp_path Directory of the spool files, empty to keep everything in memory
+	* @throws HttpRequestError 400 If the boundary is empty or too long
+	*/
+	void start(std::string_view boundary, size_t memory_limit, std::string_view temp_path);
+
+	/**
+	* @brief Forgets the body and its parts, spool files included
+	*/
+	void reset() noexcept;
+
+	/**
+	* @brief Parses the next bytes of the body
+	*
+	* @return size_t The bytes consumed, less than given once the closing delimiter line is complete
+	* @throws HttpRequestError 400 If the body is not valid multipart, 413 if it has too many parts,
+	*         500 if a spool file cannot be written
+	*/
+	size_t feed(std::string_view data);
+
+	[[nodiscard]] __attribute__((always_inline))
+	bool is_started() const noexcept
+	{
+		return !delimiter.empty();
+	}
+
+	/**
+	* @brief Whether the closing delimiter was seen, the epilogue may still be pending
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	bool has_closing_delimiter() const noexcept
+	{
+		return multipart_parse_state >= HttpMultipartParseState::EPILOGUE;
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	bool is_complete() const noexcept
+	{
+		return multipart_parse_state == HttpMultipartParseState::COMPLETE;
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	const std::vector<HttpMultipartPart>& get_parts() const noexcept
+	{
+		return parts;
+	}
+
+private:
+	std::string							delimiter;				/* "\r\n--" followed by the boundary */
+	std::array<uint8_t, 256>			delimiter_skip_table;
+	std::string							delimiter_lookbehind;	/* End of the previous read that may start a delimiter */
+	std::string							delimiter_window;		/* Held back bytes followed by the start of the next read */
+	HttpMultipartParseState				multipart_parse_state;
+	bool								has_delimiter_dash;		/* First '-' of a closing delimiter seen */
+	std::string							part_header_line;
+	size_t								part_header_length;
+	size_t								memory_limit;
+	size_t								memory_length;
+	std::string_view					temp_path;
+	std::vector<HttpMultipartPart>		parts;
+
+	/**
+	* @brief Boyer-Moore-Horspool search for the delimiter
+	*
+	* @return size_t The position of the first match, std::string_view::npos if there is none
+	*/
+	[[nodiscard]]
+	size_t find_delimiter(std::string_view data) const noexcept;
+
+	/**
+	* @brief Passes content on up to the next delimiter, the preamble is dropped
+	*
+	* @return size_t The bytes consumed, the delimiter included when it was found
+	*/
+	size_t consume_content(std::string_view data);
+
+	void append_content(std::string_view content);
+	void start_part();
+	void parse_part_header_line(std::string_view line);
+};
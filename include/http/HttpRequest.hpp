@@ -1,12 +1,47 @@
 #pragma once
 
-#include <map>
 #include <string>
 #include <memory>
-#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
 #include <unordered_map>
 
 #include "http/HttpMethod.hpp"
+#include "http/HttpBodySpool.hpp"
+#include "http/HttpRequestError.hpp"
+#include "http/HttpMultipartParser.hpp"
+#include "http/HttpHeaderTable.hpp"
+
+#define _MAX_HTTP_REQUEST_LINE_LENGTH	8192	/* Request line, refused with 414 beyond */
+#define _MAX_HTTP_REQUEST_HEADER_SIZE	32768	/* Header block after the request line, refused with 431 beyond */
+#define _MAX_HTTP_REQUEST_HEADER_COUNT	128
+
+/**
+* @brief Where the incremental parser of a request currently is
+*/
+enum class HttpRequestParseState : uint8_t
+{
+	REQUEST_LINE,
+	HEADERS,
+	BODY,		/* Header block parsed, waiting for the end of the body */
+	COMPLETE
+};
+
+#define _MAX_HTTP_CHUNK_LINE_LENGTH	4096	/* Chunk size line with its extensions, or one trailer field */
+
+/**
+* @brief Where the chunked body decoder currently is, it resumes there on the next read
+*/
+enum class HttpChunkParseState : uint8_t
+{
+	SIZE,		/* Hexadecimal digits of the chunk size */
+	EXTENSION,	/* Chunk extensions after the size, ignored up to the line feed */
+	DATA,
+	DATA_END,	/* Line ending after the chunk data */
+	TRAILER		/* Trailer fields after the last chunk, ignored up to an empty line */
+};
+
 
 class HttpRequest
 {
@@ -30,18 +65,62 @@ public:
 	* This method handles the incremental parsing of HTTP requests, which can arrive in multiple chunks.
 	* It manages different types of requests (GET, POST, multipart) and checks for complete request assembly.
 	*
-	* The method does several key things:
-	* - Initializes a file descriptor manager if not already created
+	* The parser is a state machine that resumes where the previous call stopped:
 	* - Accumulates incoming request data
-	* - Parses request headers when they are complete
-	* - Handles different request types (multipart, content-length)
-	* - Determines when a complete request has been received
+	* - Parses the request line and every header line as soon as its line feed arrives,
+	*   in place, only the bytes received since the last call are searched
+	* - Handles different request types (chunked, content-length, multipart)
+	* - Bodies go straight to the body as they arrive, chunked ones decoded on the fly and
+	*   multipart ones split into their parts, only the header block is kept in the receive buffer
+	* - Determines when a complete request has been received and where it ends,
+	*   bytes past that point are kept for take_pipelined_http_request_data()
+	*
+	* The cost of a request is therefore linear in its size, however it is split across reads.
 	*
 	* @param data The incoming chunk of HTTP request data
 	* @return bool Indicates whether the request is fully parsed and complete
+	* Limits are enforced as soon as the bytes that break them arrive: the request line (414),
+	* the header block and its field count (431), and the announced Content-Length (413), so
+	* an oversized request is refused before its body is read.
+	*
+	* @throws HttpRequestError If the path, the framing or the multipart body is malformed (400), the body
+	*         outgrows the body size limit (413), the request line is too long (414), the header
+	*         block is too large (431), the Expect header is not 100-continue (417) or the
+	*         transfer coding is not supported (501)
+	* @throws std::runtime_error If the request line or the Content-Length header is malformed
 	*/
 	bool process_incoming_http_request(const std::string& data);
 
+	/**
+	* @brief Sets the largest body a request may have
+	*
+	* Kept across reset_http_request(), every request of the connection shares it.
+	*
+	* @param max_body_size Limit for every method, client_max_body_size
+	* @param max_post_body_size Tighter limit for POST requests, client_max_post_request_size
+	*/
+	__attribute__((always_inline))
+	void set_http_request_max_body_size(const size_t max_body_size, const size_t max_post_body_size) noexcept
+	{
+		http_request_max_body_size		= max_body_size;
+		http_request_max_post_body_size	= max_post_body_size;
+	}
+
+	/**
+	* @brief Sets when a body, or the parts of a multipart one, move from memory to spool files
+	*
+	* Kept across reset_http_request(). Without a directory bodies always stay in memory.
+	*
+	* @param body_buffer_size Bodies up to this size stay in memory, client_body_buffer_size
+	* @param body_temp_path Where spool files are created, client_body_temp_path, must outlive the request
+	*/
+	__attribute__((always_inline))
+	void set_http_request_body_spooling(const size_t body_buffer_size, const std::string_view body_temp_path) noexcept
+	{
+		http_request_body_buffer_size	= body_buffer_size;
+		http_request_body_temp_path		= body_temp_path;
+	}
+
 	/**
 	* @brief Retrieves the HTTP request method.
 	*
@@ -64,6 +143,19 @@ public:
 		return http_request_url;
 	}
 
+	/**
+	* @brief Retrieves the decoded and normalized path of the URL
+	*
+	* No query, no `.` or `..` segments, no empty segments, see HttpUrl.
+	*
+	* @return const std::string& The path routes and files are looked up with
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	const std::string& get_http_request_path() const noexcept
+	{
+		return http_request_path;
+	}
+
 	/**
 	* @brief Retrieves the HTTP protocol version.
 	*
@@ -75,31 +167,61 @@ public:
 		return http_request_version;
 	}
 
+	/**
+	 * @brief Retrieves the value of a header the server knows, without searching.
+	 *
+	 * @param http_header The header to retrieve
+	 * @return std::string_view The value, a view into the request buffer valid until
+	 *         the next call that changes the request, empty if the header is absent
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	std::string_view get_http_request_header(const HttpHeader http_header) const noexcept
+	{
+		return http_request_headers.find(raw_http_request_data, http_header);
+	}
+
 	/**
 	 * @brief Retrieves the value of a specific HTTP request header.
 	 *
-	 * Searches for the header in a case-insensitive manner. If the header is not found,
-	 * returns an empty string.
+	 * Searches for the header in a case-insensitive manner, known headers
+	 * are found in their slot whatever the case of the key.
 	 *
 	 * @param key The name of the header to retrieve
-	 * @return std::string The value of the header, or an empty string if not found
+	 * @return std::string_view The value, a view into the request buffer, empty if not found
 	 */
-	[[nodiscard]]
-	std::string get_http_request_header(const std::string& key) const;
+	[[nodiscard]] __attribute__((always_inline))
+	std::string_view get_http_request_header(const std::string_view key) const noexcept
+	{
+		return http_request_headers.find(raw_http_request_data, key);
+	}
 
 	/**
-	 * @brief Retrieves all HTTP request headers.
+	 * @brief Calls visitor(name, value) with string_views for every HTTP request header.
 	 *
-	 * @return const std::map<std::string, std::string>& A map of header keys and values
+	 * Known headers come first under their lowercase name, the others keep the case the client sent.
 	 */
+	template <typename Visitor>
+	void for_each_http_request_header(Visitor&& visitor) const
+	{
+		http_request_headers.for_each(raw_http_request_data, std::forward<Visitor>(visitor));
+	}
+
+	/**
+	* @brief Retrieves the Content-Length of the request, parsed once with the header block.
+	*
+	* @return size_t The announced body size, 0 without a Content-Length header
+	*/
 	[[nodiscard]] __attribute__((always_inline))
-	const std::map<std::string, std::string>& get_http_request_headers() const
+	size_t get_http_request_content_length() const noexcept
 	{
-		return http_request_headers;
+		return http_request_content_length;
 	}
 
 	/**
-	* @brief Retrieves the body of the HTTP request.
+	* @brief Retrieves the body of the HTTP request when it was kept in memory.
+	*
+	* Empty when the body was spooled, see is_http_request_body_spooled(), and for
+	* multipart requests, whose body is split into get_http_request_multipart_parts().
 	*
 	* @return const std::string& The request body content
 	*/
@@ -109,6 +231,50 @@ public:
 		return http_request_body;
 	}
 
+	/**
+	* @brief Checks whether the body went to a spool file instead of memory.
+	*
+	* @return bool True if the body is in get_http_request_body_spool()
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	bool is_http_request_body_spooled() const noexcept
+	{
+		return http_request_body_spool.is_open();
+	}
+
+	/**
+	* @brief Retrieves the spool file holding a body larger than client_body_buffer_size.
+	*
+	* @return const HttpBodySpool& The spool, open only if the body was spooled
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	const HttpBodySpool& get_http_request_body_spool() const noexcept
+	{
+		return http_request_body_spool;
+	}
+
+	/**
+	* @brief Retrieves the size of the decoded body, in memory, spooled or split into parts.
+	*
+	* @return size_t The body size in bytes
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_http_request_body_length() const noexcept
+	{
+		return http_request_body_length;
+	}
+
+	/**
+	* @brief Retrieves the parts of a multipart/form-data body, in the order they were sent.
+	*
+	* @return const std::vector<HttpMultipartPart>& The parts, empty for other requests
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	const std::vector<HttpMultipartPart>& get_http_request_multipart_parts() const noexcept
+	{
+		return http_request_multipart_parser.get_parts();
+	}
+
 	/**
 	* @brief Retrieves the boundary marker for multipart requests.
 	*
@@ -127,7 +293,39 @@ public:
 	*/
 	[[nodiscard]] bool is_http_request_complete_check() const noexcept
 	{
-		return is_http_request_complete;
+		return http_request_parse_state == HttpRequestParseState::COMPLETE;
+	}
+
+	/**
+	* @brief Checks if the request line and all headers have been received.
+	*
+	* @return bool True once the empty line ending the header block has been parsed
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	bool are_http_request_headers_complete() const noexcept
+	{
+		return http_request_parse_state >= HttpRequestParseState::BODY;
+	}
+
+	/**
+	* @brief Tells, once per request, whether the client waits for 100 Continue before sending the body
+	*
+	* True the first time it is called after the header block of an HTTP/1.1 request
+	* with Expect: 100-continue was parsed, as long as none of the body has arrived yet.
+	* A client that did not wait needs no answer, RFC 9110 section 10.1.1.
+	*
+	* @return bool True if the caller must now answer with 100 Continue or a final response
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	bool take_http_request_continue_expectation() noexcept
+	{
+		const bool is_continue_expected = is_http_request_continue_expected
+										&& http_request_parse_state == HttpRequestParseState::BODY
+										&& !http_request_body_length;
+
+		is_http_request_continue_expected = false;
+
+		return is_continue_expected;
 	}
 
 	/**
@@ -140,6 +338,18 @@ public:
 		return is_http_request_multipart;
 	}
 
+	/**
+	 * @brief Determines whether a header the server knows is present in the HTTP request.
+	 *
+	 * @param http_header The header to look for in the request
+	 * @return bool Indicates the presence of the header
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	bool has_http_request_header(const HttpHeader http_header) const noexcept
+	{
+		return http_request_headers.contains(http_header);
+	}
+
 	/**
 	 * @brief Determines whether a specific header is present in the HTTP request.
 	 *
@@ -148,23 +358,186 @@ public:
 	 * @param key The header to look for in the request
 	 * @return bool Indicates the presence of the header
 	 */
-	[[nodiscard]] bool has_http_request_header(const std::string& key) const;
+	[[nodiscard]] __attribute__((always_inline))
+	bool has_http_request_header(const std::string_view key) const noexcept
+	{
+		return http_request_headers.contains(raw_http_request_data, key);
+	}
+
+	/**
+	 * @brief Determines whether the client wants the connection to stay open after the response.
+	 *
+	 * Follows the persistent connection rules of RFC 9112:
+	 * - HTTP/1.1 connections are persistent unless the Connection header contains "close"
+	 * - HTTP/1.0 connections are persistent only if the Connection header contains "keep-alive"
+	 *
+	 * @return bool True if the connection may be reused for another request
+	 */
+	[[nodiscard]] bool is_keep_alive_requested() const;
+
+	/**
+	 * @brief Checks whether any bytes of a request have been received yet.
+	 *
+	 * @return bool True if request data is buffered, false for an idle connection
+	 */
+	[[nodiscard]] __attribute__((always_inline))
+	bool has_http_request_data() const noexcept
+	{
+		return !raw_http_request_data.empty();
+	}
+
+	/**
+	 * @brief Resets the request to its initial state so the connection can parse the next one.
+	 *
+	 * Equivalent to assigning a fresh HttpRequest, but the string buffers keep
+	 * their capacity, so a persistent connection does not reallocate them for every request.
+	 */
+	void reset_http_request();
+
+	/**
+	 * @brief Removes and returns the bytes received after the end of the complete request.
+	 *
+	 * Pipelining clients send several requests back to back, so a single read
+	 * may contain the start (or all) of the following requests. They are handed
+	 * back to the caller, which feeds them to the connection's next request.
+	 *
+	 * @return std::string The surplus bytes, empty if there are none or the request is incomplete
+	 */
+	[[nodiscard]] std::string take_pipelined_http_request_data();
 
 private:
 	HttpMethod	http_request_method;
 
 	std::string	http_request_url;
+	std::string	http_request_path;		/* Decoded in place, keeps its capacity across requests */
 	std::string	http_request_version;
 	std::string	http_request_body;
 	std::string	raw_http_request_data;
 	std::string	http_request_boundary;
 
-	bool		is_http_request_complete;
-	bool		are_http_headers_complete;
-	bool		is_http_request_multipart;
-	size_t		http_request_body_start_index;
+	HttpRequestParseState	http_request_parse_state;
+	bool					is_http_request_multipart;
+	bool					has_http_request_content_length;
+	bool					is_http_request_chunked;
+	bool					is_http_request_continue_expected;	/* Expect: 100-continue not answered yet */
+	bool					has_http_request_chunk_size_digits;
+	HttpChunkParseState		http_request_chunk_parse_state;
+	size_t					http_request_chunk_remaining;		/* Data bytes of the current chunk still expected */
+	size_t					http_request_chunk_line_length;		/* Bytes of the current size or trailer line */
+	size_t					http_request_max_body_size;
+	size_t					http_request_max_post_body_size;
+	size_t					http_request_body_buffer_size;
+	std::string_view		http_request_body_temp_path;	/* Points into the server configuration */
+	HttpBodySpool			http_request_body_spool;
+	HttpMultipartParser		http_request_multipart_parser;
+	size_t					http_request_body_length;		/* Body bytes received, after chunked decoding */
+	size_t					http_request_parse_position;	/* Start of the first line not parsed yet */
+	size_t					http_request_scan_position;		/* Where the next search resumes */
+	size_t					http_request_colon_position;	/* First colon of the header line being scanned, npos until found */
+	size_t					http_request_headers_start_index;
+	size_t					http_request_header_count;
+	size_t					http_request_body_start_index;
+	size_t					http_request_content_length;
+	size_t					http_request_message_length;
+
+	HttpHeaderTable	http_request_headers;	/* Positions in raw_http_request_data, nothing is copied */
+
+	/**
+	* @brief Parses every complete line of the request line and header block received so far
+	*
+	* Lines may end with CRLF or a bare LF. The line feed search starts at
+	* http_request_scan_position, so bytes are never searched twice. Header
+	* lines are scanned with HttpScanner, which finds the line feed and the
+	* colon in the same vectorized pass.
+	*
+	* @return bool True once the empty line ending the header block was parsed
+	* @throws std::runtime_error If the request line is invalid
+	*/
+	bool parse_http_request_head();
+
+	/**
+	* @brief Decides how the end of the body is found once the header block is complete
+	*
+	* Content-Length is parsed once, strictly (digits only), instead of on every read,
+	* and checked against the body size limit before any of the body is read.
+	*
+	* @throws HttpRequestError 413 If Content-Length exceeds the body size limit
+	* @throws std::runtime_error If the Content-Length header is not a number
+	*/
+	void finish_http_request_head();
+
+	/**
+	* @brief The body size limit of this request's method
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_http_request_max_body_size() const noexcept
+	{
+		return http_request_method == HttpMethod::POST
+			? std::min(http_request_max_body_size, http_request_max_post_body_size)
+			: http_request_max_body_size;
+	}
+
+	/**
+	* @brief Refuses a request line or header block that outgrew its limit before it ends
+	*
+	* @param scanned_end Index of the line feed ending the current line, or of the end of the buffer
+	* @throws HttpRequestError 414 or 431
+	*/
+	void check_http_request_head_length(size_t scanned_end) const;
+
+	/**
+	* @brief Whether the request has a body, consumed as it arrives instead of buffered with the head
+	*
+	* Multipart requests without Content-Length or chunked framing end with their closing delimiter.
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	bool is_http_request_body_streamed() const noexcept
+	{
+		return is_http_request_chunked || has_http_request_content_length || http_request_multipart_parser.is_started();
+	}
+
+	/**
+	* @brief Feeds received bytes to the chunked decoder, the Content-Length counter or the multipart parser
+	*
+	* Stops at the end of the message, the request is then complete.
+	*
+	* @param data Bytes received after everything consumed so far
+	* @return size_t How many of them belong to this request, the rest is pipelined
+	* @throws HttpRequestError If the chunked framing is invalid or the body grows too large
+	*/
+	size_t consume_http_request_body(std::string_view data);
+
+	/**
+	* @brief Decodes chunked framing, resuming in the state the previous read left it
+	*
+	* Chunk data is handed to the body in bulk, only the framing is walked byte by byte.
+	* client_max_body_size is checked as soon as a chunk announces its size.
+	*/
+	size_t decode_http_request_chunks(std::string_view data);
+
+	/**
+	* @brief Checks the size line of a chunk once its line feed has arrived
+	*/
+	void finish_http_request_chunk_size_line();
 
-	std::map<std::string, std::string> http_request_headers;
+	/**
+	* @brief Marks the request complete once its framing says the body has ended
+	*
+	* @throws HttpRequestError 400 If a multipart body ended before its closing delimiter
+	*/
+	void finish_http_request_body();
+
+	/**
+	* @brief The body sink, every decoded or counted body byte goes through it
+	*
+	* Bytes are appended in memory until the body would outgrow client_body_buffer_size,
+	* the body collected so far then moves to a spool file and the rest follows it there.
+	* Multipart bodies go to the multipart parser instead, which does the same per part.
+	*
+	* @throws HttpRequestError If the spool file cannot be created or written (500),
+	*         or the multipart body is invalid (400)
+	*/
+	void append_http_request_body(std::string_view data);
 
 	/**
 	* @brief Parses the first line of an HTTP request to extract its method, URL, and version.
@@ -174,31 +547,29 @@ private:
 	*
 	* It does several important tasks:
 	* - Extracts the HTTP method (GET, POST, DELETE)
-	* - Captures the request URL
+	* - Captures the request URL, and its path decoded and normalized
 	* - Validates the HTTP protocol version
 	*
 	* Throws an exception if the request line is malformed or uses an unsupported HTTP version.
 	*
-	* @param line The first line of the HTTP request
+	* @param line The first line of the HTTP request, without its line ending
+	* @throws HttpRequestError 400 If the path is malformed or climbs above the root
 	* @throws std::runtime_error If the request line is invalid or uses an unsupported HTTP version
 	*/
-	void parse_http_request_line(const std::string& line);
+	void parse_http_request_line(std::string_view line);
 
 	/**
-	* @brief Parses the headers of an HTTP request from a stream.
+	* @brief Parses one header line of an HTTP request.
 	*
-	* This method processes each line of HTTP headers, extracting key-value pairs.
-	* It performs several important tasks:
-	* - Removes carriage return characters
-	* - Skips empty lines
-	* - Splits each header line into a key and value
-	* - Trims whitespace from the header value
-	* - Converts header keys to lowercase for case-insensitive matching
-	* - Stores the headers in an internal map
+	* - Splits the line into a key and value at the colon found by the scanner
+	* - Trims spaces and tabs around the value
+	* - Records both as positions in the request buffer, nothing is copied or lowercased,
+	*   a repeated header replaces the previous value
 	*
-	* @param http_request_stream A stream containing the HTTP request headers
+	* @param line The header line, without its line ending
+	* @param colon_position Index of the first colon in the line
 	*/
-	void parse_http_request_headers(std::istringstream& http_request_stream);
+	void parse_http_request_header_line(std::string_view line, size_t colon_position);
 
 	/**
 	 * @brief Looks for the boundary marker in a multipart request's Content-Type header.
@@ -206,10 +577,28 @@ private:
 	 * When sending files through a web form, requests can be "multipart" which means they contain multiple pieces of data.
 	 * This method checks if the Content-Type header includes a special "boundary" text that helps separate these different pieces.
 	 *
-	 * If it finds the boundary, the method saves this marker and indicates that the request contains multiple parts.
+	 * If it finds the boundary, the method saves this marker, without the quotes it may have,
+	 * and indicates that the request contains multiple parts.
 	 * This is useful for correctly processing forms that upload files or send complex data.
 	 *
 	 * @param http_request_content_type The header that might contain the boundary information
 	 */
-	void parse_http_request_multipart_header(const std::string& http_request_content_type);
+	void parse_http_request_multipart_header(std::string_view http_request_content_type);
+
+	/**
+	* @brief Reads the Expect header, 100-continue is the only expectation defined
+	*
+	* Ignored for HTTP/1.0 requests, which cannot receive an interim response.
+	*
+	* @throws HttpRequestError 417 If another expectation is asked for
+	*/
+	void parse_http_request_expectation();
+
+	/**
+	* @brief Decides from Transfer-Encoding whether the body is chunked
+	*
+	* @throws HttpRequestError If chunked is not the final coding (400), if another coding
+	*         is applied (501) or if Content-Length is also present (400)
+	*/
+	void parse_http_request_transfer_encoding();
 };
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <stdexcept>
+
+#include "http/HttpStatusCode.hpp"
+
+/**
+* @brief A request the parser rejects, with the status code the client should receive
+*/
+class HttpRequestError : public std::runtime_error
+{
+public:
+	HttpRequestError(const HttpStatusCode status_code, const std::string& message)
+		:	std::runtime_error(message),
+			http_status_code(status_code)
+	{
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	HttpStatusCode get_http_status_code() const noexcept
+	{
+		return http_status_code;
+	}
+
+private:
+	HttpStatusCode http_status_code;
+};
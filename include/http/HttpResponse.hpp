@@ -1,10 +1,178 @@
 #pragma once
 
 #include <map>
+#include <ctime>
+#include <memory>
 #include <string>
+#include <vector>
+#include <utility>
+#include <unistd.h>
+#include <string_view>
 
 #include "http/HttpStatusCode.hpp"
 
+/**
+* @brief An open file a response body is sent from
+*
+* Shared by the segments sending it, the descriptor is closed once the
+* last of them is gone, whether it was sent or the connection dropped.
+*/
+class HttpResponseFile
+{
+public:
+	explicit HttpResponseFile(const int descriptor) noexcept
+		:	file_descriptor(descriptor)
+	{
+	}
+
+	~HttpResponseFile()
+	{
+		close(file_descriptor);
+	}
+
+	HttpResponseFile(const HttpResponseFile&)				= delete;
+	HttpResponseFile& operator=(const HttpResponseFile&)	= delete;
+
+	[[nodiscard]] __attribute__((always_inline))
+	int get_file_descriptor() const noexcept
+	{
+		return file_descriptor;
+	}
+
+private:
+	const int file_descriptor;
+};
+
+/**
+* @brief A run of response bytes waiting for the socket
+*
+* Either owns its bytes (a serialized header block, a body moved out of
+* its response), points at storage that outlives the program, like the
+* built-in error pages, shares bytes held by the content cache, or is a
+* range of an open file, sent by the kernel with sendfile(). None of them
+* is copied on the way to the socket.
+*/
+class HttpResponseSegment
+{
+public:
+	explicit HttpResponseSegment(std::string bytes) noexcept
+		:	owned_bytes(std::move(bytes)),
+			is_static(false)
+	{
+	}
+
+	explicit HttpResponseSegment(const std::string_view bytes) noexcept
+		:	static_bytes(bytes),
+			is_static(true)
+	{
+	}
+
+	/* The bytes stay alive while queued, even if the cache drops them meanwhile */
+	explicit HttpResponseSegment(std::shared_ptr<const std::string> bytes) noexcept
+		:	static_bytes(*bytes),
+			is_static(true),
+			shared_bytes(std::move(bytes))
+	{
+	}
+
+	HttpResponseSegment(std::shared_ptr<const HttpResponseFile> response_file, const size_t offset, const size_t length) noexcept
+		:	is_static(false),
+			file(std::move(response_file)),
+			file_offset(offset),
+			file_length(length)
+	{
+	}
+
+	/**
+	* @brief The bytes of a memory segment, empty for a file segment
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	std::string_view get_bytes() const noexcept
+	{
+		return is_static ? static_bytes : std::string_view(owned_bytes);
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	bool is_file() const noexcept
+	{
+		return file != nullptr;
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_length() const noexcept
+	{
+		return file ? file_length : get_bytes().length();
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	int get_file_descriptor() const noexcept
+	{
+		return file->get_file_descriptor();
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_file_offset() const noexcept
+	{
+		return file_offset;
+	}
+
+private:
+	std::string								owned_bytes;
+	std::string_view						static_bytes;
+	bool									is_static;
+	std::shared_ptr<const std::string>		shared_bytes;	/* Owner of static_bytes when they come from the cache */
+	std::shared_ptr<const HttpResponseFile>	file;
+	size_t									file_offset = 0;
+	size_t									file_length = 0;
+};
+
+/**
+* @brief The headers every response of a worker carries, serialized once per second
+*
+* Date, Server, Connection and, on persistent connections, Keep-Alive
+* depend only on the clock and the configuration. Each worker keeps them
+* as two ready blocks, one for keep-alive and one for close. A response
+* appends the right one to its head as is. Date only changes once per
+* second, so the worker calls refresh() once per event loop iteration and
+* the block is reformatted only when the second has changed.
+*/
+class HttpResponseDefaultHeaders
+{
+public:
+	HttpResponseDefaultHeaders();
+
+	/**
+	* @brief Sets the timeout announced by the Keep-Alive header
+	*
+	* @param keepalive_timeout_seconds The keep-alive timeout of the server
+	*/
+	void set_keepalive_timeout(size_t keepalive_timeout_seconds);
+
+	/**
+	* @brief Formats the blocks again when the second has changed since the last call
+	*/
+	void refresh();
+
+	/**
+	* @brief Gets the default headers of a response, each line ending with CRLF
+	*
+	* @param keep_connection_alive Whether the connection stays open after the response
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	std::string_view get_http_response_default_headers(const bool keep_connection_alive) const noexcept
+	{
+		return keep_connection_alive ? keep_alive_headers : close_headers;
+	}
+
+private:
+	std::time_t	formatted_time = -1;
+	std::string	keep_alive_line;	/* "Keep-Alive: timeout=N" and its CRLF */
+	std::string	keep_alive_headers;
+	std::string	close_headers;
+
+	void format_http_response_default_headers();
+};
+
 class HttpResponse
 {
 public:
@@ -13,7 +181,9 @@ public:
 	*
 	* - Sets HTTP version to 1.1
 	* - Sets status code to 200 OK
-	* - Adds basic response headers
+	*
+	* Date, Server and Connection are not kept per response, they come from
+	* the worker's HttpResponseDefaultHeaders when the response is serialized.
 	*/
 	HttpResponse();
 
@@ -22,7 +192,6 @@ public:
 	*
 	* - Sets HTTP version to 1.1
 	* - Sets the given status code
-	* - Adds basic response headers
 	*
 	* @param http_status_code The HTTP status code to use
 	*/
@@ -42,6 +211,9 @@ public:
 	/**
 	* @brief Sets or updates a response header
 	*
+	* Date, Server, Connection and Keep-Alive belong to the server, they are
+	* not sent from here.
+	*
 	* @param key The header name
 	* @param value The header value
 	*/
@@ -54,27 +226,85 @@ public:
 	/**
 	* @brief Sets the response body and updates Content-Length for compile time literals
 	*
-	* @param literal The string literal to send in the response
+	* @param literal The string literal to send in the response, sent from where it is
 	*/
 	template<size_t N>
 	__attribute__((always_inline))
 	void set_http_response_body(const char (&literal)[N])
 	{
-		constexpr size_t length					= N - 1;
-		http_response_body						= literal;
-		http_response_headers["Content-Length"]	= std::to_string(length);
+		set_http_response_static_body(std::string_view(literal, N - 1));
+	}
+
+	/**
+	* @brief Sets a body that lives as long as the program, Content-Length follows it
+	*
+	* @param static_body The content to send, never copied
+	*/
+	__attribute__((always_inline))
+	void set_http_response_static_body(const std::string_view static_body)
+	{
+		http_response_body.clear();
+		http_response_file.reset();
+		http_response_prebuilt_content.reset();
+		http_response_static_body = static_body;
+		http_response_headers.erase("Content-Length");
+	}
+
+	/**
+	* @brief Sets the response body, Content-Length follows it
+	*
+	* @param content The content to send in the response, pass an rvalue to move it in
+	*/
+	__attribute__((always_inline))
+	void set_http_response_body(std::string content)
+	{
+		http_response_body			= std::move(content);
+		http_response_static_body	= {};
+		http_response_file.reset();
+		http_response_prebuilt_content.reset();
+		http_response_headers.erase("Content-Length");
 	}
 
 	/**
-	* @brief Sets the response body and updates Content-Length
+	* @brief Ends the header block with bytes built in advance, the body included
 	*
-	* @param content The content to send in the response
+	* The bytes hold the headers describing the body (Content-Type,
+	* Content-Length), the empty line and the body. They are shared with the
+	* content cache, a hit serializes only the status line and the headers
+	* of this response.
+	*
+	* @param content The prebuilt end of the response
+	*/
+	__attribute__((always_inline))
+	void set_http_response_prebuilt_content(std::shared_ptr<const std::string> content)
+	{
+		http_response_body.clear();
+		http_response_static_body = {};
+		http_response_file.reset();
+		http_response_prebuilt_content = std::move(content);
+		http_response_headers.erase("Content-Type");
+		http_response_headers.erase("Content-Length");
+	}
+
+	/**
+	* @brief Sends a range of an open file as the body, Content-Length follows it
+	*
+	* The file is never read into memory, the kernel copies it to the socket.
+	*
+	* @param file The open file
+	* @param offset Where the body starts in the file
+	* @param length Bytes of the body
 	*/
 	__attribute__((always_inline))
-	void set_http_response_body(const std::string& content)
+	void set_http_response_file_body(std::shared_ptr<const HttpResponseFile> file, const size_t offset, const size_t length)
 	{
-		http_response_body						= content;
-		http_response_headers["Content-Length"]	= std::to_string(content.length());
+		http_response_body.clear();
+		http_response_static_body	= {};
+		http_response_prebuilt_content.reset();
+		http_response_file			= std::move(file);
+		http_response_file_offset	= offset;
+		http_response_file_length	= length;
+		http_response_headers.erase("Content-Length");
 	}
 
 	/**
@@ -89,13 +319,12 @@ public:
 	}
 
 	/**
-	* @brief Removes all headers and adds back the defaults
+	* @brief Removes all headers, the server's defaults are still sent
 	*/
 	__attribute__((always_inline))
-	void clear_http_response_headers()
+	void clear_http_response_headers() noexcept
 	{
 		http_response_headers.clear();
-		add_default_http_response_headers();
 	}
 
 	/**
@@ -110,7 +339,7 @@ public:
 	}
 
 	/**
-	* @brief Sets the Content-Length header
+	* @brief Sets the Content-Length header, overriding the length of the body until the next body is set
 	*
 	* @param length The length value as string
 	*/
@@ -121,30 +350,38 @@ public:
 	}
 
 	/**
-	* @brief Creates the complete HTTP response string
+	* @brief Serializes the response for a gathered send
 	*
-	* - Adds status line
-	* - Adds all headers
-	* - Adds empty line
-	* - Adds body if present
+	* - Builds the status line, the default headers, the headers of the
+	*   response and the empty line into one segment, Content-Length is always
+	*   present when a body is allowed
+	* - Appends the body as a second segment, never for 1xx, 204 and 304 responses
 	*
-	* @return The complete response as string
+	* The body is moved into its segment, points at its static storage, is
+	* shared with the content cache or is a range of its file, it is not
+	* copied. The response has no body left afterwards.
+	*
+	* @param segments Where the segments are appended, in the order they are sent
+	* @param default_headers The worker's serialized default headers, copied in as is
 	*/
-	[[nodiscard]] std::string build_http_response() const;
+	void append_http_response_segments(std::vector<HttpResponseSegment>& segments, std::string_view default_headers);
 
 private:
 	std::map<std::string, std::string> http_response_headers;
 
-	HttpStatusCode	http_response_status_code;
-	std::string		http_response_body;
-	std::string		http_version;
+	HttpStatusCode		http_response_status_code;
+	std::string			http_response_body;
+	std::string_view	http_response_static_body;	/* Used instead of http_response_body when set */
+
+	std::shared_ptr<const HttpResponseFile>	http_response_file;		/* Used instead of both when set */
+	std::shared_ptr<const std::string>		http_response_prebuilt_content;	/* Ends the header block and holds the body when set */
+	size_t									http_response_file_offset = 0;
+	size_t									http_response_file_length = 0;
+	std::string			http_version;
 
 	/**
-	* @brief Adds the basic required headers to the response
-	*
-	* - Adds Server name
-	* - Adds current Date
-	* - Adds Connection type
+	* @brief Whether the status allows a body, 1xx, 204 and 304 never have one (RFC 9110 section 6.4.1)
 	*/
-	void add_default_http_response_headers();
+	[[nodiscard]]
+	bool is_http_response_body_allowed() const noexcept;
 };
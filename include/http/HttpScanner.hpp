@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/* int8 for better portability */
+enum class HttpScannerImplementation : int8_t
+{
+	SCALAR,
+	SSE42,
+	AVX2
+};
+
+/**
+* @brief Finds the end of a header line and the first colon in it
+*
+* @param data The bytes to scan
+* @param length Number of bytes to scan
+* @param colon_position Set to the index of the first colon before the line feed if it is
+*        std::string::npos on entry, left untouched otherwise (the colon of a line split
+*        across reads was already found)
+* @return Index of the first line feed, length if there is none
+*/
+using HttpLineScanner = size_t (*)(const char* data, size_t length, size_t& colon_position) noexcept;
+
+/**
+* @brief Vectorized search for the delimiters of request header lines
+*
+* Every header line needs its line feed and its first colon. Both are
+* found in a single pass, 32 bytes at a time with AVX2 or 16 with SSE4.2,
+* falling back to a byte loop on other CPUs. The implementation is picked
+* once at runtime from what the CPU supports, so the binary does not need
+* to be built for a specific machine.
+*/
+class HttpScanner
+{
+public:
+	/**
+	* @brief Scans a header line with the best implementation the CPU supports
+	*
+	* @see HttpLineScanner for the parameters
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	static size_t scan_http_header_line(const char* data, const size_t length, size_t& colon_position) noexcept
+	{
+		return selected_http_line_scanner(data, length, colon_position);
+	}
+
+	/**
+	* @brief Gets a specific implementation, for benchmarks
+	*
+	* @param implementation The wanted implementation
+	* @return HttpLineScanner The scanner, nullptr if the CPU does not support it
+	*/
+	[[nodiscard]]
+	static HttpLineScanner get_http_line_scanner(HttpScannerImplementation implementation) noexcept;
+
+	/**
+	* @brief Gets the fastest implementation the CPU supports
+	*/
+	[[nodiscard]]
+	static HttpScannerImplementation get_best_http_scanner_implementation() noexcept;
+
+	/**
+	* @brief Converts an implementation to a printable name
+	*/
+	[[nodiscard]]
+	static const char* get_http_scanner_implementation_name(HttpScannerImplementation implementation) noexcept;
+
+private:
+	static const HttpLineScanner selected_http_line_scanner;
+};
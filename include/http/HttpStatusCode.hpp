@@ -10,6 +10,7 @@
 #define HTTP_PAGE_400_BAD_REQUEST			"<!DOCTYPE html><html><head><title>400 - Bad Request</title><style>body{font-family:'Arial',sans-serif;text-align:center;padding:50px;background-color:#f8f9fa;color:#343a40;}.container{background-color:white;padding:50px;border-radius:12px;box-shadow:0 4px 8px rgba(0,0,0,0.1);max-width:600px;margin:0 auto;animation:fadeIn 0.5s ease-in-out;}h1{font-size:2.5em;color:#495057;margin-bottom:20px;}p{color:#6c757d;font-size:1.2em;margin:15px 0;}a{color:#007bff;text-decoration:none;font-weight:bold;border:2px solid #007bff;padding:10px 20px;border-radius:5px;transition:all 0.3s ease;}a:hover{background-color:#007bff;color:white;}@keyframes fadeIn{from{opacity:0;transform:translateY(-10px);}to{opacity:1;transform:translateY(0);}}</style></head><body><div class=\"container\"><h1>400 - Bad Request</h1><p>Your request was invalid or missing necessary parameters.</p><p>Please check your input and try again.</p><p><a href=\"/\">Return to Homepage</a></p></div></body></html>"
 #define HTTP_PAGE_404_NOT_FOUND				"<!DOCTYPE html><html><head><title>404 - Not Found</title><style>body{font-family:'Arial',sans-serif;text-align:center;padding:50px;background-color:#f8f9fa;color:#343a40;}.container{background-color:white;padding:50px;border-radius:12px;box-shadow:0 4px 8px rgba(0,0,0,0.1);max-width:600px;margin:0 auto;animation:fadeIn 0.5s ease-in-out;}h1{font-size:2.5em;color:#495057;margin-bottom:20px;}p{color:#6c757d;font-size:1.2em;margin:15px 0;}a{color:#007bff;text-decoration:none;font-weight:bold;border:2px solid #007bff;padding:10px 20px;border-radius:5px;transition:all 0.3s ease;}a:hover{background-color:#007bff;color:white;}@keyframes fadeIn{from{opacity:0;transform:translateY(-10px);}to{opacity:1;transform:translateY(0);}}</style></head><body><div class=\"container\"><h1>404 - Not Found</h1><p>The requested resource could not be found on this server.</p><p><a href=\"/\">Return to Homepage</a></p></div></body></html>"
 #define HTTP_PAGE_405_METHOD_NOT_ALLOWED	"<!DOCTYPE html><html><head><title>405 - Method Not Allowed</title><style>body{font-family:'Arial',sans-serif;text-align:center;padding:50px;background-color:#f8f9fa;color:#343a40;}.container{background-color:white;padding:50px;border-radius:12px;box-shadow:0 4px 8px rgba(0,0,0,0.1);max-width:600px;margin:0 auto;animation:fadeIn 0.5s ease-in-out;}h1{font-size:2.5em;color:#495057;margin-bottom:20px;}p{color:#6c757d;font-size:1.2em;margin:15px 0;}a{color:#007bff;text-decoration:none;font-weight:bold;border:2px solid #007bff;padding:10px 20px;border-radius:5px;transition:all 0.3s ease;}a:hover{background-color:#007bff;color:white;}@keyframes fadeIn{from{opacity:0;transform:translateY(-10px);}to{opacity:1;transform:translateY(0);}}</style></head><body><div class='container'><h1>405 - Method Not Allowed</h1><p>POST requests are not allowed on this route.</p><p><a href='/'>Return to Homepage</a></p></div></body></html>"
+#define HTTP_PAGE_408_REQUEST_TIMEOUT		"<!DOCTYPE html><html><head><title>408 - Request Timeout</title><style>body{font-family:'Arial',sans-serif;text-align:center;padding:50px;background-color:#f8f9fa;color:#343a40;}.container{background-color:white;padding:50px;border-radius:12px;box-shadow:0 4px 8px rgba(0,0,0,0.1);max-width:600px;margin:0 auto;animation:fadeIn 0.5s ease-in-out;}h1{font-size:2.5em;color:#495057;margin-bottom:20px;}p{color:#6c757d;font-size:1.2em;margin:15px 0;}a{color:#007bff;text-decoration:none;font-weight:bold;border:2px solid #007bff;padding:10px 20px;border-radius:5px;transition:all 0.3s ease;}a:hover{background-color:#007bff;color:white;}@keyframes fadeIn{from{opacity:0;transform:translateY(-10px);}to{opacity:1;transform:translateY(0);}}</style></head><body><div class=\"container\"><h1>408 - Request Timeout</h1><p>The server timed out waiting for the rest of your request.</p><p>Please try again.</p><p><a href=\"/\">Return to Homepage</a></p></div></body></html>"
 #define HTTP_PAGE_413_PAYLOAD_TOO_LARGE		"<!DOCTYPE html><html><head><title>413 - Payload Too Large</title><style>body{font-family:'Arial',sans-serif;text-align:center;padding:50px;background-color:#f8f9fa;color:#343a40;}.container{background-color:white;padding:50px;border-radius:12px;box-shadow:0 4px 8px rgba(0,0,0,0.1);max-width:600px;margin:0 auto;animation:fadeIn 0.5s ease-in-out;}h1{font-size:2.5em;color:#495057;margin-bottom:20px;}p{color:#6c757d;font-size:1.2em;margin:15px 0;}a{color:#007bff;text-decoration:none;font-weight:bold;border:2px solid #007bff;padding:10px 20px;border-radius:5px;transition:all 0.3s ease;}a:hover{background-color:#007bff;color:white;}@keyframes fadeIn{from{opacity:0;transform:translateY(-10px);}to{opacity:1;transform:translateY(0);}}</style></head><body><div class=\"container\"><h1>413 - Payload Too Large</h1><p>File too large. Maximum size is 10MB.</p><p><a href=\"/\">Return to Homepage</a></p></div></body></html>"
 #define HTTP_PAGE_500_INTERNAL_SERVER_ERROR	"<!DOCTYPE html><html><head><title>500 - Internal Server Error</title><style>body{font-family:'Arial',sans-serif;text-align:center;padding:50px;background-color:#f8f9fa;color:#343a40;}.container{background-color:white;padding:50px;border-radius:12px;box-shadow:0 4px 8px rgba(0,0,0,0.1);max-width:600px;margin:0 auto;animation:fadeIn 0.5s ease-in-out;}h1{font-size:2.5em;color:#495057;margin-bottom:20px;}p{color:#6c757d;font-size:1.2em;margin:15px 0;}a{color:#007bff;text-decoration:none;font-weight:bold;border:2px solid #007bff;padding:10px 20px;border-radius:5px;transition:all 0.3s ease;}a:hover{background-color:#007bff;color:white;}@keyframes fadeIn{from{opacity:0;transform:translateY(-10px);}to{opacity:1;transform:translateY(0);}}</style></head><body><div class=\"container\"><h1>500 - Internal Server Error</h1><p>An unexpected error occurred on the server. Please try again later.</p><p><a href=\"/\">Return to Homepage</a></p></div></body></html>"
 
@@ -21,6 +22,9 @@
 
 enum class HttpStatusCode
 {
+	/* 1XX Informational */
+	HTTP_100_CONTINUE				= 100,
+
 	/* 2XX Success */
 	HTTP_200_OK						= 200,
 	HTTP_201_CREATED				= 201,
@@ -47,6 +51,8 @@ enum class HttpStatusCode
 	HTTP_413_PAYLOAD_TOO_LARGE		= 413,
 	HTTP_414_URI_TOO_LONG			= 414,
 	HTTP_415_UNSUPPORTED_MEDIA_TYPE	= 415,
+	HTTP_417_EXPECTATION_FAILED		= 417,
+	HTTP_431_REQUEST_HEADER_FIELDS_TOO_LARGE	= 431,
 
 	/* 5XX Server Errors */
 	HTTP_500_INTERNAL_SERVER_ERROR	= 500,
@@ -85,6 +91,7 @@ static inline const char* get_http_response_status_code_text(const HttpStatusCod
 	/* Ported from switch statement for better readibility and efficiency */
 	static const std::unordered_map<HttpStatusCode, const char*> status_texts = 
 	{
+		{HttpStatusCode::HTTP_100_CONTINUE,					"Continue"},
 		{HttpStatusCode::HTTP_200_OK,						"OK"},
 		{HttpStatusCode::HTTP_201_CREATED,					"Created"},
 		{HttpStatusCode::HTTP_202_ACCEPTED,					"Accepted"},
@@ -106,6 +113,8 @@ static inline const char* get_http_response_status_code_text(const HttpStatusCod
 		{HttpStatusCode::HTTP_413_PAYLOAD_TOO_LARGE,		"Payload Too Large"},
 		{HttpStatusCode::HTTP_414_URI_TOO_LONG,				"URI Too Long"},
 		{HttpStatusCode::HTTP_415_UNSUPPORTED_MEDIA_TYPE,	"Unsupported Media Type"},
+		{HttpStatusCode::HTTP_417_EXPECTATION_FAILED,		"Expectation Failed"},
+		{HttpStatusCode::HTTP_431_REQUEST_HEADER_FIELDS_TOO_LARGE,	"Request Header Fields Too Large"},
 		{HttpStatusCode::HTTP_500_INTERNAL_SERVER_ERROR,	"Internal Server Error"},
 		{HttpStatusCode::HTTP_501_NOT_IMPLEMENTED,			"Not Implemented"},
 		{HttpStatusCode::HTTP_502_BAD_GATEWAY,				"Bad Gateway"},
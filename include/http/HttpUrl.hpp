@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/**
+* @brief Turns the request target into the path the routes and the filesystem see
+*
+* Percent escapes are decoded and the path normalized in one pass over the
+* bytes, in place: empty segments (`//`) are collapsed, `.` segments dropped
+* and `..` segments remove the segment before them. Escaped dots and slashes
+* are decoded first, so `%2e%2e%2f` is a `../` like any other. The result
+* always starts with '/' and never contains a `.` or `..` segment, appending
+* it to a route root cannot leave that root.
+*
+* Every byte is classified with a lookup table, nothing is allocated.
+*/
+class HttpUrl
+{
+public:
+	/**
+	* @brief Gets the path of a request target, without its query or fragment
+	*
+	* Origin-form targets (`/path?query`) start with the path, absolute-form
+	* ones (`http://host/path`) have their scheme and authority skipped.
+	*
+	* @param target The request target as sent by the client
+	* @return std::string_view The still encoded path, points into target
+	* @throws HttpRequestError 400 If the target has no path
+	*/
+	[[nodiscard]]
+	static std::string_view get_http_url_path(std::string_view target);
+
+	/**
+	* @brief Decodes and normalizes a path in place
+	*
+	* A trailing slash is kept, `/upload/` and `/upload` stay different.
+	* '+' is a plain character in a path, it only means a space in form data.
+	*
+	* @param path An encoded path starting with '/', replaced by the result
+	* @throws HttpRequestError 400 If an escape is truncated or not hexadecimal, a control
+	*         character or an escaped NUL is found, or `..` climbs above the root
+	*/
+	static void normalize_http_url_path(std::string& path);
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "http/HttpRequest.hpp"
+#include "http/HttpResponse.hpp"
+
+/**
+* @brief Which deadline the connection's timer currently enforces
+*/
+enum class ConnectionTimeout : int8_t
+{
+	NONE,
+	HEADER,		/* Request header not complete, counted from its first byte */
+	BODY,		/* Request body not complete, counted from the last read */
+	SEND,		/* Responses waiting for the socket, counted from the last write */
+	KEEPALIVE,	/* Idle between two requests */
+	LINGER		/* Refused request answered, discarding what the client still sends */
+};
+
+/**
+* @brief Everything a worker tracks about one accepted client socket
+*
+* A persistent connection serves several requests in a row, the same
+* HttpRequest is reset and reused for each of them. Responses to pipelined
+* requests wait in pending_http_response_segments, a header block and a body
+* each, until they are flushed together, whatever the socket does not accept
+* yet is resumed once it becomes writable.
+*/
+struct ClientConnection
+{
+	int										file_descriptor = -1;
+	HttpRequest								http_request;
+	std::vector<HttpResponseSegment>		pending_http_response_segments;
+	size_t									pending_segment_index = 0;		/* First segment not fully sent */
+	size_t									pending_segment_offset = 0;		/* Bytes of it already sent */
+	bool									is_waiting_for_writable = false;
+	size_t									served_request_count = 0;
+	bool									close_after_response = false;
+	bool									linger_after_response = false;	/* The refused request's remaining bytes may still arrive */
+	bool									is_lingering = false;
+	ConnectionTimeout						active_timeout = ConnectionTimeout::NONE;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "server/ClientConnection.hpp"
+
+/**
+* @brief The client connections of one worker, stored densely and indexed by file descriptor
+*
+* Connections live contiguously in one vector so walking all of them touches
+* no dead entries, while a second vector maps every file descriptor to its
+* slot for O(1) lookups. Removing a connection moves the last one into the
+* freed slot, so accept and close churn stay O(1) at any connection count.
+*
+* References returned by insert() and find() stay valid until the next insert()
+* or erase() call.
+*/
+class ConnectionTable
+{
+public:
+	/**
+	* @brief Adds a fresh connection for the descriptor
+	*
+	* @param file_descriptor The accepted client socket
+	* @return Reference to the new connection
+	* @throws std::runtime_error If the descriptor already has a connection
+	*/
+	ClientConnection& insert(int file_descriptor);
+
+	/**
+	* @brief Removes the connection of the descriptor, unknown descriptors are ignored
+	*
+	* @param file_descriptor The client socket to forget
+	*/
+	void erase(int file_descriptor);
+
+	/**
+	* @brief Looks up the connection of a descriptor
+	*
+	* @param file_descriptor The client socket
+	* @return Pointer to the connection, nullptr if the descriptor is not a client
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	ClientConnection* find(const int file_descriptor) noexcept
+	{
+		const int32_t slot = get_slot(file_descriptor);
+
+		return slot < 0 ? nullptr : &connections[static_cast<size_t>(slot)];
+	}
+
+	/**
+	* @brief Gets the connection of a descriptor that is known to be a client
+	*
+	* @param file_descriptor The client socket
+	* @return Reference to the connection
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	ClientConnection& get(const int file_descriptor) noexcept
+	{
+		return connections[static_cast<size_t>(slot_by_file_descriptor[static_cast<size_t>(file_descriptor)])];
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	bool contains(const int file_descriptor) const noexcept
+	{
+		return get_slot(file_descriptor) >= 0;
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	size_t size() const noexcept
+	{
+		return connections.size();
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	bool empty() const noexcept
+	{
+		return connections.empty();
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	std::vector<ClientConnection>::iterator begin() noexcept
+	{
+		return connections.begin();
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	std::vector<ClientConnection>::iterator end() noexcept
+	{
+		return connections.end();
+	}
+
+private:
+	std::vector<ClientConnection>	connections;
+	std::vector<int32_t>			slot_by_file_descriptor;	/* -1 when the descriptor has no connection */
+
+	[[nodiscard]] __attribute__((always_inline))
+	int32_t get_slot(const int file_descriptor) const noexcept
+	{
+		const size_t index = static_cast<size_t>(file_descriptor);
+
+		return file_descriptor < 0 || index >= slot_by_file_descriptor.size()
+			 ? -1 : slot_by_file_descriptor[index];
+	}
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <sys/epoll.h>
+
+#include "server/EventLoop.hpp"
+
+#define _MAX_EPOLL_EVENTS 1024 /* Ready events returned per epoll_wait() */
+
+class EpollEventLoop final : public EventLoop
+{
+public:
+	/**
+	* @brief Creates the epoll instance
+	*
+	* @throws std::runtime_error If epoll_create1() fails
+	*/
+	EpollEventLoop();
+
+	/**
+	* @brief Closes the epoll instance
+	*/
+	~EpollEventLoop() override;
+
+	EpollEventLoop(const EpollEventLoop&)				= delete;
+	EpollEventLoop& operator=(const EpollEventLoop&)	= delete;
+
+	/**
+	* @brief Registers the descriptor with the epoll instance (EPOLL_CTL_ADD)
+	*
+	* @param file_descriptor The descriptor to watch
+	* @param events The poll() interest mask, translated to epoll flags
+	* @throws std::runtime_error If epoll_ctl() fails
+	*/
+	void add_file_descriptor(int file_descriptor, uint32_t events) override;
+
+	/**
+	* @brief Updates the interest mask of the descriptor (EPOLL_CTL_MOD)
+	*
+	* @param file_descriptor The descriptor to update
+	* @param events The new poll() interest mask
+	* @throws std::runtime_error If epoll_ctl() fails
+	*/
+	void modify_file_descriptor(int file_descriptor, uint32_t events) override;
+
+	/**
+	* @brief Unregisters the descriptor from the epoll instance (EPOLL_CTL_DEL)
+	*
+	* @param file_descriptor The descriptor to remove
+	*/
+	void remove_file_descriptor(int file_descriptor) override;
+
+	/**
+	* @brief Calls epoll_wait() which only returns the ready descriptors
+	*
+	* The cost of a wakeup is proportional to the number of ready
+	* descriptors, not to the number of idle connections.
+	*
+	* @param ready_events Output vector that receives the ready descriptors
+	* @param timeout_milliseconds Maximum time to block, -1 blocks indefinitely
+	* @return The number of ready descriptors
+	* @throws std::runtime_error If epoll_wait() fails
+	*/
+	size_t wait_for_events(
+		std::vector<EventLoopEvent>&	ready_events,
+		int								timeout_milliseconds) override;
+
+	[[nodiscard]] __attribute__((always_inline))
+	const char* get_backend_name() const noexcept override
+	{
+		return "epoll";
+	}
+
+private:
+	int			epoll_file_descriptor;
+	epoll_event	epoll_events[_MAX_EPOLL_EVENTS];
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <poll.h>
+
+#include "server/EventLoopBackend.hpp"
+
+/**
+* @brief A single ready file descriptor reported by an event loop backend
+*
+* The events field always uses the poll() bit values (POLLIN, POLLOUT,
+* POLLERR, POLLHUP, POLLNVAL) regardless of the backend, so the server
+* handlers never need to know which mechanism produced the event.
+*/
+struct EventLoopEvent
+{
+	int			fd;
+	uint32_t	events;
+};
+
+class EventLoop
+{
+public:
+	/**
+	* @brief Virtual destructor so backends can release their kernel resources
+	*/
+	virtual ~EventLoop() = default;
+
+	/**
+	* @brief Starts monitoring a file descriptor
+	*
+	* @param file_descriptor The descriptor to watch
+	* @param events The poll() style interest mask (POLLIN, POLLOUT)
+	* @throws std::runtime_error If the backend fails to register the descriptor
+	*/
+	virtual void add_file_descriptor(int file_descriptor, uint32_t events) = 0;
+
+	/**
+	* @brief Replaces the interest mask of an already monitored file descriptor
+	*
+	* @param file_descriptor The descriptor to update
+	* @param events The new poll() style interest mask
+	* @throws std::runtime_error If the backend fails to update the descriptor
+	*/
+	virtual void modify_file_descriptor(int file_descriptor, uint32_t events) = 0;
+
+	/**
+	* @brief Stops monitoring a file descriptor
+	*
+	* Must be called before the descriptor is closed. Unknown descriptors are ignored.
+	*
+	* @param file_descriptor The descriptor to remove
+	*/
+	virtual void remove_file_descriptor(int file_descriptor) = 0;
+
+	/**
+	* @brief Waits until at least one monitored descriptor is ready
+	*
+	* Clears ready_events and fills it with only the descriptors that have events,
+	* so callers never have to scan idle connections.
+	*
+	* @param ready_events Output vector that receives the ready descriptors
+	* @param timeout_milliseconds Maximum time to block, -1 blocks indefinitely
+	* @return The number of ready descriptors, 0 on timeout or interruption
+	* @throws std::runtime_error If the underlying syscall fails
+	*/
+	virtual size_t wait_for_events(
+		std::vector<EventLoopEvent>&	ready_events,
+		int								timeout_milliseconds) = 0;
+
+	/**
+	* @brief Gets the name of the backend for logging
+	*
+	* @return The backend name as a string literal
+	*/
+	[[nodiscard]]
+	virtual const char* get_backend_name() const noexcept = 0;
+
+	/**
+	* @brief Gets the number of syscalls the backend issued so far
+	*
+	* Only counts the readiness syscalls themselves (poll, epoll_wait,
+	* epoll_ctl, io_uring_enter), useful to compare backends.
+	*
+	* @return The syscall count
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	size_t get_backend_syscall_count() const noexcept
+	{
+		return backend_syscall_count;
+	}
+
+	/**
+	* @brief Creates the event loop implementation for the requested backend
+	*
+	* If io_uring is requested but not supported by the running kernel,
+	* the poll backend is returned instead.
+	*
+	* @param backend Which readiness mechanism to use
+	* @return Owning pointer to the created event loop
+	* @throws std::runtime_error If the backend could not be initialized
+	*/
+	[[nodiscard]]
+	static std::unique_ptr<EventLoop> create(EventLoopBackend backend);
+
+protected:
+	size_t backend_syscall_count = 0;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+/* int8 for better portability */
+enum class EventLoopBackend : int8_t
+{
+	POLL,
+	EPOLL,
+	IO_URING
+};
+
+/**
+* @brief Converts an event loop backend to its configuration name
+*
+* @param backend The backend to convert
+* @return The name used by the event_backend directive
+*/
+static inline const char* get_event_loop_backend_name(const EventLoopBackend backend)
+{
+	switch (backend)
+	{
+	case EventLoopBackend::POLL:		return "poll";
+	case EventLoopBackend::EPOLL:		return "epoll";
+	case EventLoopBackend::IO_URING:	return "io_uring";
+	}
+
+	return "unknown";
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <poll.h>
+
+#include "server/EventLoop.hpp"
+
+class PollEventLoop final : public EventLoop
+{
+public:
+	/**
+	* @brief Creates an empty poll() based event loop
+	*/
+	PollEventLoop() = default;
+
+	/**
+	* @brief Appends a pollfd entry for the descriptor
+	*
+	* The position of the entry is remembered in a table indexed by
+	* file descriptor, so later updates and removals are O(1).
+	*
+	* @param file_descriptor The descriptor to watch
+	* @param events The poll() interest mask
+	*/
+	void add_file_descriptor(int file_descriptor, uint32_t events) override;
+
+	/**
+	* @brief Updates the interest mask of the descriptor's pollfd entry
+	*
+	* @param file_descriptor The descriptor to update
+	* @param events The new poll() interest mask
+	*/
+	void modify_file_descriptor(int file_descriptor, uint32_t events) override;
+
+	/**
+	* @brief Removes the descriptor's pollfd entry
+	*
+	* Swaps the last entry into the freed position instead of erasing,
+	* so removal never shifts the whole vector.
+	*
+	* @param file_descriptor The descriptor to remove
+	*/
+	void remove_file_descriptor(int file_descriptor) override;
+
+	/**
+	* @brief Calls poll() over every monitored descriptor and collects the ready ones
+	*
+	* poll() itself is O(n) in the number of monitored descriptors,
+	* this backend is kept for portability and comparison with epoll.
+	*
+	* @param ready_events Output vector that receives the ready descriptors
+	* @param timeout_milliseconds Maximum time to block, -1 blocks indefinitely
+	* @return The number of ready descriptors
+	* @throws std::runtime_error If poll() fails
+	*/
+	size_t wait_for_events(
+		std::vector<EventLoopEvent>&	ready_events,
+		int								timeout_milliseconds) override;
+
+	[[nodiscard]] __attribute__((always_inline))
+	const char* get_backend_name() const noexcept override
+	{
+		return "poll";
+	}
+
+private:
+	std::vector<pollfd>	poll_file_descriptors;
+
+	/* Maps a file descriptor to its position in poll_file_descriptors, -1 if absent */
+	std::vector<int>	poll_file_descriptor_positions;
+};
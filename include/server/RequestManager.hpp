@@ -1,10 +1,12 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 #include "http/HttpRequest.hpp"
 #include "http/HttpResponse.hpp"
 #include "utils/utils.hpp"
+#include "server/StaticFileCache.hpp"
 
 #include "configuration/ServerConfiguration.hpp"
 
@@ -15,19 +17,20 @@ public:
 	* @brief Constructor that initializes the RequestManager with server configuration
 	*
 	* @param server_configuration Pointer to configuration containing server settings
+	* @param file_cache The worker's cache of the files and directories it serves
 	*/
-	explicit RequestManager(const ServerConfiguration* server_configuration);
+	RequestManager(const ServerConfiguration* server_configuration, StaticFileCache& file_cache);
 
 	/**
 	* @brief Handles GET requests by sending back files or directory listings
 	*
-	* - Decodes the URL and finds the matching route
+	* - Finds the route matching the decoded path
 	* - Checks if URL needs redirecting
 	* - Handles CGI scripts if needed
 	* - Shows directory listing or file content
 	* - Returns error pages if something goes wrong
 	*
-	* @param url The URL from the request
+	* @param url The decoded and normalized path of the request
 	* @param request The full HTTP request
 	* @param http_response Where to put the response
 	* @param server_listening_port Which port received the request
@@ -41,13 +44,12 @@ public:
 	/**
 	* @brief Handles POST requests by saving uploaded files or form data
 	*
-	* - Checks if the request isn't too big (max 10MB)
-	* - Makes sure POST is allowed for this URL
+	* - Makes sure POST is allowed for this URL, the body size was checked by the parser
 	* - Saves content to a file in the upload folder
 	* - Handles both regular POST data and file uploads
 	* - Returns a success or error page
 	*
-	* @param url The URL from the request
+	* @param url The decoded and normalized path of the request
 	* @param http_request The full HTTP request
 	* @param http_response Where to put the response
 	* @param server_listening_port Which port received the request
@@ -58,6 +60,24 @@ public:
 		HttpResponse&		http_response,
 		int					server_listening_port) const;
 
+	/**
+	* @brief Decides from the request head alone whether the body is worth receiving
+	*
+	* Applies the route and method checks of the handlers before the body is
+	* sent, so a client waiting on Expect: 100-continue is refused at once
+	* instead of uploading a body that would be thrown away.
+	*
+	* @param http_request The request, its header block parsed
+	* @param http_response Receives the final response when the body is refused
+	* @param server_listening_port Which port received the request
+	* @return bool True if the handler would run with the body
+	*/
+	[[nodiscard]]
+	bool accept_http_request_body(
+		const HttpRequest&	http_request,
+		HttpResponse&		http_response,
+		int					server_listening_port) const;
+
 	/**
 	* @brief Handles DELETE requests by removing files from the server
 	*
@@ -67,7 +87,7 @@ public:
 	* - Tries to delete the file
 	* - Returns success or error message
 	*
-	* @param url The URL with the file to delete
+	* @param url The decoded and normalized path of the file to delete
 	* @param http_response Where to put the response
 	* @param server_listening_port Which port received the request
 	*/
@@ -80,19 +100,15 @@ public:
 	* @brief Handles directory access based on route configuration
 	*
 	* Processing order:
-	* 1. If directory listing enabled:
-	*    - Creates directory if doesn't exist
-	*    - Checks for configured index file
-	*    - Checks for default index.html
-	*    - Returns directory listing if no index found
-	* 2. If directory listing disabled:
-	*    - Checks for configured index file
-	*    - Checks for default index.html
-	*    - Returns 403 if no index found
+	* 1. Looks up the index file in the file cache: the configured one, then
+	*    index.html, without touching the filesystem once the directory is cached
+	* 2. If no index found:
+	*    - Returns directory listing if enabled
+	*    - Returns 403 otherwise
 	*
 	* @param url_route Route configuration for this URL
 	* @param directory_path Path to the directory
-	* @param url Original URL for directory listing
+	* @param url Request path for directory listing
 	* @param http_response Response object to update on errors
 	* @return Path to index file if found, empty string if handled internally
 	*/
@@ -103,35 +119,23 @@ public:
 		HttpResponse&		http_response) const;
 
 private:
-	const ServerConfiguration* configuration;
-
-	/**
-	* @brief Converts URL to a full filesystem path and checks for path traversal
-	*
-	* - Removes query parameters (everything after '?')
-	* - Combines root directory with cleaned URL
-	* - Prevents directory traversal attacks by checking for '..'
-	*
-	* @param url The URL to resolve
-	* @return Full filesystem path
-	* @throws std::runtime_error If path traversal attempt detected
-	*/
-	[[nodiscard]]
-	std::string resolve_url_path(const std::string& url) const;
+	const ServerConfiguration*	configuration;
+	StaticFileCache&			static_file_cache;
 
 	/**
-	* @brief Reads entire file content into string
+	* @brief Answers with a regular file, sent from its descriptor
 	*
-	* Uses Utils to read file contents
+	* The descriptor is the one the file cache keeps open, the response shares
+	* it and the kernel copies the file to the socket, it is never read into
+	* memory. Files the content cache holds are sent from memory instead, with
+	* the headers describing them.
 	*
-	* @param file_path Path to file to read
-	* @return String containing file contents
+	* @param file_entry The file's cache entry
+	* @param http_response Response to fill, or an error page when the file cannot be sent
 	*/
-	[[nodiscard]] __attribute__((always_inline))
-	std::string get_file_content(const std::string& file_path) const
-	{
-		return Utils::read_file(file_path);
-	}
+	void serve_static_file(
+		const StaticFileEntry&	file_entry,
+		HttpResponse&			http_response) const;
 
 	/**
 	* @brief Creates an HTML page displaying directory contents
@@ -157,33 +161,6 @@ private:
 		const std::string& directory_path,
 		const std::string& url) const;
 
-	/**
-	* @brief Determines HTTP content type based on file extension
-	*
-	* Supports common file types:
-	* - HTML (.html, .htm)
-	* - CSS (.css)
-	* - Images (.jpg, .jpeg, .gif)
-	* - Documents (.pdf, .txt)
-	* Returns 'application/octet-stream' for unknown types
-	*
-	* @param file_path Path to get extension from
-	* @return MIME type string
-	*/
-	[[nodiscard]]
-	std::string get_http_request_content_type(const std::string& file_path) const;
-
-	/**
-	* @brief Checks if given path is a directory
-	*
-	* Uses stat() to get file information and S_ISDIR to check if it's a directory
-	*
-	* @param directory_path Path to check
-	* @return true if path is a directory, false if not or if check fails
-	*/
-	[[nodiscard]]
-	bool is_directory(const std::string& directory_path) const;
-
 	/**
 	* @brief Checks if a file exists at the given path
 	*
@@ -196,34 +173,29 @@ private:
 	bool file_exists(const std::string& file_path) const;
 
 	/**
-	* @brief Decodes URL-encoded strings
+	* @brief Saves the file parts of a multipart upload in the upload directory
 	*
-	* - Converts %XX sequences to their ASCII characters
-	* - Converts '+' to spaces
-	* - Keeps other characters unchanged
+	* - Every part with a filename is saved under that name, several files per request
+	* - Spooled parts are linked into place, the others are written from memory
+	* - Parts without a filename are form fields and are not saved, unless
+	*   the form has no file at all: its first part is then saved under a generated name
 	*
-	* @param encoded The URL-encoded string
-	* @return Decoded string
+	* @param http_request The request, its body already split into parts by the parser
+	* @param upload_directory Where the files are saved
+	* @throws std::runtime_error If a file cannot be written
 	*/
-	[[nodiscard]]
-	std::string url_decode(const std::string& encoded) const;
+	void save_http_request_multipart_parts(
+		const HttpRequest&	http_request,
+		const std::string&	upload_directory) const;
 
 	/**
-	* @brief Removes boundary markers from a form request body to get the actual content
-	*
-	* - Checks if the boundary exists in the body
-	* - Goes through the body line by line
-	* - Finds the content between boundary markers
-	* - Gets rid of extra boundary text
+	* @brief Keeps the last path component of a filename sent by the client
 	*
-	* @param http_request_body The form data sent in the request
-	* @param http_request_boundary The text that separates different parts of the form
-	* @return The cleaned content without boundary markers
+	* @param filename The filename parameter of a part
+	* @return The name to save the part under, empty if nothing usable is left
 	*/
 	[[nodiscard]]
-	std::string remove_http_request_boundary(
-		const std::string& http_request_body,
-		const std::string& http_request_boundary) const;
+	static std::string get_upload_filename(std::string_view filename);
 
 	/**
 	* @brief Shows an error page to the user
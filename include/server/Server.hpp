@@ -1,36 +1,55 @@
 #pragma once
 
-#include <map>
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <poll.h>
 #include <netinet/in.h>
 
+#include "server/EventLoop.hpp"
 #include "http/HttpRequest.hpp"
 #include "http/HttpResponse.hpp"
+#include "server/TimerWheel.hpp"
+#include "server/StaticFileCache.hpp"
+#include "server/ConnectionTable.hpp"
 #include "configuration/ServerConfiguration.hpp"
 
+#define _MAX_ACCEPTS_PER_EVENT		64	/* Accepts per readiness event before the other sockets get their turn */
+#define _LINGERING_TIMEOUT_SECONDS	2	/* How long the rest of a refused request is discarded before closing */
+#define _HTTP_100_CONTINUE_RESPONSE	"HTTP/1.1 100 Continue\r\n\r\n"
+
+/**
+* @brief Accept statistics of one worker
+*/
+struct AcceptCounters
+{
+	size_t	accepted_connections			= 0;
+	size_t	accept_limit_hits				= 0;	/* Events that ended with connections still queued */
+	size_t	full_listen_queue_observations	= 0;	/* Limit hits while the kernel accept queue was full */
+	size_t	descriptor_exhaustion_drops		= 0;	/* Connections dropped on EMFILE or ENFILE */
+};
+
 class Server
 {
 public:
 	/**
-	* @brief Initializes server sockets that listen on the configured ports
+	* @brief Creates a server worker that shares the given configuration
 	*
-	* - Validates server configuration and retrieves list of ports to listen on
-	* - For each port:
-	*   - Creates a socket using AF_INET (IPv4) and SOCK_STREAM (TCP)
-	*   - Sets socket to non-blocking mode using fcntl() for concurrent request handling
-	*   - Enables address reuse with setsockopt() to prevent "Address already in use" errors
-	*   - Configures socket address (sockaddr_in) with port and INADDR_ANY for all interfaces
+	* - Validates the server configuration
+	* - Every worker owns its own listening sockets, event loop and client table,
+	*   the configuration is the only state shared between workers and is never modified
 	*
 	* @param configuration Pointer to the Configuration object containing server settings
-	* @throws std::runtime_error If configuration is invalid or socket operations fail
+	* @param worker_index Index of this worker, worker 0 prints the configuration
+	* @throws std::runtime_error If configuration is invalid
 	*/
-	explicit Server(const ServerConfiguration* configuration);
+	explicit Server(const ServerConfiguration* configuration, size_t worker_index = 0);
 
 	/**
 	* Destructor that closes all open server sockets by iterating through the
 	* server_file_descriptors vector and calling close() on each file descriptor.
 	* This prevents resource leaks by ensuring all network connections are properly terminated.
+	* The reserve and wakeup descriptors are closed as well.
 	*/
 	~Server();
 
@@ -38,43 +57,68 @@ public:
 	* @brief Sets up server sockets for each configured port to accept client connections
 	*
 	* For each port in the configuration:
-	* - Creates a socket (AF_INET, SOCK_STREAM)
-	* - Enables address reuse via setsockopt()
-	* - Binds socket to port using bind()
-	* - Starts listening with listen() (backlog queue of 5)
+	* - Reuses an inherited socket already listening on that port if there is one
+	*   (handed over by a reload or by the binary that exec'd this one),
+	*   so the connections waiting in its accept queue are not lost
+	* - Otherwise creates a new one with create_server_file_descriptor()
 	* - Adds successful sockets to server_file_descriptors
 	*
+	* Then opens the reserve descriptor used when the process runs out of descriptors
+	* and the eventfd used to wake the event loop from other threads.
+	*
 	* If setup fails for a port:
 	* - Logs error and continues with next port
-	* - Cleans up by closing failed socket
 	*
+	* @param inherited_server_file_descriptors Listening sockets up for adoption, the adopted ones are removed
+	* @param adopt_every_inherited_match Adopts every inherited socket of a configured port instead of one,
+	*        used by the last worker when the previous generation had more workers
 	* @throws std::runtime_error If no ports could be successfully set up
 	*/
-	void setup_server();
+	void setup_server(
+		std::vector<int>&	inherited_server_file_descriptors,
+		bool				adopt_every_inherited_match = false);
+
+	/**
+	* @brief Stops the worker from another thread
+	*
+	* The event loop exits after the current iteration and closes every connection.
+	*/
+	void request_stop() noexcept;
+
+	/**
+	* @brief Asks the worker to shut down gracefully from another thread
+	*
+	* The worker closes its listening sockets, lets the open connections finish
+	* their current requests (responses carry Connection: close) and exits once
+	* none are left or the shutdown_timeout runs out.
+	*/
+	void request_graceful_shutdown() noexcept;
 
 	/**
-	* Handles write events for a client socket identified by poll_file_descriptors[index].
-	* Gets the client's current HTTP request from our request map and checks if complete.
-	* If complete:
-	* - Processes request by determining its HTTP method (GET/POST/DELETE)
-	* - Changes socket back to read mode (POLLIN) to prepare for next request
+	* @brief Handles write events for a client socket
+	*
+	* Only armed while the connection has responses the socket could not take yet,
+	* resumes sending them with flush_http_responses().
 	*
-	* @param index Position in poll_file_descriptors vector that identifies the client socket
+	* @param client_file_descriptor The client socket that became writable
 	*/
-	void handle_client_write(size_t index);
+	void handle_client_write(int client_file_descriptor);
 
 	/**
 	* @brief Starts the server's main event loop
 	*
-	* - Sets up poll monitoring by initializing poll file descriptors
+	* - Creates the configured event loop backend (poll, epoll or io_uring) and registers the server sockets
 	* - Prints server configuration info
-	* - Enters infinite loop to monitor socket events:
-	*   - poll() watches for activity on all file descriptors (blocking, timeout = -1)
-	*   - .data() provides contiguous array of poll structs
-	*   - .size() gives number of descriptors to monitor
-	*   - On successful poll, handle_poll_events() processes active sockets
+	* - Enters the event loop to monitor socket events:
+	*   - The event loop blocks until descriptors are ready or the next connection timer is due
+	*   - Only the ready descriptors are returned, idle connections cost nothing
+	*   - The default response headers are refreshed, their Date once per second
+	*   - handle_ready_events() processes the active sockets
+	*   - handle_expired_connection_timers() enforces the header, body, send and keep-alive timeouts
+	* - Exits when request_stop() is called, or once drained after request_graceful_shutdown()
+	* - Closes every remaining client connection before returning
 	*
-	* @throws std::runtime_error If poll() system call fails
+	* @throws std::runtime_error If the event loop wait syscall fails
 	*/
 	void start_server();
 
@@ -100,124 +144,346 @@ public:
 		return server_running;
 	}
 
-private:
-	int							main_socket_file_descriptor;
-	sockaddr_in					socket_address_configuration;
+	/**
+	* @brief Gets the accept statistics of the worker
+	*
+	* Written by the worker thread without synchronization, only read them
+	* once that thread was joined. ServerMaster reports the totals of every
+	* generation that way.
+	*
+	* @return const AcceptCounters& The counters
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	const AcceptCounters& get_accept_counters() const noexcept
+	{
+		return accept_counters;
+	}
+
+	/**
+	* @brief Gets the listening sockets of the worker
+	*
+	* Only safe to call from another thread while no graceful shutdown was requested,
+	* the worker empties the vector when it starts draining.
+	*
+	* @return const std::vector<int>& The listening sockets
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	const std::vector<int>& get_server_file_descriptors() const
+	{
+		return server_file_descriptors;
+	}
 
+private:
 	std::vector<int>			server_file_descriptors;
-	std::vector<pollfd>			poll_file_descriptors;
+	std::unique_ptr<EventLoop>	event_loop;
+	std::vector<EventLoopEvent>	ready_events;
+
+	ConnectionTable					client_connections;
+	const ServerConfiguration*		server_configuration;
+	size_t							server_worker_index;
+
+	TimerWheel			connection_timers;
+	std::vector<int>	expired_file_descriptors;
+
+	AcceptCounters		accept_counters;
+	int					reserve_file_descriptor;	/* Released to shed connections on EMFILE */
+	int					wakeup_file_descriptor;		/* eventfd written by request_stop() and request_graceful_shutdown() */
+
+	StaticFileCache		static_file_cache;			/* Files and directories served by GET, invalidated through inotify */
+
+	HttpResponseDefaultHeaders	http_response_default_headers;	/* Date, Server and Connection of every response, refreshed once per second */
+
+	bool						is_draining;
+	TimerWheel::Clock::time_point	drain_deadline;
+
+	std::atomic<bool>			graceful_shutdown_requested;
+	std::atomic<bool>			server_running;
+
+	/**
+	* @brief Creates, binds and starts listening on a socket for a port
+	*
+	* - Creates a non-blocking, close-on-exec socket (AF_INET, SOCK_STREAM)
+	* - Enables address reuse via setsockopt()
+	* - Enables SO_REUSEPORT so every worker can bind its own socket to the same port
+	* - Binds socket to port using bind()
+	* - Starts listening with listen(), the queue length comes from the listen_backlog directive
+	*   (the kernel caps it at net.core.somaxconn)
+	*
+	* @param server_listening_port The port to listen on
+	* @return int The listening socket, -1 after logging the error and closing the socket
+	*/
+	[[nodiscard]]
+	int create_server_file_descriptor(int server_listening_port) const;
+
+	/**
+	* @brief Takes an inherited listening socket bound to the port out of the vector
+	*
+	* Makes sure the socket is non-blocking and close-on-exec again.
+	*
+	* @param server_listening_port The configured port
+	* @param inherited_server_file_descriptors The sockets up for adoption
+	* @return int The socket, -1 if none is bound to the port
+	*/
+	[[nodiscard]]
+	static int take_inherited_server_file_descriptor(
+		int					server_listening_port,
+		std::vector<int>&	inherited_server_file_descriptors);
+
+	/**
+	* @brief Interrupts the event loop wait by writing to the wakeup eventfd
+	*/
+	void wake_up() noexcept;
+
+	/**
+	* @brief Stops accepting and starts the drain deadline
+	*
+	* Closes this worker's listening sockets. The connections already queued on
+	* them are kept by the kernel as long as another process or generation holds
+	* the same sockets, they are only reset when nobody does.
+	*
+	* The idle connections are closed right away. The others are closed as
+	* soon as their last response is sent (flush_http_responses()) or their
+	* timer expires, so the drain never scans the whole table again.
+	*/
+	void begin_graceful_shutdown();
+
+	/**
+	* @brief Whether a connection has nothing left to do
+	*
+	* A connection is idle when it has no partial request, no pending response
+	* and no unread data waiting in its socket (checked with MSG_PEEK).
+	*/
+	[[nodiscard]]
+	bool is_client_connection_idle(const ClientConnection& client_connection) const;
 
-	std::map<int, HttpRequest>	client_http_requests;
-	const ServerConfiguration*	server_configuration;
+	/**
+	* @brief Closes the idle connections, once when the drain starts
+	*/
+	void close_idle_client_connections();
 
-	bool 						server_running;
+	/**
+	* @brief Closes every client connection, used when the worker exits
+	*/
+	void close_all_client_connections();
 
 	/**
-	* @brief Sets up poll file descriptors for monitoring socket events
+	* @brief Creates the event loop and registers the server sockets with it
 	*
 	* What is polling:
 	* - To poll is to check the status (of a device)
-	* - The pollfd structure is a standard C-struct used with poll() to monitor multiple file descriptors simultaneously
+	* - The event loop monitors multiple file descriptors simultaneously
 	* - POLLIN gives the server "ears" to listen to the sockets for detecting new incoming data.
 	*
 	* Implementation steps:
-	* - Clears existing poll_file_descriptors vector
+	* - Creates the backend selected by the event_backend directive (poll, epoll or io_uring)
 	* - For each server socket in server_file_descriptors:
-	*   - Creates a new pollfd structure
-	*   - Sets its file descriptor to the server socket
-	*   - Enables POLLIN flag to monitor for incoming connections
-	*   - Adds structure to poll_file_descriptors vector
+	*   - Registers it with the POLLIN flag to monitor for incoming connections
+	* - Registers the file cache's inotify descriptor, when there is one
+	*
+	* @throws std::runtime_error If the backend cannot be created
 	*/
-	void setup_poll_file_descriptors();
+	void setup_event_loop();
 
 	/**
 	* @brief Handles new incoming client connections on a server socket
 	*
 	* Core concepts:
-	* - accept() creates new socket specifically for this client-server communication
+	* - accept4() creates new socket specifically for this client-server communication,
+	*   already non-blocking and close-on-exec so no fcntl() calls are needed
 	* - Client's address info is stored in sockaddr_in structure
 	* - Non-blocking mode allows handling multiple clients simultaneously
 	*
 	* Implementation steps:
-	* - Accepts new connection, getting dedicated client file descriptor
-	* - Sets client socket to non-blocking mode using fcntl
-	* - Creates pollfd structure for client with POLLIN flag (ready for reading)
-	* - Adds client to poll_file_descriptors vector for monitoring
-	* - Initializes empty HTTP request for this client
+	* - Accepts connections until the queue is empty (EAGAIN), at most _MAX_ACCEPTS_PER_EVENT
+	*   per event so a connection burst cannot starve the clients already served
+	* - Registers each client with the event loop with the POLLIN flag (ready for reading)
+	* - Initializes an empty client connection and arms its header timer
+	* - When the limit is hit, checks whether the kernel accept queue is full and counts it
 	*
 	* Error handling:
-	* - Returns if accept() fails
-	* - Closes socket if setting non-blocking mode fails
+	* - ECONNABORTED and EINTR skip to the next connection
+	* - EMFILE and ENFILE are handled by handle_descriptor_exhaustion()
+	* - Closes the socket if registering it fails
 	*
 	* @param server_file_descriptor The listening server socket accepting the connection
 	*/
 	void handle_incoming_client_connection(int server_file_descriptor);
 
+	/**
+	* @brief Drops one pending connection when the process is out of file descriptors
+	*
+	* The listening socket stays readable while connections are queued, so simply
+	* returning would wake the event loop again right away. The reserve descriptor
+	* is closed to make room, the connection is accepted and closed at once
+	* (the client sees a reset instead of hanging), then the reserve is reopened.
+	*
+	* @param server_file_descriptor The listening server socket
+	*/
+	void handle_descriptor_exhaustion(int server_file_descriptor);
+
 	/**
 	* @brief Handles reading and processing of HTTP requests from a client
 	*
-	* Core steps:
-	* - Reads data from client into 8KB buffer
-	* - Updates associated HttpRequest object with new data
-	* - Processes different scenarios:
+	* Read, parse, queue, flush:
+	* - One read() of up to request_read_buffer_size bytes (at most _MAX_REQUEST_READ_SIZE)
+	*   into a stack buffer
+	* - The bytes are fed to the connection's incremental HttpRequest parser, which keeps
+	*   partial heads and bodies between reads: Content-Length and chunked bodies are
+	*   collected as they arrive, large ones spooled to a file
+	* - A request still waiting for its body with "Expect: 100-continue" gets its
+	*   interim answer, see answer_http_request_expectation()
+	* - Every request completed by the read is dispatched and its response queued as
+	*   segments by queue_http_response(), bytes left over belong to the next pipelined
+	*   request and are parsed right away, in order
+	* - flush_http_responses() then sends everything queued in as few syscalls as possible,
+	*   whatever the socket cannot take yet is sent by handle_client_write() once it
+	*   reports POLLOUT
+	*
+	* Error scenarios:
+	* - Read error (negative bytes_read): the connection is closed
+	* - Client disconnection (0 bytes_read), the normal end of an idle persistent connection
+	* - Malformed request (400), payload too large (413), request line too long (414) or
+	*   header block too large (431): refused as soon as detected, without reading the body,
+	*   the connection closes after the error response
+	* - Bytes that arrive after a refusal are read into the stack buffer and dropped,
+	*   see start_lingering_close()
+	*
+	* @param client_file_descriptor The client socket to read from
+	*/
+	void handle_http_request_client(int client_file_descriptor);
+
+	/**
+	* @brief Stops monitoring a client socket, closes it and forgets its request
+	*
+	* @param client_file_descriptor The client socket to close
+	*/
+	void close_client_connection(int client_file_descriptor);
+
+	/**
+	* @brief Starts the timer matching the connection's current state
+	*
+	* - Responses waiting for the socket: send_timeout, restarted on every write
+	* - Idle after a response: keepalive_timeout
+	* - Header incomplete: client_header_timeout, counted once from the start of the request
+	* - Body incomplete: client_body_timeout, restarted on every read
+	* - Lingering after a refusal: _LINGERING_TIMEOUT_SECONDS, never restarted
 	*
-	* Error scenarios (closes connection and cleans up):
-	* - Read error (negative bytes_read)
-	* - Client disconnection (0 bytes_read)
-	* - Payload too large (413 error response)
+	* @param client_connection The connection to (re)arm
+	*/
+	void arm_connection_timer(ClientConnection& client_connection);
+
+	/**
+	* @brief Advances the timer wheel and handles the connections whose deadline passed
+	*
+	* - A partially received request is answered with 408 Request Timeout and closed
+	* - Idle, stalled or silent connections are closed without a response
+	*/
+	void handle_expired_connection_timers();
+
+	/**
+	* @brief Decides whether the connection stays open after the current response
 	*
-	* Request processing:
-	* - If Content-Length header present:
-	*   - Waits until complete body is received
-	*   - Processes request when expected length reached
-	* - If no Content-Length:
-	*   - Processes request when marked complete
-	* - After processing, determines HTTP method and removes request from tracking
+	* The connection is closed when:
+	* - The server is stopping
+	* - The request could not be fully consumed (400, 413)
+	* - keepalive_timeout is 0 or keepalive_requests has been reached
+	* - The client asked for it (Connection: close, HTTP/1.0 without keep-alive)
 	*
-	* @param index Position in poll_file_descriptors vector of client to read from
+	* @param client_connection The connection the response is sent on
+	* @return bool True if the connection should be reused for another request
 	*/
-	void handle_http_request_client(size_t index);
+	[[nodiscard]]
+	bool should_keep_connection_alive(const ClientConnection& client_connection) const;
 
 	/**
-	* @brief Processes events on polled file descriptors (servers and clients)
+	* @brief Processes the descriptors reported ready by the event loop (servers and clients)
 	*
-	* Iterates through poll_file_descriptors checking revents (returned events):
+	* Only iterates ready_events, so the cost is proportional to the number of
+	* active descriptors instead of the number of open connections:
 	*
 	* Event handling priority:
-	* 1. No events (revents == 0):
-	*    - Skip to next descriptor
+	* 1. Server socket events:
+	*    - If POLLIN: handle_incoming_client_connection()
 	* 2. Error events (POLLERR | POLLHUP | POLLNVAL):
 	*    - Closes socket and removes from monitoring
 	*    - POLLERR: Error condition
 	*    - POLLHUP: Client disconnected
 	*    - POLLNVAL: Invalid descriptor
-	* 3. Server socket events:
-	*    - If POLLIN: handle_incoming_client_connection()
-	* 4. Client socket events:
+	* 3. Client socket events:
 	*    - If POLLOUT: handle_client_write() for outgoing data
 	*    - If POLLIN: handle_http_request_client() for incoming data
 	*/
-	void handle_poll_events();
+	void handle_ready_events();
 
 	/**
-	* @brief Sends HTTP response to client and closes the connection
+	* @brief Queues an HTTP response behind the earlier responses of the connection
 	*
 	* Process:
-	* - Builds response string from HttpResponse object
-	* - Sends data to client using send() system call
-	* - Always closes connection after sending (no keep-alive)
+	* - Sets the Connection (and Keep-Alive) header from should_keep_connection_alive()
+	* - Serializes the HttpResponse into the queue, a header block and its body moved in, not copied
+	* - Persistent connections reset their HttpRequest for the next (possibly pipelined) request,
+	*   the others are marked to be closed once the queue is flushed
+	*
+	* @param client_file_descriptor Socket the response belongs to
+	* @param http_response Response object containing headers and body
+	*/
+	void queue_http_response(int client_file_descriptor, HttpResponse& http_response);
+
+	/**
+	* @brief Sends the queued responses of the connection as far as the socket accepts them
+	*
+	* Pipelined responses leave in the order the requests arrived, gathered into
+	* one sendmsg() (the writev() equivalent that accepts MSG_NOSIGNAL), split in
+	* IOV_MAX sized groups if needed. Each response is a header block followed by
+	* its body, sent from where the handler left it. Static files are sent with
+	* sendfile() from their descriptor, at most a socket buffer at a time, the
+	* header block before them is sent with MSG_MORE to share their first packet.
+	*
+	* Partial writes:
+	* - The position inside the queue is remembered on the connection
+	* - The socket is switched to POLLOUT, handle_client_write() resumes the flush,
+	*   reading is paused meanwhile so a slow reader cannot grow the queue
+	* - Once everything is sent the socket goes back to POLLIN
 	*
 	* Error handling:
-	* - If send fails (returns -1 or 0):
+	* - If sending fails with anything but EAGAIN:
 	*   - Logs error
-	*   - Closes socket
-	*   - Removes client from HTTP request tracking
-	*   - Removes client from poll monitoring
+	*   - Closes the connection
+	* - A file that shrank after its length was announced closes the connection
+	* - Connections marked close_after_response are closed once the queue is empty,
+	*   those that refused a request start a lingering close instead
 	*
-	* @param client_file_descriptor Socket to send response to
-	* @param http_response Response object containing headers and body
+	* @param client_file_descriptor Socket to send the responses to
+	*/
+	void flush_http_responses(int client_file_descriptor);
+
+	/**
+	* @brief Closes the sending side once a refused request has been answered
+	*
+	* The client may still be sending the body of the refused request. Closing
+	* the socket with unread bytes makes the kernel reset the connection, which
+	* can destroy the response before the client reads it. The response is
+	* followed by a FIN instead, and whatever the client still sends is read and
+	* dropped, never buffered, until it closes or _LINGERING_TIMEOUT_SECONDS pass.
+	*
+	* @param client_connection The connection that refused its request
+	*/
+	void start_lingering_close(ClientConnection& client_connection);
+
+	/**
+	* @brief Answers Expect: 100-continue as soon as the header block is parsed
+	*
+	* The route, the method and, through the parser, the Content-Length have
+	* been checked by then:
+	* - Accepted: 100 Continue is queued ahead of the final response, it does
+	*   not count as one and leaves the request waiting for its body
+	* - Refused: the final response is queued instead and the connection closes
+	*   with a lingering close, the client is told not to send the body
+	*
+	* @param client_file_descriptor Socket connected to the client
+	* @param http_request The request whose body has not been sent yet
 	*/
-	void send_http_response(int client_file_descriptor, const HttpResponse& http_response);
+	void answer_http_request_expectation(int client_file_descriptor, const HttpRequest& http_request);
 
 	/**
 	* @brief Processes HTTP request by determining its method and generating appropriate response
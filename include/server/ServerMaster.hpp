@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "server/Server.hpp"
+#include "configuration/Parse.hpp"
+
+#define _LISTEN_FDS_ENVIRONMENT_VARIABLE		"WEBSERV_LISTEN_FDS"	/* Listening sockets passed to an upgraded binary */
+#define _READY_FD_ENVIRONMENT_VARIABLE			"WEBSERV_READY_FD"		/* Pipe the upgraded binary writes to once it serves */
+#define _UPGRADE_READY_TIMEOUT_MILLISECONDS		10000
+#define _SIGNAL_WAIT_MILLISECONDS				250						/* How often finished generations are reaped */
+
+/**
+* @brief The workers started from one parsed configuration
+*
+* A reload starts a new generation next to the running one, the old one
+* drains and is destroyed once all of its workers returned. The parser owns
+* the configuration, it is declared first so it outlives the servers.
+*/
+struct WorkerGeneration
+{
+	std::unique_ptr<Parse>					parser;
+	std::vector<std::unique_ptr<Server>>	servers;
+	std::vector<std::thread>				worker_threads;
+	std::atomic<size_t>						running_worker_count{0};
+	std::atomic<bool>						has_failed_worker{false};	/* Set by a worker whose event loop threw */
+};
+
+/**
+* @brief Owns the worker threads and reacts to the process signals
+*
+* The server signals are blocked in every thread and received synchronously
+* by the main thread, which runs no event loop itself:
+* - SIGINT, SIGTERM: fast shutdown, open connections are closed right away
+* - SIGQUIT: graceful shutdown, workers stop accepting and drain within shutdown_timeout
+* - SIGHUP: parses the configuration file again, a new generation of workers
+*   takes over the listening sockets and the old one drains
+* - SIGUSR2: execs the binary again, handing it the listening sockets, and
+*   drains this process once the new one reports it is serving
+*
+* The listening sockets are never closed and recreated along the way, so the
+* connections waiting in the kernel accept queues survive reloads and upgrades.
+*/
+class ServerMaster
+{
+public:
+	/**
+	* @brief Creates the master, nothing is started before run()
+	*
+	* @param configuration_path Configuration file, parsed again on every reload
+	* @param program_path Absolute path of the program, exec'd on upgrade
+	*/
+	ServerMaster(std::string configuration_path, std::string program_path);
+
+	/**
+	* @brief Stops and joins the workers still running, only happens when run() threw
+	*/
+	~ServerMaster();
+
+	ServerMaster(const ServerMaster&)				= delete;
+	ServerMaster& operator=(const ServerMaster&)	= delete;
+
+	/**
+	* @brief Starts the first generation and handles signals until every worker returned
+	*
+	* - Blocks the server signals before any worker thread exists, so they inherit the mask
+	* - Ignores SIGPIPE, sendfile() raises it when a client resets the connection mid-file
+	* - Adopts the listening sockets passed by a previous binary, if any
+	* - Tells the previous binary it can start draining
+	* - Waits for signals, reaping the generations whose workers all returned
+	* - Drains the other workers when one of the current generation fails
+	*
+	* @throws std::runtime_error If the configuration is invalid, no port can be listened on,
+	*                            or a worker of the current generation failed
+	*/
+	void run();
+
+private:
+	std::string	configuration_file_path;
+	std::string	executable_path;
+
+	std::vector<std::unique_ptr<WorkerGeneration>>	worker_generations;	/* The last one is current unless shutting down */
+	bool											is_shutting_down;
+	bool											has_failed_worker;	/* A worker of the current generation failed, run() reports it */
+
+	/**
+	* @brief Takes the descriptors listed in an environment variable set by a previous binary
+	*
+	* The variable is removed so CGI scripts do not see it, every descriptor
+	* gets its close-on-exec flag back.
+	*
+	* @param environment_variable Name of the variable holding comma separated descriptors
+	* @return std::vector<int> The descriptors, empty without the variable
+	*/
+	static std::vector<int> take_environment_file_descriptors(const char* environment_variable);
+
+	/**
+	* @brief Parses the configuration and starts one worker thread per configured worker
+	*
+	* @param inherited_server_file_descriptors Listening sockets the workers adopt instead of creating new ones
+	* @return std::unique_ptr<WorkerGeneration> The running generation
+	* @throws std::runtime_error If parsing fails or a worker has no port to listen on
+	*/
+	[[nodiscard]]
+	std::unique_ptr<WorkerGeneration> start_worker_generation(
+		std::vector<int>& inherited_server_file_descriptors) const;
+
+	/**
+	* @brief Gets the listening sockets of every worker of the current generation
+	*/
+	[[nodiscard]]
+	std::vector<int> get_current_server_file_descriptors() const;
+
+	/**
+	* @brief Joins the generations whose workers all returned, reports their accept counters and destroys them
+	*/
+	void reap_finished_generations();
+
+	/**
+	* @brief Handles SIGHUP
+	*
+	* The new generation gets duplicates of the current listening sockets, so
+	* the old workers can close theirs while draining without losing queued
+	* connections. A configuration that fails to parse is logged and ignored.
+	*/
+	void reload_configuration();
+
+	/**
+	* @brief Handles SIGUSR2
+	*
+	* Forks and execs executable_path with the listening sockets inherited
+	* (close-on-exec cleared in the child) and listed in _LISTEN_FDS_ENVIRONMENT_VARIABLE.
+	* The child keeps the blocked signal mask until its own master waits for them.
+	*
+	* @return bool True once the new binary reported it is serving, false if it failed to start
+	*/
+	bool upgrade_executable();
+
+	/**
+	* @brief Reacts to the workers that failed since the last call
+	*
+	* A failed worker no longer accepts or answers, and its listening sockets
+	* are closed with it. When it belongs to the current generation, the
+	* other workers are drained gracefully and run() then reports the
+	* failure. The other workers of an old, draining generation are left
+	* to finish.
+	*/
+	void handle_failed_workers();
+
+	/**
+	* @brief Asks every worker of every generation to stop
+	*
+	* @param graceful True to drain within shutdown_timeout, false to close the connections right away
+	*/
+	void shutdown_generations(bool graceful);
+};
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <ctime>
+#include <string_view>
+#include <unordered_map>
+
+#include "http/HttpResponse.hpp"
+#include "server/TimerWheel.hpp"
+
+#define _STATIC_FILE_CACHE_MAX_ENTRIES		256		/* Every regular file entry keeps its descriptor open */
+#define _STATIC_FILE_CACHE_VALID_SECONDS	5		/* Checked again after this, whether or not inotify reported a change */
+
+/**
+* @brief What a path turned out to be when it was last checked
+*/
+enum class StaticFileType : uint8_t
+{
+	MISSING,
+	REGULAR,
+	DIRECTORY,
+	OTHER		/* FIFO, socket or device, never served */
+};
+
+/**
+* @brief What the static GET path needs to know about a path, gathered once
+*
+* A regular file is kept open, its responses share the descriptor, and
+* for content cache routes its bytes are kept too. A directory remembers
+* which index file it resolved to.
+*/
+struct StaticFileEntry
+{
+	std::string								path;
+	StaticFileType							type = StaticFileType::MISSING;
+	std::shared_ptr<const HttpResponseFile>	file;
+	size_t									size = 0;
+	time_t									modification_time = 0;
+	std::string								content_type;
+	std::shared_ptr<const std::string>		response_content;	/* Content-Type, Content-Length, the empty line and the body */
+	std::string								index_file_name;	/* Index the directory was resolved for */
+	std::string								index_path;			/* Resolved index file, empty when there is none */
+	bool									is_index_resolved = false;
+	int										watch_descriptor = -1;
+	TimerWheel::Clock::time_point			expiry_time;
+};
+
+/**
+* @brief Bounded, per worker cache of the paths the static GET path resolves
+*
+* A hit answers with no stat(), open() or index lookup at all. Entries are
+* evicted least recently used first once the cache is full, and are checked
+* again once _STATIC_FILE_CACHE_VALID_SECONDS have passed.
+*
+* The directory of every entry is watched with inotify, its descriptor is
+* polled by the worker's event loop and a change drops the entries it
+* concerns right away: the file named by the event and the directory's own
+* entry, or every entry of the directory when the directory itself goes.
+* Renames further up the tree are not reported, the expiry covers them.
+*
+* Paths are keyed after dropping a leading "./" and repeated or trailing
+* slashes, so the GET, upload and DELETE handlers agree on them.
+*
+* Small files of content cache routes are also held in memory, as the end
+* of their response: the headers describing the body, then the body. They
+* share the entry's invalidation. Their total size is bounded by the
+* content cache size, the contents of the least recently used entries are
+* dropped to make room.
+*
+* References returned by lookup() stay valid until the next call to any
+* other member.
+*/
+class StaticFileCache
+{
+public:
+	/**
+	* @brief Creates the cache and its inotify descriptor
+	*
+	* Without inotify (limit reached, unsupported filesystem) the cache still
+	* works, entries then only expire.
+	*/
+	StaticFileCache();
+	~StaticFileCache();
+
+	StaticFileCache(const StaticFileCache&)				= delete;
+	StaticFileCache& operator=(const StaticFileCache&)	= delete;
+
+	/**
+	* @brief Gets the entry of a path, checking the filesystem only on a miss or once it expired
+	*
+	* Paths are opened (O_RDONLY | O_NONBLOCK | O_CLOEXEC) and their type,
+	* size and modification time are taken from the open descriptor, only
+	* regular files keep it. A regular file that cannot be opened (permissions)
+	* has no file. Missing paths are not kept, requests for random names must
+	* not push the hot files out.
+	*
+	* When content_max_size is given, a regular file up to that size gets its
+	* response_content, read once with pread() on the cached descriptor.
+	*
+	* @param path Path of the file or directory
+	* @param content_max_size Largest file kept in memory, 0 to keep none
+	* @return const StaticFileEntry& The entry
+	*/
+	const StaticFileEntry& lookup(std::string_view path, size_t content_max_size = 0);
+
+	/**
+	* @brief Gets the index file served for a directory
+	*
+	* Tries index_file_name, then index.html, like the directory handler always
+	* did. The answer is kept on the directory's entry until it changes.
+	*
+	* @param directory_path Path of the directory
+	* @param index_file_name Index file of the route, may be empty
+	* @return std::string The path of the index file, empty when the directory has none
+	*/
+	[[nodiscard]]
+	std::string resolve_directory_index(std::string_view directory_path, const std::string& index_file_name);
+
+	/**
+	* @brief Drops the entry of a path and its directory's, used after the server itself changes a file
+	*
+	* inotify reports the same change, but only once the worker is back in
+	* its event loop, too late for a request pipelined right behind.
+	*
+	* @param path Path of the file that was created, replaced or removed
+	*/
+	void invalidate(std::string_view path);
+
+	/**
+	* @brief Reads the pending inotify events and drops the entries they concern
+	*
+	* Called by the worker when the inotify descriptor is readable.
+	*/
+	void handle_file_events();
+
+	/**
+	* @brief Gets the inotify descriptor to poll, -1 without inotify
+	*/
+	[[nodiscard]] __attribute__((always_inline))
+	int get_inotify_file_descriptor() const noexcept
+	{
+		return inotify_file_descriptor;
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	size_t size() const noexcept
+	{
+		return entries.size();
+	}
+
+	/**
+	* @brief Sets how many bytes of file contents the cache may hold
+	*
+	* @param size The budget in bytes, 0 disables the content cache
+	*/
+	__attribute__((always_inline))
+	void set_content_cache_size(const size_t size) noexcept
+	{
+		content_cache_size = size;
+	}
+
+private:
+	struct WatchedDirectory
+	{
+		std::string	path;
+		size_t		entry_count = 0;
+	};
+
+	/* Most recently used first, nodes never move so the index can point into them */
+	std::list<StaticFileEntry>															entries;
+	std::unordered_map<std::string_view, std::list<StaticFileEntry>::iterator>			entry_index;
+	std::unordered_map<int, WatchedDirectory>											watched_directories;
+
+	int				inotify_file_descriptor;
+	std::string		lookup_key;		/* Reused for every lookup, no allocation once grown */
+	StaticFileEntry	missing_entry;	/* Returned for every path that does not exist */
+
+	size_t	content_cache_size	= 0;
+	size_t	content_size		= 0;	/* Bytes held by the response_content of every entry */
+
+	/**
+	* @brief Writes the key of a path into lookup_key
+	*/
+	void make_lookup_key(std::string_view path);
+
+	/**
+	* @brief Fills an entry from the filesystem
+	*
+	* Runs out of descriptors by emptying the cache once and trying again.
+	*/
+	void load_entry(StaticFileEntry& entry);
+
+	/**
+	* @brief Reads a file into its entry's response_content, makes room within the budget first
+	*
+	* Files that do not fit the budget, or shrink while read, are left to sendfile().
+	*/
+	void load_entry_content(StaticFileEntry& entry);
+
+	/**
+	* @brief Drops the response_content of an entry, responses still sending it keep their reference
+	*/
+	void release_entry_content(StaticFileEntry& entry) noexcept;
+
+	/**
+	* @brief Watches the directory an entry depends on, its own path for a directory
+	*/
+	void watch_entry(StaticFileEntry& entry);
+
+	/**
+	* @brief Forgets an entry, stops watching its directory when it was the last one there
+	*/
+	void erase_entry(std::list<StaticFileEntry>::iterator entry);
+
+	/**
+	* @brief Forgets the entry of the key, if any
+	*/
+	void erase_entry(std::string_view key);
+
+	/**
+	* @brief Forgets every entry, closing the descriptors no response is still sending from
+	*/
+	void clear();
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#define _TIMER_WHEEL_TICK_MILLISECONDS	100		/* Timer resolution */
+#define _TIMER_WHEEL_SLOT_BITS			6		/* 64 slots per level */
+#define _TIMER_WHEEL_LEVELS				4		/* 64^4 ticks, about 19 days */
+
+/**
+* @brief Hierarchical timer wheel keyed by file descriptor
+*
+* Every key owns at most one timer. Level 0 has one slot per tick, each
+* higher level has slots covering 64 times the span of the level below, and
+* its timers are cascaded one level down when the wheel reaches their slot.
+*
+* Timers are intrusive doubly linked list nodes stored in a vector indexed
+* by key, so scheduling and cancelling are O(1) with no allocation once the
+* vector has grown to the highest descriptor.
+*/
+class TimerWheel
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	TimerWheel();
+
+	/**
+	* @brief Starts (or restarts) the timer of a key
+	*
+	* @param key The file descriptor the timer belongs to
+	* @param delay Time from now until the timer expires, rounded up to the next tick
+	*/
+	void schedule(int key, std::chrono::milliseconds delay);
+
+	/**
+	* @brief Stops the timer of a key, keys without a timer are ignored
+	*
+	* @param key The file descriptor the timer belongs to
+	*/
+	void cancel(int key) noexcept;
+
+	/**
+	* @brief Moves the wheel up to the current time and collects the expired keys
+	*
+	* Expired timers are removed before they are reported, so the caller
+	* may schedule them again right away.
+	*
+	* @param expired_keys Output vector, cleared and filled with the expired keys
+	*/
+	void advance(std::vector<int>& expired_keys);
+
+	/**
+	* @brief Gets how long the event loop may block before the wheel needs to advance
+	*
+	* Scans at most the rest of level 0, so the cost is bounded. When level 0 is
+	* empty the answer is the next cascade point, where higher level timers move down.
+	*
+	* @return The timeout in milliseconds, -1 when no timer is pending
+	*/
+	[[nodiscard]]
+	int get_wait_timeout_milliseconds() const;
+
+	[[nodiscard]] __attribute__((always_inline))
+	bool is_scheduled(const int key) const noexcept
+	{
+		return static_cast<size_t>(key) < timer_nodes.size()
+			&& timer_nodes[static_cast<size_t>(key)].slot >= 0;
+	}
+
+	[[nodiscard]] __attribute__((always_inline))
+	size_t size() const noexcept
+	{
+		return timer_count;
+	}
+
+private:
+	static constexpr size_t		_SLOTS_PER_LEVEL	= size_t(1) << _TIMER_WHEEL_SLOT_BITS;
+	static constexpr uint64_t	_SLOT_MASK			= _SLOTS_PER_LEVEL - 1;
+
+	struct TimerNode
+	{
+		uint64_t	expiry_tick	= 0;
+		int32_t		previous	= -1;
+		int32_t		next		= -1;
+		int32_t		slot		= -1;	/* Index in slot_heads, -1 when not scheduled */
+	};
+
+	Clock::time_point	start_time;
+	uint64_t			current_tick;
+	size_t				timer_count;
+
+	std::vector<TimerNode>										timer_nodes;
+	std::array<int32_t, _TIMER_WHEEL_LEVELS * _SLOTS_PER_LEVEL>	slot_heads;
+
+	/**
+	* @brief Converts a point in time to a tick
+	*
+	* Expiry ticks are rounded up so a timer never fires early,
+	* the wheel itself only advances over ticks that have fully started.
+	*/
+	[[nodiscard]]
+	uint64_t get_tick(Clock::time_point time_point, bool round_up) const noexcept;
+
+	/**
+	* @brief Links a node into the slot matching its expiry tick
+	*
+	* The level is the lowest one whose span still contains both the current
+	* tick and the expiry tick, so every slot is reached before it is due.
+	* Cascaded timers may be due on the current tick, whose slot is processed next.
+	*/
+	void link_timer(int key, uint64_t expiry_tick) noexcept;
+
+	/**
+	* @brief Unlinks a node from its slot
+	*/
+	void unlink_timer(int key) noexcept;
+
+	/**
+	* @brief Moves every timer of a higher level slot into the levels below
+	*/
+	void cascade_slot(size_t level, size_t slot_index) noexcept;
+};
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <linux/io_uring.h>
+
+#include "server/EventLoop.hpp"
+
+#define _URING_SUBMISSION_ENTRIES	4096	/* Submission queue slots */
+#define _URING_COMPLETION_ENTRIES	65536	/* Completion queue slots, kernel maximum */
+
+/**
+* @brief Readiness event loop on io_uring
+*
+* Only one-shot IORING_OP_POLL_ADD and IORING_OP_POLL_REMOVE requests are
+* submitted, the sockets are still read and written by the server with
+* their own syscalls. Registration changes ride along with the wait, which
+* spares the epoll_ctl() calls of connection churn, but the syscall count
+* is the same as with poll().
+*/
+class UringEventLoop final : public EventLoop
+{
+public:
+	/**
+	* @brief Creates the io_uring instance and maps its rings
+	*
+	* Talks to the kernel through the raw io_uring_setup() and io_uring_enter()
+	* syscalls, no external library is needed.
+	*
+	* @throws std::runtime_error If the kernel does not support io_uring
+	*                            or lacks the extended wait argument (Linux 5.11+)
+	*/
+	UringEventLoop();
+
+	/**
+	* @brief Unmaps the rings and closes the io_uring instance
+	*/
+	~UringEventLoop() override;
+
+	UringEventLoop(const UringEventLoop&)				= delete;
+	UringEventLoop& operator=(const UringEventLoop&)	= delete;
+
+	/**
+	* @brief Queues a poll request for the descriptor
+	*
+	* Nothing is submitted yet, the request is sent together with every other
+	* pending change by the next wait_for_events() call.
+	*
+	* @param file_descriptor The descriptor to watch
+	* @param events The poll() interest mask
+	*/
+	void add_file_descriptor(int file_descriptor, uint32_t events) override;
+
+	/**
+	* @brief Changes the interest mask of the descriptor
+	*
+	* Cancels the outstanding poll request if there is one and queues
+	* a new one with the updated mask.
+	*
+	* @param file_descriptor The descriptor to update
+	* @param events The new poll() interest mask
+	*/
+	void modify_file_descriptor(int file_descriptor, uint32_t events) override;
+
+	/**
+	* @brief Stops watching the descriptor
+	*
+	* Queues the cancellation of its poll request, completions that
+	* arrive afterwards are recognized as stale and dropped.
+	*
+	* @param file_descriptor The descriptor to remove
+	*/
+	void remove_file_descriptor(int file_descriptor) override;
+
+	/**
+	* @brief Submits all queued changes and waits for completions in one io_uring_enter()
+	*
+	* Poll requests are one-shot, so every reported descriptor is re-armed
+	* by the following call, which keeps the level-triggered semantics the
+	* server handlers rely on without any extra syscall.
+	*
+	* @param ready_events Output vector that receives the ready descriptors
+	* @param timeout_milliseconds Maximum time to block, -1 blocks indefinitely
+	* @return The number of ready descriptors
+	* @throws std::runtime_error If io_uring_enter() fails
+	*/
+	size_t wait_for_events(
+		std::vector<EventLoopEvent>&	ready_events,
+		int								timeout_milliseconds) override;
+
+	[[nodiscard]] __attribute__((always_inline))
+	const char* get_backend_name() const noexcept override
+	{
+		return "io_uring";
+	}
+
+private:
+	/**
+	* @brief Per descriptor bookkeeping, indexed by file descriptor
+	*
+	* The generation is part of every poll request's user data, so
+	* completions of cancelled or replaced requests can be ignored.
+	*/
+	struct UringFileDescriptorState
+	{
+		uint32_t	events		= 0;
+		uint32_t	generation	= 0;
+		bool		registered	= false;
+		bool		armed		= false;
+		bool		pending		= false;
+	};
+
+	int				uring_file_descriptor;
+
+	void*			submission_ring;
+	void*			completion_ring;
+	io_uring_sqe*	submission_entries;
+
+	size_t			submission_ring_size;
+	size_t			completion_ring_size;
+	size_t			submission_entries_size;
+
+	uint32_t*		submission_head;
+	uint32_t*		submission_tail;
+	uint32_t*		submission_mask;
+	uint32_t*		submission_array;
+
+	uint32_t*		completion_head;
+	uint32_t*		completion_tail;
+	uint32_t*		completion_mask;
+	io_uring_cqe*	completion_entries;
+
+	uint32_t		queued_submissions;
+
+	std::vector<UringFileDescriptorState>	file_descriptor_states;
+	std::vector<int>						pending_file_descriptors;
+	std::vector<io_uring_cqe>				deferred_completions;	/* Taken off a full ring to let submissions through */
+
+	/**
+	* @brief Unmaps the rings and closes the io_uring descriptor, safe to call twice
+	*/
+	void release_uring_resources() noexcept;
+
+	/**
+	* @brief Gets the state slot of a descriptor, growing the table when needed
+	*
+	* @param file_descriptor The descriptor to look up
+	* @return Reference to the descriptor's state
+	*/
+	UringFileDescriptorState& get_file_descriptor_state(int file_descriptor);
+
+	/**
+	* @brief Reserves the next submission queue entry
+	*
+	* Flushes the queue to the kernel first when it is full, and keeps
+	* flushing until the kernel has taken entries off it. An entry is never
+	* reused before the kernel consumed it. When the kernel refuses new
+	* submissions because the completion ring is full (EBUSY), the pending
+	* completions are moved to deferred_completions first, the next
+	* wait_for_events() reports them.
+	*
+	* @return Zeroed submission entry ready to be filled
+	*/
+	io_uring_sqe* get_submission_entry();
+
+	/**
+	* @brief Moves every completion of the ring to deferred_completions
+	*/
+	void defer_completions();
+
+	/**
+	* @brief Re-arms the descriptor of a completion and reports it, stale completions are dropped
+	*
+	* @param completion_entry The completion
+	* @param ready_events Output vector that receives the ready descriptor
+	*/
+	void handle_completion(const io_uring_cqe& completion_entry, std::vector<EventLoopEvent>& ready_events);
+
+	/**
+	* @brief Queues the cancellation of the descriptor's outstanding poll request
+	*
+	* @param file_descriptor The descriptor whose request should be cancelled
+	* @param state The descriptor's state
+	*/
+	void queue_poll_remove(int file_descriptor, UringFileDescriptorState& state);
+
+	/**
+	* @brief Queues poll requests for every registered descriptor that is not armed
+	*/
+	void queue_pending_poll_requests();
+
+	/**
+	* @brief Calls io_uring_enter() with the queued submissions
+	*
+	* @param minimum_completions Completions to wait for, 0 only submits
+	* @param timeout_milliseconds Maximum time to block, -1 blocks indefinitely
+	* @return false if the wait timed out or was interrupted
+	* @throws std::runtime_error If io_uring_enter() fails
+	*/
+	bool enter_uring(uint32_t minimum_completions, int timeout_milliseconds);
+};
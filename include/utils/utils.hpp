@@ -1,7 +1,5 @@
 #pragma once
 
-#include "server/Server.hpp"
-
 #include <string>
 
 namespace Utils
@@ -20,12 +18,29 @@ namespace Utils
 	std::string read_file(const std::string& file_path);
 
 	/**
-	 * Registers a signal handler function for SIGINT and SIGQUIT
-	 * such that the server can exit gracefully.
+	 * Blocks SIGINT, SIGTERM, SIGQUIT, SIGHUP and SIGUSR2 in the calling thread.
+	 * Called before the worker threads are created so they inherit the mask,
+	 * the signals are then only received through wait_for_server_signal().
+	 * No handler runs asynchronously, so reacting to a signal may allocate and lock.
+	 *
+	 * @throws std::runtime_error If the signal mask cannot be changed
+	 */
+	void block_server_signals();
+
+	/**
+	 * Unblocks the server signals again and restores the default SIGPIPE
+	 * action the server ignores. Async-signal-safe, meant for forked children
+	 * right before execve(), which would otherwise inherit both.
+	 */
+	void unblock_server_signals() noexcept;
+
+	/**
+	 * Waits for one of the blocked server signals.
+	 *
+	 * @param timeout_milliseconds Longest time to wait
+	 * @return The signal number, 0 if none arrived in time
 	 *
-	 * @param instance The server instance required to stop it
-	 * 
-	 * @throws std::runtime_error If assigning the handler fails
+	 * @throws std::runtime_error If waiting fails
 	 */
-	void register_signal_handler(Server* instance);
+	int wait_for_server_signal(int timeout_milliseconds);
 }
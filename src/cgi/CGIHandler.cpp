@@ -1,5 +1,6 @@
 #include <cstring>
 #include <fcntl.h>
+#include <vector>
 #include <sstream>
 #include <cstdlib>
 #include <iostream>
@@ -10,6 +11,7 @@
 #include <sys/stat.h>
 
 #include "cgi/CGIHandler.hpp"
+#include "utils/utils.hpp"
 
 CGIHandler::CGIHandler(const std::string& script, const std::string& exec)
 						: script_path(script), cgi_executable(exec)
@@ -65,13 +67,15 @@ void CGIHandler::setup_environment(const HttpRequest& request) const
 
 	if (request.get_http_request_method() == HttpMethod::POST)
 	{
-		environment["CONTENT_LENGTH"]	= request.get_http_request_header("Content-Length");
-		environment["CONTENT_TYPE"]		= request.get_http_request_header("Content-Type");
+		/* The decoded size, a chunked request has no Content-Length header */
+		environment["CONTENT_LENGTH"]	= std::to_string(request.get_http_request_body_length());
+		environment["CONTENT_TYPE"]		= request.get_http_request_header(HttpHeader::CONTENT_TYPE);
 	}
 
-	for (const auto& header : request.get_http_request_headers())
+	request.for_each_http_request_header([this](const std::string_view name, const std::string_view value)
 	{
-		std::string header_name = "HTTP_" + header.first;
+		std::string header_name = "HTTP_";
+		header_name += name;
 
 		std::transform(
 			header_name.begin(), header_name.end(), header_name.begin(),
@@ -80,8 +84,8 @@ void CGIHandler::setup_environment(const HttpRequest& request) const
 
 		std::replace(header_name.begin(), header_name.end(), '-', '_');
 
-		environment[header_name] = header.second;
-	}
+		environment[header_name] = value;
+	});
 
 	if (environment["REQUEST_METHOD"].empty())
 		environment["REQUEST_METHOD"] = "GET";
@@ -95,97 +99,117 @@ void CGIHandler::setup_environment(const HttpRequest& request) const
 	std::cerr << "==================================\n";
 }
 
-std::string CGIHandler::unchunk_request_body(const std::string& chunked_body) const
+bool CGIHandler::file_exists(const std::string &file_path) const
 {
-	std::istringstream stream(chunked_body);
-
-	std::string result;
-	std::string line;
+	struct stat file_status = {};
+	return !stat(file_path.c_str(), &file_status);
+}
 
-	size_t chunk_size;
+std::string CGIHandler::execute_cgi_script(const std::string& request_body, const int request_body_file_descriptor) const
+{
+	/*
+		Everything that allocates is prepared before fork(), other worker
+		threads may hold allocator locks that the child would inherit.
+	*/
+	char absolute_path[PATH_MAX];
 
-	while (std::getline(stream, line))
-	{
-		if (!line.empty() && line[line.length() - 1] == '\r')
-			line = line.substr(0, line.length() - 1);
+	if (realpath(script_path.c_str(), absolute_path) == nullptr)
+		throw std::runtime_error("Failed to resolve real path for script");
 
-		std::istringstream(line) >> std::hex >> chunk_size;
+	const std::string absolute_script_path(absolute_path);
 
-		if (!chunk_size)
-			break;
+	if (!file_exists(absolute_script_path) || access(absolute_script_path.c_str(), X_OK) != 0)
+		throw std::runtime_error("CGI script is missing or not executable: " + absolute_script_path);
 
-		/* Note heap usage */
-		char* chunk = new char[chunk_size];
+	if (!file_exists(cgi_executable) || access(cgi_executable.c_str(), X_OK) != 0)
+		throw std::runtime_error("CGI executable is missing or not executable: " + cgi_executable);
 
-		stream.read(chunk, static_cast<std::streamsize>(chunk_size));
-		result.append(chunk, chunk_size);
+	std::vector<std::string>	environment_strings;
+	std::vector<char*>			environment_pointers;
 
-		delete[] chunk;
+	/* The script inherits the server environment, CGI variables take precedence */
+	for (char** inherited = environ; *inherited; ++inherited)
+	{
+		const std::string	inherited_string(*inherited);
+		const size_t		equals_position = inherited_string.find('=');
 
-		stream.ignore(2);
+		if (!environment.contains(inherited_string.substr(0, equals_position)))
+			environment_strings.push_back(inherited_string);
 	}
 
-	return result;
-}
+	for (const auto& env : environment)
+		environment_strings.push_back(env.first + "=" + env.second);
 
-bool CGIHandler::file_exists(const std::string &file_path) const
-{
-	struct stat file_status = {};
-	return !stat(file_path.c_str(), &file_status);
-}
+	for (std::string& environment_string : environment_strings)
+		environment_pointers.push_back(environment_string.data());
+
+	environment_pointers.push_back(nullptr);
+
+	char* const argument_pointers[] = {
+		const_cast<char*>(cgi_executable.c_str()),
+		const_cast<char*>(absolute_script_path.c_str()),
+		nullptr
+	};
 
-std::string CGIHandler::execute_cgi_script(const std::string& request_body) const
-{
 	int input_pipe[2];
 	int output_pipe[2];
 
-	if (pipe(input_pipe) < 0 || pipe(output_pipe) < 0)
+	/*
+		Close-on-exec, other workers fork scripts at the same time: a script
+		holding another one's write ends would keep its stdin open and its
+		stdout from ever reaching EOF. dup2() clears the flag on stdin and stdout.
+	*/
+	if (pipe2(input_pipe, O_CLOEXEC) < 0)
 		throw std::runtime_error(
 			"Failed to create pipes"
 		);
 
+	if (pipe2(output_pipe, O_CLOEXEC) < 0)
+	{
+		close(input_pipe[0]);
+		close(input_pipe[1]);
+
+		throw std::runtime_error(
+			"Failed to create pipes"
+		);
+	}
+
 	const pid_t pid = fork();
 
 	if (pid < 0)
+	{
+		close(input_pipe[0]);
+		close(input_pipe[1]);
+		close(output_pipe[0]);
+		close(output_pipe[1]);
+
 		throw std::runtime_error(
 			"Fork failed"
 		);
+	}
 
 	if (!pid)
 	{
 		close(input_pipe[1]);
 		close(output_pipe[0]);
 
-		dup2(input_pipe[0],		STDIN_FILENO);
-		dup2(output_pipe[1],	STDOUT_FILENO);
-
-		char absolute_path[PATH_MAX];
-
-		if (realpath(script_path.c_str(), absolute_path) == nullptr)
-			exit(1);
-
-		std::string absolute_script_path(absolute_path);
+		/* The script reads a spooled body from the file itself, at its own pace */
+		if (request_body_file_descriptor >= 0)
+			dup2(request_body_file_descriptor, STDIN_FILENO);
+		else
+			dup2(input_pipe[0], STDIN_FILENO);
 
-		if (chdir(script_directory.c_str()) != 0)				exit(1);
-		if (!file_exists(absolute_script_path))					exit(1);
-		if (!file_exists(cgi_executable))						exit(1);
-		if (access(absolute_script_path.c_str(), X_OK) != 0)	exit(1);
-		if (access(cgi_executable.c_str(), X_OK) != 0)			exit(1);
+		dup2(output_pipe[1], STDOUT_FILENO);
 
-		for (const auto& env : environment)
-			std::cerr << env.first << "=" << env.second << "\n";
+		if (chdir(script_directory.c_str()) != 0)
+			_exit(1);
 
-		for (const auto& env : environment)
-			setenv(env.first.c_str(), env.second.c_str(), 1);
+		/* The mask survives execve(), the script must react to signals normally */
+		Utils::unblock_server_signals();
 
-		execl(
-			cgi_executable.c_str(),
-			cgi_executable.c_str(),
-			absolute_script_path.c_str(),
-			NULL
-		);
+		execve(cgi_executable.c_str(), argument_pointers, environment_pointers.data());
 
-		exit(1);
+		_exit(1);
 	}
 
 	close(input_pipe[0]);
@@ -240,28 +264,31 @@ void CGIHandler::handle_request(const HttpRequest& request, HttpResponse& respon
 	{
 		setup_environment(request);
 
-		std::string request_body = "";
+		static const std::string no_request_body;
 
-		if (request.get_http_request_method() == HttpMethod::POST)
-		{
-			request_body = request.get_http_request_body();
+		/* Chunked bodies were already decoded by the parser, the body is passed without a copy */
+		const std::string& request_body	= request.get_http_request_method() == HttpMethod::POST
+										? request.get_http_request_body() : no_request_body;
 
-			if (request.get_http_request_header("Transfer-Encoding") == "chunked")
-				request_body = unchunk_request_body(request_body);
-		}
+		const int request_body_file_descriptor	= request.get_http_request_method() == HttpMethod::POST &&
+												  request.is_http_request_body_spooled()
+												? request.get_http_request_body_spool().get_file_descriptor() : -1;
+
+		/* The child shares the file offset, it starts reading from the beginning */
+		if (request_body_file_descriptor >= 0)
+			lseek(request_body_file_descriptor, 0, SEEK_SET);
 
-		const std::string	cgi_output = execute_cgi_script(request_body);
-		const size_t		header_end = cgi_output.find("\r\n\r\n");
+		std::string		cgi_output = execute_cgi_script(request_body, request_body_file_descriptor);
+		const size_t	header_end = cgi_output.find("\r\n\r\n");
 
 		if (header_end == std::string::npos)
 		{
 			response.set_http_response_content_type("text/html");
-			response.set_http_response_body(cgi_output);
+			response.set_http_response_body(std::move(cgi_output));
 		}
 		else
 		{
-			const std::string headers	= cgi_output.substr(0, header_end);
-			const std::string body		= cgi_output.substr(header_end + 4);
+			const std::string headers = cgi_output.substr(0, header_end);
 
 			std::istringstream	header_stream(headers);
 			std::string			header_line;
@@ -285,7 +312,9 @@ void CGIHandler::handle_request(const HttpRequest& request, HttpResponse& respon
 				}
 			}
 
-			response.set_http_response_body(body);
+			/* The output becomes the body in place, the headers are small */
+			cgi_output.erase(0, header_end + 4);
+			response.set_http_response_body(std::move(cgi_output));
 		}
 
 		response.set_http_response_status_code(HttpStatusCode::HTTP_200_OK);
@@ -5,6 +5,7 @@
 #include <charconv>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <thread>
 #include <filesystem>
 #include <unordered_map>
 
@@ -27,6 +28,129 @@ static inline bool is_path_safe(const std::string& path)
 	return true;
 }
 
+static std::string get_directive_value(const std::string& line, const std::string& keyword)
+{
+	size_t value_start = line.find(keyword);
+
+	if (value_start == std::string::npos)
+		throw std::runtime_error(
+			"Keyword '" + keyword + "' not found"
+		);
+
+	value_start += keyword.length();
+
+	const size_t semicolon_pos = line.find(';', value_start);
+
+	if (semicolon_pos == std::string::npos)
+		throw std::runtime_error(
+			"Invalid " + keyword + " format: Missing semicolon"
+		);
+
+	std::string value = line.substr(value_start, semicolon_pos - value_start);
+
+	const size_t first_not_space	= value.find_first_not_of(" \t");
+	const size_t last_not_space		= value.find_last_not_of(" \t");
+
+	if (first_not_space == std::string::npos)
+		throw std::runtime_error(
+			"Value of " + keyword + " is empty"
+		);
+
+	return value.substr(first_not_space, last_not_space - first_not_space + 1);
+}
+
+/**
+ * @brief Converts a directive value to a number within the given range
+ *
+ * @param value The directive value, digits only
+ * @param minimum The smallest accepted number
+ * @param maximum The largest accepted number
+ * @param description What the number is, used in error messages
+ * @return size_t The parsed number
+ * @throws std::runtime_error If the value is not a number or out of range
+ */
+static size_t get_bounded_directive_number(
+	const std::string&	value,
+	const size_t		minimum,
+	const size_t		maximum,
+	const std::string&	description)
+{
+	size_t number = 0;
+
+	auto[ptr, ec] = std::from_chars(
+		value.data(),
+		value.data() + value.size(),
+		number
+	);
+
+	if (ec != std::errc() || ptr != value.data() + value.size())
+		throw std::runtime_error(
+			description + " must be a number"
+		);
+
+	if (number < minimum || number > maximum)
+		throw std::runtime_error(
+			description + " must be between "
+			+ std::to_string(minimum) + " and "
+			+ std::to_string(maximum)
+		);
+
+	return number;
+}
+
+/**
+ * @brief Reads a timeout directive in seconds, an optional 's' suffix is accepted
+ *
+ * @param line The configuration line
+ * @param keyword The directive name
+ * @param minimum The smallest accepted timeout
+ * @param maximum The largest accepted timeout
+ * @return size_t The timeout in seconds
+ * @throws std::runtime_error If the value is missing, not a number or out of range
+ */
+static size_t get_timeout_directive_seconds(
+	const std::string&	line,
+	const std::string&	keyword,
+	const size_t		minimum,
+	const size_t		maximum)
+{
+	std::string value = get_directive_value(line, keyword);
+
+	if (value.length() > 1 && value.back() == 's')
+		value.pop_back();
+
+	return get_bounded_directive_number(value, minimum, maximum, "Timeout");
+}
+
+/**
+ * @brief Reads a size directive in bytes, a 'K' or 'M' suffix is accepted like for the other sizes
+ *
+ * @param line The configuration line
+ * @param keyword The directive name
+ * @param minimum The smallest accepted size in bytes
+ * @param maximum The largest accepted size in bytes
+ * @return size_t The size in bytes
+ * @throws std::runtime_error If the value is missing, not a number or out of range
+ */
+static size_t get_size_directive_bytes(
+	const std::string&	line,
+	const std::string&	keyword,
+	const size_t		minimum,
+	const size_t		maximum)
+{
+	std::string	value		= get_directive_value(line, keyword);
+	size_t		multiplier	= 1;
+
+	if (value.length() > 1 && (value.back() == 'K' || value.back() == 'M'))
+	{
+		multiplier = value.back() == 'M' ? 1024 * 1024 : 1024;
+		value.pop_back();
+	}
+
+	/* Bounded before multiplying, so the product cannot overflow */
+	return get_bounded_directive_number(value, minimum / multiplier, maximum / multiplier, "Size") * multiplier;
+}
+
 Parse::Parse(std::string file_path)
 	:	server_configuration_file_path(std::move(file_path)),
 		server_configuration(new ServerConfiguration())
@@ -79,7 +203,11 @@ void Parse::parse_server_block(std::istream& file_path) const
 		if (first_line.empty())
 			continue;
 			
-		if (first_line.find("listen") != std::string::npos)
+		std::string first_keyword;
+		std::istringstream(first_line) >> first_keyword;
+
+		/* Compare the whole keyword, listen_backlog must not be taken for the port */
+		if (first_keyword == "listen")
 		{
 			size_t last_space = first_line.find_last_of(" \t");
 
@@ -544,11 +672,15 @@ void Parse::parse_max_post_request_size(const std::string& line) const
 			tmp
 		);
 
-		if (ec == std::errc())
-			if (tmp > std::numeric_limits<size_t>::max() / multiplier)
-				throw std::runtime_error(
-					"Max post request size is out of range"
-				);
+		if (ec != std::errc() || ptr != size_string.data() + size_string.size())
+			throw std::runtime_error(
+				"Max post request size is not a number"
+			);
+
+		if (tmp > std::numeric_limits<size_t>::max() / multiplier)
+			throw std::runtime_error(
+				"Max post request size is out of range"
+			);
 
 		server_configuration->set_max_post_request_size(tmp * multiplier);
 	}
@@ -1380,6 +1512,352 @@ void Parse::parse_redirect(const std::string& line) const
 	}
 }
 
+void Parse::parse_event_backend(const std::string& line) const
+{
+	try
+	{
+		if (line.empty())
+			throw std::runtime_error(
+				"Invalid argument provided."
+			);
+
+		const std::string value = get_directive_value(line, "event_backend");
+
+		if (value == "epoll")
+			server_configuration->set_event_loop_backend(EventLoopBackend::EPOLL);
+
+		else if (value == "poll")
+			server_configuration->set_event_loop_backend(EventLoopBackend::POLL);
+
+		else if (value == "io_uring")
+			server_configuration->set_event_loop_backend(EventLoopBackend::IO_URING);
+
+		else
+			throw std::runtime_error(
+				"Unknown backend '" + value + "'. Options are 'poll', 'epoll' or 'io_uring'"
+			);
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing event backend: "
+			+ std::string(e.what())
+		);
+	}
+}
+
+void Parse::parse_worker_threads(const std::string& line) const
+{
+	try
+	{
+		if (line.empty())
+			throw std::runtime_error(
+				"Invalid argument provided."
+			);
+
+		const std::string value = get_directive_value(line, "worker_threads");
+
+		if (value == "auto")
+		{
+			server_configuration->set_worker_thread_count(std::thread::hardware_concurrency());
+			return;
+		}
+
+		const size_t worker_thread_count = get_bounded_directive_number(
+			value, 1, _MAX_WORKER_THREADS, "Worker thread count"
+		);
+
+		server_configuration->set_worker_thread_count(worker_thread_count);
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing worker threads: "
+			+ std::string(e.what())
+		);
+	}
+}
+
+void Parse::parse_keepalive_timeout(const std::string& line) const
+{
+	try
+	{
+		if (line.empty())
+			throw std::runtime_error(
+				"Invalid argument provided."
+			);
+
+		server_configuration->set_keepalive_timeout(get_timeout_directive_seconds(
+			line, "keepalive_timeout", 0, _MAX_KEEPALIVE_TIMEOUT
+		));
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing keep-alive timeout: "
+			+ std::string(e.what())
+		);
+	}
+}
+
+void Parse::parse_keepalive_requests(const std::string& line) const
+{
+	try
+	{
+		if (line.empty())
+			throw std::runtime_error(
+				"Invalid argument provided."
+			);
+
+		const std::string value = get_directive_value(line, "keepalive_requests");
+
+		server_configuration->set_keepalive_requests(get_bounded_directive_number(
+			value, 1, _MAX_KEEPALIVE_REQUESTS, "Keep-alive request count"
+		));
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing keep-alive requests: "
+			+ std::string(e.what())
+		);
+	}
+}
+
+void Parse::parse_client_header_timeout(const std::string& line) const
+{
+	try
+	{
+		if (line.empty())
+			throw std::runtime_error(
+				"Invalid argument provided."
+			);
+
+		server_configuration->set_client_header_timeout(get_timeout_directive_seconds(
+			line, "client_header_timeout", 1, _MAX_CLIENT_TIMEOUT
+		));
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing client header timeout: "
+			+ std::string(e.what())
+		);
+	}
+}
+
+void Parse::parse_client_body_timeout(const std::string& line) const
+{
+	try
+	{
+		if (line.empty())
+			throw std::runtime_error(
+				"Invalid argument provided."
+			);
+
+		server_configuration->set_client_body_timeout(get_timeout_directive_seconds(
+			line, "client_body_timeout", 1, _MAX_CLIENT_TIMEOUT
+		));
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing client body timeout: "
+			+ std::string(e.what())
+		);
+	}
+}
+
+void Parse::parse_send_timeout(const std::string& line) const
+{
+	try
+	{
+		if (line.empty())
+			throw std::runtime_error(
+				"Invalid argument provided."
+			);
+
+		server_configuration->set_send_timeout(get_timeout_directive_seconds(
+			line, "send_timeout", 1, _MAX_CLIENT_TIMEOUT
+		));
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing send timeout: "
+			+ std::string(e.what())
+		);
+	}
+}
+
+void Parse::parse_shutdown_timeout(const std::string& line) const
+{
+	try
+	{
+		if (line.empty())
+			throw std::runtime_error(
+				"Invalid argument provided."
+			);
+
+		server_configuration->set_shutdown_timeout(get_timeout_directive_seconds(
+			line, "shutdown_timeout", 0, _MAX_CLIENT_TIMEOUT
+		));
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing shutdown timeout: "
+			+ std::string(e.what())
+		);
+	}
+}
+
+void Parse::parse_listen_backlog(const std::string& line) const
+{
+	try
+	{
+		if (line.empty())
+			throw std::runtime_error(
+				"Invalid argument provided."
+			);
+
+		const std::string value = get_directive_value(line, "listen_backlog");
+
+		server_configuration->set_listen_backlog(static_cast<int>(get_bounded_directive_number(
+			value, 1, _MAX_LISTEN_BACKLOG, "Listen backlog"
+		)));
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing listen backlog: "
+			+ std::string(e.what())
+		);
+	}
+}
+
+void Parse::parse_client_body_buffer_size(const std::string& line) const
+{
+	try
+	{
+		if (line.empty())
+			throw std::runtime_error(
+				"Invalid argument provided."
+			);
+
+		server_configuration->set_client_body_buffer_size(get_size_directive_bytes(
+			line, "client_body_buffer_size", 0, _MAX_CLIENT_BODY_BUFFER_SIZE
+		));
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing client body buffer size: "
+			+ std::string(e.what())
+		);
+	}
+}
+
+void Parse::parse_client_body_temp_path(const std::string& line) const
+{
+	try
+	{
+		if (line.empty())
+			throw std::runtime_error(
+				"Invalid argument provided."
+			);
+
+		const std::string	directory_path		= get_directive_value(line, "client_body_temp_path");
+		struct stat			directory_status	= {};
+
+		if (stat(directory_path.c_str(), &directory_status) < 0 || !S_ISDIR(directory_status.st_mode))
+			throw std::runtime_error(
+				"'" + directory_path + "' is not a directory"
+			);
+
+		if (access(directory_path.c_str(), W_OK | X_OK) < 0)
+			throw std::runtime_error(
+				"'" + directory_path + "' is not writable"
+			);
+
+		server_configuration->set_client_body_temp_path(directory_path);
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing client body temp path: "
+			+ std::string(e.what())
+		);
+	}
+}
+
+void Parse::parse_content_cache(const std::string& line) const
+{
+	try
+	{
+		Route* current_url_route = server_configuration->get_current_url_route();
+
+		if (!current_url_route)
+			throw std::runtime_error(
+				"Content cache must be defined within a location block"
+			);
+
+		const std::string value = get_directive_value(line, "content_cache");
+
+		if (value == "on")
+			current_url_route->set_content_cache(true);
+
+		else if (value == "off")
+			current_url_route->set_content_cache(false);
+
+		else
+			throw std::runtime_error(
+				"Options are 'on' or 'off'"
+			);
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing content cache: "
+			+ std::string(e.what())
+		);
+	}
+}
+
+void Parse::parse_content_cache_size(const std::string& line) const
+{
+	try
+	{
+		server_configuration->set_content_cache_size(get_size_directive_bytes(
+			line, "content_cache_size", 0, _MAX_CONTENT_CACHE_SIZE
+		));
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing content cache size: "
+			+ std::string(e.what())
+		);
+	}
+}
+
+void Parse::parse_content_cache_max_object_size(const std::string& line) const
+{
+	try
+	{
+		server_configuration->set_content_cache_max_object_size(get_size_directive_bytes(
+			line, "content_cache_max_object_size", 0, _MAX_CONTENT_CACHE_SIZE
+		));
+	}
+	catch (const std::exception& e)
+	{
+		throw std::runtime_error(
+			"Error parsing content cache max object size: "
+			+ std::string(e.what())
+		);
+	}
+}
+
 void Parse::parse_line(const std::string& line) const
 {
 	if (line.empty() || line.find_first_not_of(" \t") == std::string::npos)
@@ -1397,15 +1875,29 @@ void Parse::parse_line(const std::string& line) const
 		{"listen",					&Parse::parse_server_listening_port	},
 		{"server_name",				&Parse::parse_server_name			},
 		{"root",					&Parse::parse_root_directory		},
-		{"max_post_request_size",	&Parse::parse_max_post_request_size	},
+		{"client_max_post_request_size",	&Parse::parse_max_post_request_size	},
 		{"client_max_body_size",	&Parse::parse_client_body_size		},
 		{"index",					&Parse::parse_index_file			},
 		{"error_page",				&Parse::parse_error_page			},
 		{"allowed_methods",			&Parse::parse_allowed_http_methods	},
 		{"directory_listing",		&Parse::parse_directory_listing		},
+		{"content_cache",			&Parse::parse_content_cache			},
+		{"content_cache_size",		&Parse::parse_content_cache_size	},
+		{"content_cache_max_object_size",	&Parse::parse_content_cache_max_object_size	},
 		{"redirect",				&Parse::parse_redirect				},
 		{"upload_directory",		&Parse::parse_upload_directory		},
-		{"cgi_handler",				&Parse::parse_cgi_handler			}
+		{"cgi_handler",				&Parse::parse_cgi_handler			},
+		{"event_backend",			&Parse::parse_event_backend			},
+		{"worker_threads",			&Parse::parse_worker_threads		},
+		{"keepalive_timeout",		&Parse::parse_keepalive_timeout		},
+		{"keepalive_requests",		&Parse::parse_keepalive_requests	},
+		{"client_header_timeout",	&Parse::parse_client_header_timeout	},
+		{"client_body_timeout",		&Parse::parse_client_body_timeout	},
+		{"send_timeout",			&Parse::parse_send_timeout			},
+		{"shutdown_timeout",		&Parse::parse_shutdown_timeout		},
+		{"listen_backlog",			&Parse::parse_listen_backlog		},
+		{"client_body_buffer_size",	&Parse::parse_client_body_buffer_size	},
+		{"client_body_temp_path",	&Parse::parse_client_body_temp_path	}
 	};
 
 	std::istringstream	iss(line);
@@ -7,6 +7,7 @@ Route::Route(const std::string& file_path)
 		index_file("index.html"),
 		upload_directory("./upload"),
 		directory_listing(false),
+		content_cache(false),
 		server_listening_port(0)
 {
 	allowed_http_methods.insert(HttpMethod::GET);
@@ -23,6 +24,7 @@ Route::Route(
 		index_file("index.html"),
 		upload_directory(upload_directory_path),
 		directory_listing(directory_listing_enabled),
+		content_cache(false),
 		server_listening_port(listening_port)
 {
 	allowed_http_methods.insert(HttpMethod::GET);
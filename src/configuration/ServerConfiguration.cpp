@@ -55,6 +55,20 @@ std::string ServerConfiguration::get_server_configuration_string() const
 		<< "Max client body size: "		<< get_max_request_body_size()			<< " bytes\n"
 		<< "Max post request size: "	<< get_max_post_request_size()			<< " bytes\n"
 		<< "Request buffer read size: "	<< get_request_read_size()				<< " bytes\n"
+		<< "Client body buffer size: "	<< get_client_body_buffer_size()		<< " bytes\n"
+		<< "Client body temp path: "	<< get_client_body_temp_path()			<< "\n"
+		<< "Content cache size: "		<< get_content_cache_size()				<< " bytes per worker\n"
+		<< "Content cache max object: "	<< get_content_cache_max_object_size()	<< " bytes\n"
+		<< "Event loop backend: "		<< get_event_loop_backend_name(
+											get_event_loop_backend())			<< "\n"
+		<< "Worker threads: "			<< get_worker_thread_count()			<< "\n"
+		<< "Listen backlog: "			<< get_listen_backlog()					<< "\n"
+		<< "Shutdown timeout: "			<< get_shutdown_timeout()				<< " seconds\n"
+		<< "Keep-alive timeout: "		<< get_keepalive_timeout()				<< " seconds\n"
+		<< "Keep-alive requests: "		<< get_keepalive_requests()				<< "\n"
+		<< "Client header timeout: "	<< get_client_header_timeout()			<< " seconds\n"
+		<< "Client body timeout: "		<< get_client_body_timeout()			<< " seconds\n"
+		<< "Send timeout: "				<< get_send_timeout()					<< " seconds\n"
 		<< "Default error page: "		<< get_default_error_page_path()		<< "\n";
 
 	out << "\n=== Route Configurations ===\n";
@@ -65,6 +79,8 @@ std::string ServerConfiguration::get_server_configuration_string() const
 			<< "\nLocation: "			<< route.get_url_path()			<< "\n"
 			<< "  Root: "				<< route.get_filesystem_root()	<< "\n"
 			<< "  Directory listing: "	<< (route.is_directory_listing_enabled()
+										? "enabled" : "disabled")		<< "\n"
+			<< "  Content cache: "		<< (route.is_content_cache_enabled()
 										? "enabled" : "disabled")		<< "\n";
 
 		if (!route.get_index_file().empty())
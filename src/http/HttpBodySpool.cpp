@@ -0,0 +1,281 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/random.h>
+#include <unistd.h>
+#include <stdexcept>
+#include <algorithm>
+
+#include "http/HttpBodySpool.hpp"
+
+static std::string get_temporary_path(const std::string& path)
+{
+	static constexpr char	_TEMPORARY_PATH_CHARACTERS[]	= "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+	unsigned char			random_bytes[6]					= {};
+
+	/* A short read leaves zeros, the name is still tried with link() and redrawn if taken */
+	if (getrandom(random_bytes, sizeof(random_bytes), GRND_NONBLOCK) < 0)
+		random_bytes[0] = static_cast<unsigned char>(getpid());
+
+	std::string temporary_path = path + ".part";
+
+	for (const unsigned char random_byte : random_bytes)
+		temporary_path += _TEMPORARY_PATH_CHARACTERS[random_byte % (sizeof(_TEMPORARY_PATH_CHARACTERS) - 1)];
+
+	return temporary_path;
+}
+
+HttpBodySpool::HttpBodySpool() noexcept
+	:	file_descriptor(-1),
+		file_size(0)
+{
+}
+
+HttpBodySpool::~HttpBodySpool()
+{
+	close();
+}
+
+HttpBodySpool::HttpBodySpool(HttpBodySpool&& other) noexcept
+	:	file_descriptor(other.file_descriptor),
+		file_size(other.file_size),
+		file_path(std::move(other.file_path))
+{
+	other.file_descriptor	= -1;
+	other.file_size			= 0;
+	other.file_path.clear();
+}
+
+HttpBodySpool& HttpBodySpool::operator=(HttpBodySpool&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+
+		file_descriptor	= other.file_descriptor;
+		file_size		= other.file_size;
+		file_path		= std::move(other.file_path);
+
+		other.file_descriptor	= -1;
+		other.file_size			= 0;
+		other.file_path.clear();
+	}
+
+	return *this;
+}
+
+void HttpBodySpool::open(const std::string& directory)
+{
+	close();
+
+	file_descriptor = ::open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+
+	/* O_TMPFILE needs kernel and filesystem support */
+	if (file_descriptor < 0 && (errno == EOPNOTSUPP || errno == EISDIR || errno == EINVAL))
+	{
+		std::string path = directory + "/webserv_body_XXXXXX";
+
+		file_descriptor = mkostemp(path.data(), O_CLOEXEC);
+
+		if (file_descriptor >= 0)
+			file_path = std::move(path);
+	}
+
+	if (file_descriptor < 0)
+		throw std::runtime_error(
+			"Failed to create a spool file in " + directory + ": " + strerror(errno)
+		);
+}
+
+void HttpBodySpool::write(std::string_view data)
+{
+	while (!data.empty())
+	{
+		const ssize_t bytes_written = ::write(file_descriptor, data.data(), data.length());
+
+		if (bytes_written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			throw std::runtime_error(
+				std::string("Failed to write to the spool file: ") + strerror(errno)
+			);
+		}
+
+		data.remove_prefix(static_cast<size_t>(bytes_written));
+		file_size += static_cast<size_t>(bytes_written);
+	}
+}
+
+void HttpBodySpool::close() noexcept
+{
+	if (file_descriptor < 0)
+		return;
+
+	::close(file_descriptor);
+
+	if (!file_path.empty())
+		unlink(file_path.c_str());
+
+	file_descriptor	= -1;
+	file_size		= 0;
+	file_path.clear();
+}
+
+std::string HttpBodySpool::read(const size_t offset, const size_t length) const
+{
+	std::string data(offset < file_size ? std::min(length, file_size - offset) : 0, '\0');
+
+	size_t bytes_read = 0;
+
+	while (bytes_read < data.length())
+	{
+		const ssize_t result = pread(
+			file_descriptor,
+			data.data() + bytes_read,
+			data.length() - bytes_read,
+			static_cast<off_t>(offset + bytes_read)
+		);
+
+		if (result < 0 && errno == EINTR)
+			continue;
+
+		if (result <= 0)
+			throw std::runtime_error(
+				std::string("Failed to read the spool file: ") + (result < 0 ? strerror(errno) : "unexpected end")
+			);
+
+		bytes_read += static_cast<size_t>(result);
+	}
+
+	return data;
+}
+
+void HttpBodySpool::copy_range_to(const int destination_file_descriptor, size_t offset, size_t length) const
+{
+	loff_t source_offset = static_cast<loff_t>(offset);
+
+	while (length)
+	{
+		const ssize_t bytes_copied = copy_file_range(
+			file_descriptor, &source_offset, destination_file_descriptor, nullptr, length, 0
+		);
+
+		if (bytes_copied > 0)
+		{
+			length -= static_cast<size_t>(bytes_copied);
+			continue;
+		}
+
+		if (bytes_copied < 0 && errno == EINTR)
+			continue;
+
+		/* Old kernels refuse copies between filesystems, fall back to reading and writing */
+		if (bytes_copied < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP))
+			break;
+
+		throw std::runtime_error(
+			std::string("Failed to copy the spool file: ") + (bytes_copied < 0 ? strerror(errno) : "unexpected end")
+		);
+	}
+
+	while (length)
+	{
+		const std::string block = read(static_cast<size_t>(source_offset), std::min<size_t>(length, _HTTP_BODY_SPOOL_BLOCK_SIZE));
+
+		if (block.empty())
+			throw std::runtime_error("Failed to copy the spool file: unexpected end");
+
+		for (size_t bytes_written = 0; bytes_written < block.length(); )
+		{
+			const ssize_t result = ::write(
+				destination_file_descriptor, block.data() + bytes_written, block.length() - bytes_written
+			);
+
+			if (result < 0 && errno == EINTR)
+				continue;
+
+			if (result < 0)
+				throw std::runtime_error(
+					std::string("Failed to copy the spool file: ") + strerror(errno)
+				);
+
+			bytes_written += static_cast<size_t>(result);
+		}
+
+		source_offset	+= static_cast<loff_t>(block.length());
+		length			-= block.length();
+	}
+}
+
+void HttpBodySpool::save_as(const std::string& path) const
+{
+	/* Same permissions as an upload written directly */
+	fchmod(file_descriptor, 0644);
+
+	/* Written next to the destination and renamed over it, a reader sees the old file or the whole new one */
+	std::string temporary_path;
+	int			link_result = -1;
+
+	/* link() never replaces a name, a taken one is simply drawn again */
+	for (size_t attempt = 0; attempt < _HTTP_BODY_SPOOL_LINK_ATTEMPTS; ++attempt)
+	{
+		temporary_path = get_temporary_path(path);
+
+		/* An O_TMPFILE file gets its first name through its /proc link, a named one a second link */
+		link_result = file_path.empty()
+			? linkat(AT_FDCWD, ("/proc/self/fd/" + std::to_string(file_descriptor)).c_str(), AT_FDCWD, temporary_path.c_str(), AT_SYMLINK_FOLLOW)
+			: link(file_path.c_str(), temporary_path.c_str());
+
+		if (link_result == 0 || errno != EEXIST)
+			break;
+	}
+
+	if (link_result)
+	{
+		if (errno != EXDEV && errno != EPERM && errno != ENOENT)
+			throw std::runtime_error(
+				"Failed to move the spool file to " + path + ": " + strerror(errno)
+			);
+
+		/* Another filesystem, or /proc is not mounted: the copy goes into the descriptor that created the name */
+		temporary_path = path + ".partXXXXXX";
+
+		const int destination_file_descriptor = mkostemp(temporary_path.data(), O_CLOEXEC);
+
+		if (destination_file_descriptor < 0)
+			throw std::runtime_error(
+				"Failed to create a temporary file for " + path + ": " + strerror(errno)
+			);
+
+		try
+		{
+			/* mkostemp() creates it 0600 */
+			fchmod(destination_file_descriptor, 0644);
+			copy_range_to(destination_file_descriptor, 0, file_size);
+		}
+		catch (...)
+		{
+			::close(destination_file_descriptor);
+			unlink(temporary_path.c_str());
+			throw;
+		}
+
+		::close(destination_file_descriptor);
+	}
+
+	if (rename(temporary_path.c_str(), path.c_str()))
+	{
+		const int rename_error = errno;
+
+		unlink(temporary_path.c_str());
+
+		throw std::runtime_error(
+			"Failed to move the spool file to " + path + ": " + strerror(rename_error)
+		);
+	}
+}
@@ -0,0 +1,76 @@
+#include "http/HttpHeaderTable.hpp"
+
+HttpHeaderTable::HttpHeaderTable() noexcept
+	:	known_header_values(),
+		known_header_mask(0),
+		repeated_header_mask(0),
+		conflicting_header_mask(0)
+{
+}
+
+HttpHeader HttpHeaderTable::get_known_http_header(const std::string_view name) noexcept
+{
+	/* The length check rejects almost every candidate before a byte is compared */
+	for (size_t index = 0; index < _HTTP_HEADER_NAMES.size(); ++index)
+		if (_HTTP_HEADER_NAMES[index].length() == name.length() &&
+			equals_ignore_case_ascii(_HTTP_HEADER_NAMES[index], name))
+			return static_cast<HttpHeader>(index);
+
+	return HttpHeader::COUNT;
+}
+
+void HttpHeaderTable::insert(const std::string_view buffer, const std::string_view name, const std::string_view value)
+{
+	const HttpHeader http_header = get_known_http_header(name);
+
+	if (http_header != HttpHeader::COUNT)
+	{
+		const uint32_t http_header_bit = uint32_t(1) << static_cast<unsigned>(http_header);
+
+		if (known_header_mask & http_header_bit)
+		{
+			repeated_header_mask |= http_header_bit;
+
+			if (find(buffer, http_header) != value)
+				conflicting_header_mask |= http_header_bit;
+		}
+
+		known_header_values[static_cast<size_t>(http_header)] = get_span(buffer, value);
+		known_header_mask |= http_header_bit;
+		return;
+	}
+
+	other_header_fields.push_back({get_span(buffer, name), get_span(buffer, value)});
+}
+
+const HttpHeaderTable::HttpHeaderField* HttpHeaderTable::find_other_header_field(
+	const std::string_view buffer, const std::string_view name) const noexcept
+{
+	/* From the back, the last occurrence of a repeated header wins */
+	for (auto iterator = other_header_fields.rbegin(); iterator != other_header_fields.rend(); ++iterator)
+		if (iterator->name.length == name.length() && equals_ignore_case_ascii(get_view(buffer, iterator->name), name))
+			return &*iterator;
+
+	return nullptr;
+}
+
+std::string_view HttpHeaderTable::find(const std::string_view buffer, const std::string_view name) const noexcept
+{
+	const HttpHeader http_header = get_known_http_header(name);
+
+	if (http_header != HttpHeader::COUNT)
+		return find(buffer, http_header);
+
+	const HttpHeaderField* other_header_field = find_other_header_field(buffer, name);
+
+	return other_header_field ? get_view(buffer, other_header_field->value) : std::string_view();
+}
+
+bool HttpHeaderTable::contains(const std::string_view buffer, const std::string_view name) const noexcept
+{
+	const HttpHeader http_header = get_known_http_header(name);
+
+	return http_header != HttpHeader::COUNT
+		? contains(http_header)
+		: find_other_header_field(buffer, name) != nullptr;
+}
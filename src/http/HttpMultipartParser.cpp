@@ -0,0 +1,373 @@
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include "http/HttpHeader.hpp"
+#include "http/HttpRequestError.hpp"
+#include "http/HttpMultipartParser.hpp"
+
+static std::string_view trim_multipart_whitespace(std::string_view value) noexcept
+{
+	const size_t value_start = value.find_first_not_of(" \t");
+
+	if (value_start == std::string_view::npos)
+		return {};
+
+	value.remove_prefix(value_start);
+	value.remove_suffix(value.length() - value.find_last_not_of(" \t") - 1);
+
+	return value;
+}
+
+/* Value of a parameter in a header such as `form-data; name="field"; filename="a;b.txt"`, quotes removed */
+static std::string get_multipart_header_parameter(const std::string_view header_value, const std::string_view parameter_name)
+{
+	size_t position = header_value.find(';');
+
+	while (position != std::string_view::npos && position < header_value.length())
+	{
+		const size_t name_start	= position + 1;
+		const size_t name_end	= header_value.find_first_of("=;", name_start);
+
+		if (name_end == std::string_view::npos || header_value[name_end] == ';')
+		{
+			position = name_end;
+			continue;
+		}
+
+		const bool		is_wanted_parameter	= equals_ignore_case_ascii(
+												trim_multipart_whitespace(header_value.substr(name_start, name_end - name_start)),
+												parameter_name);
+		std::string		parameter_value;
+
+		position = header_value.find_first_not_of(" \t", name_end + 1);
+
+		if (position != std::string_view::npos && header_value[position] == '"')
+		{
+			/* Quoted string, a backslash escapes the next character */
+			for (++position; position < header_value.length() && header_value[position] != '"'; ++position)
+			{
+				if (header_value[position] == '\\' && position + 1 < header_value.length())
+					++position;
+
+				parameter_value += header_value[position];
+			}
+
+			position = header_value.find(';', position);
+		}
+		else if (position != std::string_view::npos)
+		{
+			const size_t value_end = std::min(header_value.find(';', position), header_value.length());
+
+			parameter_value	= trim_multipart_whitespace(header_value.substr(position, value_end - position));
+			position		= value_end;
+		}
+
+		if (is_wanted_parameter)
+			return parameter_value;
+	}
+
+	return "";
+}
+
+HttpMultipartParser::HttpMultipartParser()
+	:	delimiter_skip_table{},
+		multipart_parse_state(HttpMultipartParseState::PREAMBLE),
+		has_delimiter_dash(false),
+		part_header_length(0),
+		memory_limit(0),
+		memory_length(0)
+{
+}
+
+void HttpMultipartParser::start(const std::string_view boundary, const size_t body_memory_limit, const std::string_view body_temp_path)
+{
+	if (boundary.empty() || boundary.length() > _MAX_MULTIPART_BOUNDARY_LENGTH)
+		throw HttpRequestError(
+			HttpStatusCode::HTTP_400_BAD_REQUEST,
+			"Invalid multipart boundary: " + std::string(boundary)
+		);
+
+	reset();
+
+	delimiter.assign("\r\n--");
+	delimiter.append(boundary);
+
+	/* Horspool shift: distance from the last occurrence of a byte to the end of the delimiter */
+	delimiter_skip_table.fill(static_cast<uint8_t>(delimiter.length()));
+
+	for (size_t index = 0; index + 1 < delimiter.length(); ++index)
+		delimiter_skip_table[static_cast<unsigned char>(delimiter[index])]
+			= static_cast<uint8_t>(delimiter.length() - 1 - index);
+
+	/* The body may start with the delimiter without the line ending before it */
+	delimiter_lookbehind.assign("\r\n");
+
+	memory_limit	= body_memory_limit;
+	temp_path		= body_temp_path;
+}
+
+void HttpMultipartParser::reset() noexcept
+{
+	delimiter.clear();
+	delimiter_lookbehind.clear();
+	part_header_line.clear();
+	parts.clear();
+
+	multipart_parse_state	= HttpMultipartParseState::PREAMBLE;
+	has_delimiter_dash		= false;
+	part_header_length		= 0;
+	memory_length			= 0;
+}
+
+size_t HttpMultipartParser::find_delimiter(const std::string_view data) const noexcept
+{
+	const size_t delimiter_length = delimiter.length();
+
+	if (data.length() < delimiter_length)
+		return std::string_view::npos;
+
+	const char		last_delimiter_character	= delimiter.back();
+	const size_t	last_position				= data.length() - delimiter_length;
+
+	for (size_t position = 0; position <= last_position; )
+	{
+		const char character = data[position + delimiter_length - 1];
+
+		if (character == last_delimiter_character &&
+			!std::memcmp(data.data() + position, delimiter.data(), delimiter_length - 1))
+			return position;
+
+		position += delimiter_skip_table[static_cast<unsigned char>(character)];
+	}
+
+	return std::string_view::npos;
+}
+
+size_t HttpMultipartParser::consume_content(const std::string_view data)
+{
+	const bool		is_part_content		= multipart_parse_state == HttpMultipartParseState::PART_DATA;
+	const size_t	kept_length			= delimiter.length() - 1;
+
+	/* A delimiter cut by the previous read: enough of this one to complete it is searched with the held back bytes */
+	if (!delimiter_lookbehind.empty())
+	{
+		const size_t lookbehind_length = delimiter_lookbehind.length();
+
+		/* Reused between reads, it never outgrows two delimiters */
+		delimiter_window.assign(delimiter_lookbehind);
+		delimiter_window.append(data.substr(0, kept_length));
+
+		const std::string_view	window				= delimiter_window;
+		const size_t			delimiter_position	= find_delimiter(window);
+
+		if (delimiter_position != std::string_view::npos)
+		{
+			if (is_part_content)
+				append_content(window.substr(0, delimiter_position));
+
+			delimiter_lookbehind.clear();
+			multipart_parse_state = HttpMultipartParseState::DELIMITER_END;
+
+			return delimiter_position + delimiter.length() - lookbehind_length;
+		}
+
+		/* Too few new bytes to rule the held back ones out, the window is held back instead */
+		if (data.length() < kept_length)
+		{
+			const size_t released_length = window.length() > kept_length ? window.length() - kept_length : 0;
+
+			if (is_part_content)
+				append_content(window.substr(0, released_length));
+
+			delimiter_lookbehind.assign(window.substr(released_length));
+
+			return data.length();
+		}
+
+		if (is_part_content)
+			append_content(delimiter_lookbehind);
+
+		delimiter_lookbehind.clear();
+	}
+
+	const size_t delimiter_position = find_delimiter(data);
+
+	if (delimiter_position != std::string_view::npos)
+	{
+		if (is_part_content)
+			append_content(data.substr(0, delimiter_position));
+
+		multipart_parse_state = HttpMultipartParseState::DELIMITER_END;
+
+		return delimiter_position + delimiter.length();
+	}
+
+	/* The tail could be the start of a delimiter, it waits for the next read */
+	const size_t released_length = data.length() - std::min(data.length(), kept_length);
+
+	if (is_part_content)
+		append_content(data.substr(0, released_length));
+
+	delimiter_lookbehind.assign(data.substr(released_length));
+
+	return data.length();
+}
+
+void HttpMultipartParser::append_content(const std::string_view content)
+{
+	if (content.empty())
+		return;
+
+	HttpMultipartPart& part = parts.back();
+
+	if (!part.content_spool.is_open())
+	{
+		if (memory_length + content.length() <= memory_limit || temp_path.empty())
+		{
+			part.content.append(content);
+			memory_length += content.length();
+			return;
+		}
+	}
+
+	try
+	{
+		if (!part.content_spool.is_open())
+		{
+			part.content_spool.open(std::string(temp_path));
+			part.content_spool.write(part.content);
+
+			memory_length -= part.content.length();
+
+			part.content.clear();
+			part.content.shrink_to_fit();
+		}
+
+		part.content_spool.write(content);
+	}
+	catch (const std::runtime_error& e)
+	{
+		throw HttpRequestError(HttpStatusCode::HTTP_500_INTERNAL_SERVER_ERROR, e.what());
+	}
+}
+
+void HttpMultipartParser::start_part()
+{
+	if (parts.size() == _MAX_MULTIPART_PART_COUNT)
+		throw HttpRequestError(
+			HttpStatusCode::HTTP_413_PAYLOAD_TOO_LARGE,
+			"Multipart body has more than " + std::to_string(_MAX_MULTIPART_PART_COUNT) + " parts"
+		);
+
+	parts.emplace_back();
+
+	part_header_line.clear();
+	part_header_length		= 0;
+	multipart_parse_state	= HttpMultipartParseState::PART_HEADERS;
+}
+
+void HttpMultipartParser::parse_part_header_line(const std::string_view line)
+{
+	const size_t colon_position = line.find(':');
+
+	/* Lines without a colon are ignored, like in the request head */
+	if (colon_position == std::string_view::npos)
+		return;
+
+	const std::string_view name		= trim_multipart_whitespace(line.substr(0, colon_position));
+	const std::string_view value	= trim_multipart_whitespace(line.substr(colon_position + 1));
+
+	HttpMultipartPart& part = parts.back();
+
+	if (equals_ignore_case_ascii(name, "content-disposition"))
+	{
+		part.name		= get_multipart_header_parameter(value, "name");
+		part.filename	= get_multipart_header_parameter(value, "filename");
+	}
+	else if (equals_ignore_case_ascii(name, "content-type"))
+		part.content_type.assign(value);
+}
+
+size_t HttpMultipartParser::feed(const std::string_view data)
+{
+	size_t position = 0;
+
+	while (position < data.length())
+	{
+		switch (multipart_parse_state)
+		{
+		case HttpMultipartParseState::PREAMBLE:
+		case HttpMultipartParseState::PART_DATA:
+			position += consume_content(data.substr(position));
+			break;
+
+		case HttpMultipartParseState::DELIMITER_END:
+		{
+			const char character = data[position++];
+
+			if (character == '-')
+			{
+				if (has_delimiter_dash)
+					multipart_parse_state = HttpMultipartParseState::EPILOGUE;
+
+				has_delimiter_dash = !has_delimiter_dash;
+			}
+			else if (has_delimiter_dash)
+				throw HttpRequestError(HttpStatusCode::HTTP_400_BAD_REQUEST, "Invalid multipart delimiter");
+
+			/* RFC 2046 section 5.1.1, transport padding may follow a delimiter */
+			else if (character == '\n')
+				start_part();
+
+			else if (character != '\r' && character != ' ' && character != '\t')
+				throw HttpRequestError(HttpStatusCode::HTTP_400_BAD_REQUEST, "Invalid multipart delimiter");
+
+			break;
+		}
+
+		case HttpMultipartParseState::PART_HEADERS:
+		{
+			const char* const line_end = static_cast<const char*>(
+				std::memchr(data.data() + position, '\n', data.length() - position)
+			);
+
+			const size_t line_length = line_end ? static_cast<size_t>(line_end - data.data()) - position
+												: data.length() - position;
+
+			if ((part_header_length += line_length) > _MAX_MULTIPART_PART_HEADER_LENGTH)
+				throw HttpRequestError(HttpStatusCode::HTTP_400_BAD_REQUEST, "Multipart part headers too long");
+
+			part_header_line.append(data, position, line_length);
+			position += line_length;
+
+			if (!line_end)
+				break;
+
+			++position;
+
+			if (!part_header_line.empty() && part_header_line.back() == '\r')
+				part_header_line.pop_back();
+
+			/* An empty line ends the part headers */
+			if (part_header_line.empty())
+				multipart_parse_state = HttpMultipartParseState::PART_DATA;
+			else
+				parse_part_header_line(part_header_line);
+
+			part_header_line.clear();
+			break;
+		}
+
+		case HttpMultipartParseState::EPILOGUE:
+			if (data[position++] == '\n')
+				multipart_parse_state = HttpMultipartParseState::COMPLETE;
+			break;
+
+		case HttpMultipartParseState::COMPLETE:
+			return position;
+		}
+	}
+
+	return position;
+}
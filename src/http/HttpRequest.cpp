@@ -1,16 +1,64 @@
+#include <charconv>
+#include <cstring>
 #include <iostream>
 #include <algorithm>
+#include <limits>
+#include <stdexcept>
 
+#include "http/HttpUrl.hpp"
 #include "http/HttpRequest.hpp"
+#include "http/HttpScanner.hpp"
+
+/* Packs a token of up to 8 bytes into one integer, the same way at compile time and at runtime */
+static constexpr uint64_t get_http_method_word(const std::string_view method) noexcept
+{
+	uint64_t method_word = 0;
+
+	for (size_t index = 0; index < method.length() && index < sizeof(uint64_t); ++index)
+		method_word |= static_cast<uint64_t>(static_cast<unsigned char>(method[index])) << (index * 8);
+
+	return method_word;
+}
+
+static std::string_view trim_http_whitespace(std::string_view value) noexcept
+{
+	const size_t value_start = value.find_first_not_of(" \t");
+
+	if (value_start == std::string_view::npos)
+		return {};
+
+	value.remove_prefix(value_start);
+	value.remove_suffix(value.length() - value.find_last_not_of(" \t") - 1);
+
+	return value;
+}
 
 HttpRequest::HttpRequest()
 	:	http_request_method(HttpMethod::UNKNOWN),
-		is_http_request_complete(false),
-		are_http_headers_complete(false),
+		http_request_parse_state(HttpRequestParseState::REQUEST_LINE),
 		is_http_request_multipart(false),
-		http_request_body_start_index(0)
+		has_http_request_content_length(false),
+		is_http_request_chunked(false),
+		is_http_request_continue_expected(false),
+		has_http_request_chunk_size_digits(false),
+		http_request_chunk_parse_state(HttpChunkParseState::SIZE),
+		http_request_chunk_remaining(0),
+		http_request_chunk_line_length(0),
+		http_request_max_body_size(std::numeric_limits<size_t>::max()),
+		http_request_max_post_body_size(std::numeric_limits<size_t>::max()),
+		http_request_body_buffer_size(std::numeric_limits<size_t>::max()),
+		http_request_body_length(0),
+		http_request_parse_position(0),
+		http_request_scan_position(0),
+		http_request_colon_position(std::string::npos),
+		http_request_headers_start_index(0),
+		http_request_header_count(0),
+		http_request_body_start_index(0),
+		http_request_content_length(0),
+		http_request_message_length(0)
 {
 	http_request_url.clear();
+	http_request_path.clear();
 	http_request_version.clear();
 	http_request_headers.clear();
 	http_request_body.clear();
@@ -18,182 +66,613 @@ HttpRequest::HttpRequest()
 	http_request_boundary.clear();
 }
 
-void HttpRequest::parse_http_request_multipart_header(const std::string& http_request_content_type)
+void HttpRequest::reset_http_request()
 {
-	const size_t http_request_boundary_position = http_request_content_type.find("boundary=");
+	http_request_method				= HttpMethod::UNKNOWN;
+	http_request_parse_state		= HttpRequestParseState::REQUEST_LINE;
+	is_http_request_multipart		= false;
+	has_http_request_content_length	= false;
+	is_http_request_chunked			= false;
+	is_http_request_continue_expected	= false;
+	has_http_request_chunk_size_digits	= false;
+	http_request_chunk_parse_state	= HttpChunkParseState::SIZE;
+	http_request_chunk_remaining	= 0;
+	http_request_chunk_line_length	= 0;
+	http_request_parse_position		= 0;
+
+	http_request_body_spool.close();
+	http_request_multipart_parser.reset();
+	http_request_body_length		= 0;
+	http_request_scan_position		= 0;
+	http_request_colon_position		= std::string::npos;
+	http_request_headers_start_index	= 0;
+	http_request_header_count		= 0;
+	http_request_body_start_index	= 0;
+	http_request_content_length		= 0;
+	http_request_message_length		= 0;
+
+	http_request_url.clear();
+	http_request_path.clear();
+	http_request_version.clear();
+	http_request_headers.clear();
+	http_request_body.clear();
+	raw_http_request_data.clear();
+	http_request_boundary.clear();
+}
+
+std::string HttpRequest::take_pipelined_http_request_data()
+{
+	if (!is_http_request_complete_check() || http_request_message_length >= raw_http_request_data.length())
+		return "";
+
+	std::string pipelined_http_request_data = raw_http_request_data.substr(http_request_message_length);
+	raw_http_request_data.resize(http_request_message_length);
+
+	return pipelined_http_request_data;
+}
+
+void HttpRequest::parse_http_request_multipart_header(const std::string_view http_request_content_type)
+{
+	constexpr std::string_view boundary_parameter = "boundary=";
+
+	const size_t http_request_boundary_position = http_request_content_type.find(boundary_parameter);
 
-	if (http_request_boundary_position != std::string::npos)
+	if (http_request_boundary_position != std::string_view::npos)
 	{
-		http_request_boundary = http_request_content_type.substr(
-			http_request_boundary_position + std::string("boundary=").length()
+		std::string_view boundary = http_request_content_type.substr(
+			http_request_boundary_position + boundary_parameter.length()
 		);
 
+		/* RFC 2046 section 5.1.1, the boundary may be quoted and other parameters may follow it */
+		if (!boundary.empty() && boundary.front() == '"')
+			boundary = boundary.substr(1, boundary.find('"', 1) - 1);
+		else
+			boundary = trim_http_whitespace(boundary.substr(0, boundary.find(';')));
+
+		http_request_boundary.assign(boundary);
+
 		is_http_request_multipart = true;
 	}
 }
 
-bool HttpRequest::process_incoming_http_request(const std::string& data)
+void HttpRequest::parse_http_request_expectation()
 {
-	raw_http_request_data += data;
+	if (http_request_version != "HTTP/1.1")
+		return;
 
-	if (!are_http_headers_complete)
-	{
-		const size_t http_request_header_end = raw_http_request_data.find("\r\n\r\n");
+	const std::string_view expectation = get_http_request_header(HttpHeader::EXPECT);
 
-		if (http_request_header_end == std::string::npos)
-			return false;
+	if (!equals_ignore_case_ascii(expectation, "100-continue"))
+		throw HttpRequestError(
+			HttpStatusCode::HTTP_417_EXPECTATION_FAILED,
+			"Unsupported expectation: " + std::string(expectation)
+		);
 
-		const size_t first_line_end = raw_http_request_data.find("\r\n");
+	is_http_request_continue_expected = true;
+}
 
-		if (first_line_end == std::string::npos)
-			return false;
+void HttpRequest::parse_http_request_transfer_encoding()
+{
+	/* Both framings at once is how requests are smuggled past proxies */
+	if (has_http_request_header(HttpHeader::CONTENT_LENGTH))
+		throw HttpRequestError(
+			HttpStatusCode::HTTP_400_BAD_REQUEST,
+			"Request has both Transfer-Encoding and Content-Length"
+		);
+
+	/*
+	* A comma separated list of codings, the last one applied is listed last.
+	* Repeated lines form one list (RFC 9110 section 5.3): the table keeps the
+	* last line, which holds the final coding, and flags that others came before.
+	*/
+	const std::string_view	transfer_encoding	= get_http_request_header(HttpHeader::TRANSFER_ENCODING);
+	const size_t			last_comma_position	= transfer_encoding.rfind(',');
+	const bool				has_several_codings	= last_comma_position != std::string_view::npos
+												|| http_request_headers.is_repeated(HttpHeader::TRANSFER_ENCODING);
+
+	const std::string_view final_coding = trim_http_whitespace(
+		last_comma_position == std::string_view::npos
+			? transfer_encoding
+			: transfer_encoding.substr(last_comma_position + 1)
+	);
 
-		parse_http_request_line(raw_http_request_data.substr(0, first_line_end));
+	/* RFC 9112 section 6.3, without chunked last the end of the body cannot be found */
+	if (!equals_ignore_case_ascii(final_coding, "chunked"))
+		throw HttpRequestError(
+			HttpStatusCode::HTTP_400_BAD_REQUEST,
+			"Transfer-Encoding does not end with chunked: " + std::string(transfer_encoding)
+		);
 
-		const std::string http_request_header_string = raw_http_request_data.substr(
-			first_line_end + 2, http_request_header_end - (first_line_end + 2)
+	if (has_several_codings)
+		throw HttpRequestError(
+			HttpStatusCode::HTTP_501_NOT_IMPLEMENTED,
+			"Unsupported transfer coding: " + std::string(transfer_encoding)
 		);
 
-		std::istringstream http_request_header_stream(http_request_header_string);
-		parse_http_request_headers(http_request_header_stream);
+	is_http_request_chunked = true;
+}
 
-		are_http_headers_complete = true;
+bool HttpRequest::process_incoming_http_request(const std::string& data)
+{
+	if (http_request_parse_state == HttpRequestParseState::BODY && is_http_request_body_streamed())
+	{
+		const size_t consumed_length = consume_http_request_body(data);
 
-		const auto content_type_iterator = http_request_headers.find("content-type");
+		/* Only what follows the message is buffered, for the next pipelined request */
+		if (consumed_length < data.length())
+			raw_http_request_data.append(data, consumed_length);
 
-		if (content_type_iterator != http_request_headers.end() &&
-			content_type_iterator->second.find("multipart/form-data") != std::string::npos)
-			parse_http_request_multipart_header(content_type_iterator->second);
+		return is_http_request_complete_check();
+	}
 
-		http_request_body_start_index = http_request_header_end + std::string("\r\n\r\n").length();
+	raw_http_request_data += data;
 
-		if (http_request_method == HttpMethod::GET || (
-			http_request_method == HttpMethod::POST &&
-			!has_http_request_header("content-length") &&
-			!is_http_request_multipart))
+	if (http_request_parse_state == HttpRequestParseState::COMPLETE)
+		return true;
+
+	if (!are_http_request_headers_complete() && !parse_http_request_head())
+		return false;
+
+	if (!is_http_request_body_streamed())
+	{
+		http_request_message_length	= http_request_body_start_index;
+		http_request_parse_state	= HttpRequestParseState::COMPLETE;
+
+		return true;
+	}
+
+	/* Body bytes that arrived with the head leave the buffer, the header fields before them stay valid */
+	const size_t consumed_length = consume_http_request_body(
+		std::string_view(raw_http_request_data).substr(http_request_body_start_index)
+	);
+
+	raw_http_request_data.erase(http_request_body_start_index, consumed_length);
+
+	return is_http_request_complete_check();
+}
+
+void HttpRequest::append_http_request_body(const std::string_view data)
+{
+	http_request_body_length += data.length();
+
+	/* The epilogue after the closing delimiter is not consumed, it is ignored like the preamble */
+	if (http_request_multipart_parser.is_started())
+	{
+		http_request_multipart_parser.feed(data);
+		return;
+	}
+
+	if (!http_request_body_spool.is_open())
+	{
+		if (http_request_body.length() + data.length() <= http_request_body_buffer_size ||
+			http_request_body_temp_path.empty())
 		{
-			is_http_request_complete = true;
-			return true;
+			http_request_body.append(data);
+			return;
 		}
 	}
 
-	if (has_http_request_header("content-length"))
+	try
+	{
+		if (!http_request_body_spool.is_open())
+		{
+			http_request_body_spool.open(std::string(http_request_body_temp_path));
+			http_request_body_spool.write(http_request_body);
+
+			/* Spooled bodies are large, the memory goes back instead of waiting for the next one */
+			http_request_body.clear();
+			http_request_body.shrink_to_fit();
+		}
+
+		http_request_body_spool.write(data);
+	}
+	catch (const std::runtime_error& e)
+	{
+		throw HttpRequestError(HttpStatusCode::HTTP_500_INTERNAL_SERVER_ERROR, e.what());
+	}
+}
+
+size_t HttpRequest::consume_http_request_body(const std::string_view data)
+{
+	if (is_http_request_chunked)
+		return decode_http_request_chunks(data);
+
+	/* Neither Content-Length nor chunked, the closing delimiter of the multipart body ends the message */
+	if (!has_http_request_content_length)
+	{
+		const size_t consumed_length = http_request_multipart_parser.feed(data);
+
+		if ((http_request_body_length += consumed_length) > get_http_request_max_body_size())
+			throw HttpRequestError(
+				HttpStatusCode::HTTP_413_PAYLOAD_TOO_LARGE,
+				"Multipart body exceeds the body size limit (" + std::to_string(get_http_request_max_body_size()) + " bytes)"
+			);
+
+		if (http_request_multipart_parser.is_complete())
+			finish_http_request_body();
+
+		return consumed_length;
+	}
+
+	const size_t consumed_length = std::min(data.length(), http_request_content_length - get_http_request_body_length());
+
+	append_http_request_body(data.substr(0, consumed_length));
+
+	if (get_http_request_body_length() == http_request_content_length)
+		finish_http_request_body();
+
+	return consumed_length;
+}
+
+void HttpRequest::finish_http_request_body()
+{
+	/* An empty body has no parts, it needs no delimiter either */
+	if (http_request_multipart_parser.is_started() && http_request_body_length &&
+		!http_request_multipart_parser.has_closing_delimiter())
+		throw HttpRequestError(
+			HttpStatusCode::HTTP_400_BAD_REQUEST,
+			"Multipart body ends before its closing delimiter"
+		);
+
+	http_request_message_length	= http_request_body_start_index;
+	http_request_parse_state	= HttpRequestParseState::COMPLETE;
+}
+
+void HttpRequest::finish_http_request_chunk_size_line()
+{
+	if (!has_http_request_chunk_size_digits)
+		throw HttpRequestError(HttpStatusCode::HTTP_400_BAD_REQUEST, "Missing chunk size");
+
+	has_http_request_chunk_size_digits	= false;
+	http_request_chunk_line_length		= 0;
+
+	if (!http_request_chunk_remaining)
 	{
-		const size_t http_request_expected_length = std::stoull(
-			get_http_request_header("content-length")
+		http_request_chunk_parse_state = HttpChunkParseState::TRAILER;
+		return;
+	}
+
+	/* Refused before any of its data is read */
+	if (http_request_chunk_remaining > get_http_request_max_body_size() - get_http_request_body_length())
+		throw HttpRequestError(
+			HttpStatusCode::HTTP_413_PAYLOAD_TOO_LARGE,
+			"Chunked body exceeds the body size limit (" + std::to_string(get_http_request_max_body_size()) + " bytes)"
 		);
 
-		if (raw_http_request_data.length() - http_request_body_start_index >= http_request_expected_length)
+	http_request_chunk_parse_state = HttpChunkParseState::DATA;
+}
+
+size_t HttpRequest::decode_http_request_chunks(const std::string_view data)
+{
+	size_t position = 0;
+
+	while (position < data.length())
+	{
+		if (http_request_chunk_parse_state == HttpChunkParseState::DATA)
 		{
-			http_request_body = raw_http_request_data.substr(http_request_body_start_index);
-			is_http_request_complete = true;
+			const size_t data_length = std::min(http_request_chunk_remaining, data.length() - position);
 
-			return true;
+			append_http_request_body(data.substr(position, data_length));
+
+			position						+= data_length;
+			http_request_chunk_remaining	-= data_length;
+
+			if (!http_request_chunk_remaining)
+				http_request_chunk_parse_state = HttpChunkParseState::DATA_END;
+
+			continue;
+		}
+
+		const char character = data[position++];
+
+		/* Line endings are not counted, an empty line has length 0 whether it ends with CRLF or LF */
+		if (character != '\n' && character != '\r' && ++http_request_chunk_line_length > _MAX_HTTP_CHUNK_LINE_LENGTH)
+			throw HttpRequestError(HttpStatusCode::HTTP_400_BAD_REQUEST, "Chunk size or trailer line too long");
+
+		switch (http_request_chunk_parse_state)
+		{
+		case HttpChunkParseState::SIZE:
+		{
+			const int digit = character >= '0' && character <= '9' ? character - '0'
+							: character >= 'a' && character <= 'f' ? character - 'a' + 10
+							: character >= 'A' && character <= 'F' ? character - 'A' + 10
+							: -1;
+
+			if (digit >= 0)
+			{
+				if (http_request_chunk_remaining > (std::numeric_limits<size_t>::max() >> 4))
+					throw HttpRequestError(HttpStatusCode::HTTP_413_PAYLOAD_TOO_LARGE, "Chunk size overflows");
+
+				http_request_chunk_remaining		= (http_request_chunk_remaining << 4) | static_cast<size_t>(digit);
+				has_http_request_chunk_size_digits	= true;
+			}
+			else if (character == '\n')
+				finish_http_request_chunk_size_line();
+
+			else if (character == ';' || character == ' ' || character == '\t' || character == '\r')
+				http_request_chunk_parse_state = HttpChunkParseState::EXTENSION;
+
+			else
+				throw HttpRequestError(HttpStatusCode::HTTP_400_BAD_REQUEST, "Invalid chunk size");
+
+			break;
+		}
+
+		case HttpChunkParseState::EXTENSION:
+			if (character == '\n')
+				finish_http_request_chunk_size_line();
+			break;
+
+		case HttpChunkParseState::DATA_END:
+			if (character == '\n')
+			{
+				http_request_chunk_parse_state	= HttpChunkParseState::SIZE;
+				http_request_chunk_line_length	= 0;
+			}
+			else if (character != '\r')
+				throw HttpRequestError(HttpStatusCode::HTTP_400_BAD_REQUEST, "Chunk data is not followed by a line ending");
+			break;
+
+		case HttpChunkParseState::TRAILER:
+			if (character != '\n')
+				break;
+
+			/* An empty line ends the message */
+			if (!http_request_chunk_line_length)
+			{
+				finish_http_request_body();
+				return position;
+			}
+
+			http_request_chunk_line_length = 0;
+			break;
+
+		case HttpChunkParseState::DATA:
+			break;
 		}
 	}
-	else if (is_http_request_multipart)
+
+	return position;
+}
+
+bool HttpRequest::parse_http_request_head()
+{
+	while (true)
 	{
-		const std::string http_request_boundary_end = "--" + http_request_boundary + "--\r\n";
+		const char* const	scan_start		= raw_http_request_data.data() + http_request_scan_position;
+		const size_t		scan_length		= raw_http_request_data.length() - http_request_scan_position;
+		size_t				line_end_offset;
+
+		/* Only the bytes received since the last call are searched */
+		if (http_request_parse_state == HttpRequestParseState::REQUEST_LINE)
+		{
+			const char* const line_end = static_cast<const char*>(std::memchr(scan_start, '\n', scan_length));
+
+			line_end_offset = line_end ? static_cast<size_t>(line_end - scan_start) : scan_length;
+		}
+		else
+		{
+			/* Offsets are relative to scan_start, 0 tells the scanner the colon is already known */
+			size_t colon_offset = http_request_colon_position == std::string::npos ? std::string::npos : 0;
+
+			line_end_offset = HttpScanner::scan_http_header_line(scan_start, scan_length, colon_offset);
+
+			if (http_request_colon_position == std::string::npos && colon_offset != std::string::npos)
+				http_request_colon_position = http_request_scan_position + colon_offset;
+		}
+
+		check_http_request_head_length(http_request_scan_position + line_end_offset);
+
+		if (line_end_offset == scan_length)
+		{
+			http_request_scan_position = raw_http_request_data.length();
+			return false;
+		}
+
+		const size_t line_end_index = http_request_scan_position + line_end_offset;
+		const size_t line_start		= http_request_parse_position;
+
+		std::string_view line(raw_http_request_data.data() + line_start, line_end_index - line_start);
+
+		if (!line.empty() && line.back() == '\r')
+			line.remove_suffix(1);
+
+		http_request_parse_position	= line_end_index + 1;
+		http_request_scan_position	= http_request_parse_position;
 
-		if (raw_http_request_data.find(http_request_boundary_end) != std::string::npos)
+		if (http_request_parse_state == HttpRequestParseState::REQUEST_LINE)
 		{
-			http_request_body = raw_http_request_data.substr(http_request_body_start_index);
-			is_http_request_complete = true;
+			/* RFC 9112 section 2.2, empty lines before the request line are ignored */
+			if (line.empty())
+				continue;
 
+			parse_http_request_line(line);
+
+			http_request_parse_state			= HttpRequestParseState::HEADERS;
+			http_request_headers_start_index	= http_request_parse_position;
+			continue;
+		}
+
+		if (line.empty())
+		{
+			finish_http_request_head();
 			return true;
 		}
+
+		const size_t colon_position = http_request_colon_position;
+
+		http_request_colon_position = std::string::npos;
+
+		if (++http_request_header_count > _MAX_HTTP_REQUEST_HEADER_COUNT)
+			throw HttpRequestError(
+				HttpStatusCode::HTTP_431_REQUEST_HEADER_FIELDS_TOO_LARGE,
+				"More than " + std::to_string(_MAX_HTTP_REQUEST_HEADER_COUNT) + " header fields"
+			);
+
+		/* Lines without a colon are ignored */
+		if (colon_position != std::string::npos)
+			parse_http_request_header_line(line, colon_position - line_start);
 	}
-	else if (http_request_method != HttpMethod::POST)
+}
+
+void HttpRequest::check_http_request_head_length(const size_t scanned_end) const
+{
+	/* Empty lines before the request line count towards it, they are buffered all the same */
+	if (http_request_parse_state == HttpRequestParseState::REQUEST_LINE)
 	{
-		is_http_request_complete = true;
-		return true;
+		if (scanned_end > _MAX_HTTP_REQUEST_LINE_LENGTH)
+			throw HttpRequestError(
+				HttpStatusCode::HTTP_414_URI_TOO_LONG,
+				"Request line longer than " + std::to_string(_MAX_HTTP_REQUEST_LINE_LENGTH) + " bytes"
+			);
+
+		return;
 	}
 
-	return false;
+	if (scanned_end - http_request_headers_start_index > _MAX_HTTP_REQUEST_HEADER_SIZE)
+		throw HttpRequestError(
+			HttpStatusCode::HTTP_431_REQUEST_HEADER_FIELDS_TOO_LARGE,
+			"Header block larger than " + std::to_string(_MAX_HTTP_REQUEST_HEADER_SIZE) + " bytes"
+		);
 }
 
-void HttpRequest::parse_http_request_line(const std::string& line)
+void HttpRequest::finish_http_request_head()
 {
-	std::istringstream line_stream(line);
-	std::string http_request_method_string;
+	http_request_parse_state		= HttpRequestParseState::BODY;
+	http_request_body_start_index	= http_request_parse_position;
 
-	if (!(line_stream >> http_request_method_string >> http_request_url >> http_request_version))
-		throw std::runtime_error(
-			"Invalid HTTP request line"
+	const std::string_view content_type = get_http_request_header(HttpHeader::CONTENT_TYPE);
+
+	if (content_type.find("multipart/form-data") != std::string_view::npos)
+		parse_http_request_multipart_header(content_type);
+
+	if (has_http_request_header(HttpHeader::TRANSFER_ENCODING))
+		parse_http_request_transfer_encoding();
+
+	if (has_http_request_header(HttpHeader::EXPECT))
+		parse_http_request_expectation();
+
+	/* Split into parts as it arrives, whatever frames it */
+	if (is_http_request_multipart && http_request_method != HttpMethod::GET)
+		http_request_multipart_parser.start(
+			http_request_boundary, http_request_body_buffer_size, http_request_body_temp_path
 		);
 
-	static const
-	std::unordered_map<std::string, HttpMethod>
-	method_map =
-	{
-		{"GET",		HttpMethod::GET		},
-		{"POST",	HttpMethod::POST	},
-		{"DELETE",	HttpMethod::DELETE	}
-	};
+	if (is_http_request_chunked || !has_http_request_header(HttpHeader::CONTENT_LENGTH))
+		return;
+
+	/* RFC 9112 section 6.3, two different lengths leave the end of the body ambiguous */
+	if (http_request_headers.is_conflicting(HttpHeader::CONTENT_LENGTH))
+		throw HttpRequestError(
+			HttpStatusCode::HTTP_400_BAD_REQUEST,
+			"Request has conflicting Content-Length headers"
+		);
 
-	auto it = method_map.find(http_request_method_string);
-	http_request_method = it != method_map.end()
-						? it->second : HttpMethod::UNKNOWN;
+	const std::string_view	content_length	= get_http_request_header(HttpHeader::CONTENT_LENGTH);
+	const auto				parse_result	= std::from_chars(
+												content_length.data(),
+												content_length.data() + content_length.length(),
+												http_request_content_length);
 
-	if (http_request_version != "HTTP/1.1" && http_request_version != "HTTP/1.0")
+	if (content_length.empty() || parse_result.ec != std::errc() ||
+		parse_result.ptr != content_length.data() + content_length.length())
 		throw std::runtime_error(
-			"Unsupported HTTP version. Supported versions are: HTTP/1.0 and HTTP/1.1."
+			"Invalid Content-Length header: " + std::string(content_length)
+		);
+
+	/* Refused on its announced size, none of the body has been read yet */
+	if (http_request_content_length > get_http_request_max_body_size())
+		throw HttpRequestError(
+			HttpStatusCode::HTTP_413_PAYLOAD_TOO_LARGE,
+			"Content-Length (" + std::to_string(http_request_content_length) + ") exceeds the body size limit ("
+			+ std::to_string(get_http_request_max_body_size()) + " bytes)"
 		);
+
+	has_http_request_content_length = true;
 }
 
-void HttpRequest::parse_http_request_headers(std::istringstream& http_request_stream)
+void HttpRequest::parse_http_request_line(const std::string_view line)
 {
-	std::string line;
+	std::string_view	request_line_parts[3];
+	size_t				request_line_part_count	= 0;
+	size_t				position				= 0;
 
-	while (std::getline(http_request_stream, line))
+	/* method SP request-target SP HTTP-version, runs of blanks are tolerated */
+	while ((position = line.find_first_not_of(" \t", position)) != std::string_view::npos)
 	{
-		if (!line.empty() && line.back() == '\r')
-			line.pop_back();
-
-		if (line.empty())
-			return;
+		if (request_line_part_count == 3)
+			throw std::runtime_error(
+				"Invalid HTTP request line"
+			);
 
-		const size_t colon_position = line.find(':');
+		const size_t part_end = std::min(line.find_first_of(" \t", position), line.length());
 
-		if (colon_position != std::string::npos)
-		{
-			std::string key		= line.substr(0, colon_position);
-			std::string value	= line.substr(colon_position + 1);
+		request_line_parts[request_line_part_count++] = line.substr(position, part_end - position);
+		position = part_end;
+	}
 
-			value.erase(0, value.find_first_not_of(" "));
-			value.erase(value.find_last_not_of(" \t\r\n") + 1);
+	if (request_line_part_count != 3)
+		throw std::runtime_error(
+			"Invalid HTTP request line"
+		);
 
-			std::transform(
-				key.begin(), key.end(), key.begin(),
-				static_cast<int(*)(int)>(std::tolower)
-			);
+	const std::string_view http_request_method_string = request_line_parts[0];
 
-			http_request_headers[key] = value;
-		}
+	/* One integer comparison per known method instead of hashing the token */
+	switch (http_request_method_string.length() <= sizeof(uint64_t)
+			? get_http_method_word(http_request_method_string) : 0)
+	{
+	case get_http_method_word("GET"):		http_request_method = HttpMethod::GET;		break;
+	case get_http_method_word("POST"):		http_request_method = HttpMethod::POST;		break;
+	case get_http_method_word("DELETE"):	http_request_method = HttpMethod::DELETE;	break;
+	default:								http_request_method = HttpMethod::UNKNOWN;	break;
 	}
+
+	http_request_url.assign(request_line_parts[1]);
+	http_request_path.assign(HttpUrl::get_http_url_path(request_line_parts[1]));
+
+	HttpUrl::normalize_http_url_path(http_request_path);
+	http_request_version.assign(request_line_parts[2]);
+
+	if (http_request_version != "HTTP/1.1" && http_request_version != "HTTP/1.0")
+		throw std::runtime_error(
+			"Unsupported HTTP version. Supported versions are: HTTP/1.0 and HTTP/1.1."
+		);
 }
 
-std::string HttpRequest::get_http_request_header(const std::string& key) const
+void HttpRequest::parse_http_request_header_line(const std::string_view line, const size_t colon_position)
 {
-	std::string lower_key = key;
-
-	std::transform(
-		lower_key.begin(), lower_key.end(), lower_key.begin(),
-		static_cast<int(*)(int)>(std::tolower)
+	http_request_headers.insert(
+		raw_http_request_data,
+		line.substr(0, colon_position),
+		trim_http_whitespace(line.substr(colon_position + 1))
 	);
-
-	const auto iterator = http_request_headers.find(lower_key);
-	return iterator != http_request_headers.end() ? iterator->second : "";
 }
 
-bool HttpRequest::has_http_request_header(const std::string& key) const
+bool HttpRequest::is_keep_alive_requested() const
 {
-	std::string lower_key = key;
+	bool has_close_option		= false;
+	bool has_keep_alive_option	= false;
 
-	std::transform(
-		lower_key.begin(), lower_key.end(), lower_key.begin(),
-		static_cast<int(*)(int)>(std::tolower)
-	);
+	/* The header is a comma separated token list, e.g. "keep-alive, Upgrade" */
+	std::string_view connection = get_http_request_header(HttpHeader::CONNECTION);
+
+	while (!connection.empty())
+	{
+		const size_t				option_end			= std::min(connection.find(','), connection.length());
+		const std::string_view		connection_option	= trim_http_whitespace(connection.substr(0, option_end));
+
+		if (equals_ignore_case_ascii(connection_option, "close"))
+			has_close_option = true;
+
+		else if (equals_ignore_case_ascii(connection_option, "keep-alive"))
+			has_keep_alive_option = true;
+
+		connection.remove_prefix(std::min(option_end + 1, connection.length()));
+	}
+
+	if (has_close_option)
+		return false;
 
-	return http_request_headers.find(lower_key) != http_request_headers.end();
+	return http_request_version == "HTTP/1.1" || has_keep_alive_option;
 }
@@ -1,62 +1,152 @@
 #include <ctime>
-#include <sstream>
 
 #include "http/HttpResponse.hpp"
 
+#define _HTTP_RESPONSE_SERVER_HEADER	"Server: webserv/1.0\r\n"
+
+HttpResponseDefaultHeaders::HttpResponseDefaultHeaders()
+{
+	refresh();
+}
+
+void HttpResponseDefaultHeaders::set_keepalive_timeout(const size_t keepalive_timeout_seconds)
+{
+	keep_alive_line = "Keep-Alive: timeout=" + std::to_string(keepalive_timeout_seconds) + "\r\n";
+
+	format_http_response_default_headers();
+}
+
+void HttpResponseDefaultHeaders::refresh()
+{
+	/* A vDSO call, the formatting below only runs once per second */
+	const std::time_t now = std::time(nullptr);
+
+	if (now == formatted_time)
+		return;
+
+	formatted_time = now;
+
+	format_http_response_default_headers();
+}
+
+void HttpResponseDefaultHeaders::format_http_response_default_headers()
+{
+	/* Reentrant variant, responses are built on every worker thread */
+	std::tm now_utc = {};
+	gmtime_r(&formatted_time, &now_utc);
+
+	/* It wont reach over 31 bytes, 40 to be safe.	*/
+	char date_buffer[40];
+
+	const size_t date_length = std::strftime(
+		date_buffer, sizeof(date_buffer),
+		"%a, %d %b %Y %H:%M:%S GMT", &now_utc
+	);
+
+	close_headers.assign("Date: ").append(date_buffer, date_length).append("\r\n" _HTTP_RESPONSE_SERVER_HEADER);
+
+	keep_alive_headers.assign(close_headers).append("Connection: keep-alive\r\n").append(keep_alive_line);
+
+	close_headers.append("Connection: close\r\n");
+}
+
+/* Sent from the worker's default headers, never twice */
+static bool is_default_http_response_header(const std::string_view name) noexcept
+{
+	return name == "Date" || name == "Server" || name == "Connection" || name == "Keep-Alive";
+}
+
 HttpResponse::HttpResponse()
 	:	http_response_status_code(
 			HttpStatusCode::HTTP_200_OK
 		),
 		http_version("HTTP/1.1")
 {
-	add_default_http_response_headers();
 }
 
 HttpResponse::HttpResponse(const HttpStatusCode http_status_code)
 	:	http_response_status_code(http_status_code),
 		http_version("HTTP/1.1")
 {
-	add_default_http_response_headers();
 }
 
-void HttpResponse::add_default_http_response_headers()
+bool HttpResponse::is_http_response_body_allowed() const noexcept
 {
-	const std::time_t now = std::time(nullptr);
-
-	/* It wont reach over 31 bytes, 40 to be safe.	*/
-	char date_buffer[40];
-
-	std::strftime(
-		date_buffer, sizeof(date_buffer),
-		"%a, %d %b %Y %H:%M:%S GMT", std::gmtime(&now)
-	);
+	const int status_code = static_cast<int>(http_response_status_code);
 
-	http_response_headers["Date"]		= date_buffer;
-	http_response_headers["Server"]		= "webserv/1.0";
-	http_response_headers["Connection"]	= "keep-alive";
+	return status_code >= 200 && status_code != 204 && status_code != 304;
 }
 
-std::string HttpResponse::build_http_response() const
+void HttpResponse::append_http_response_segments(std::vector<HttpResponseSegment>& segments, const std::string_view default_headers)
 {
-	std::ostringstream http_response;
+	const bool			is_body_allowed	= is_http_response_body_allowed();
+	const std::string	status_code		= std::to_string(static_cast<int>(http_response_status_code));
 
-	http_response	<< http_version
-					<< " "
-					<< static_cast<int>(http_response_status_code)
-					<< " "
-					<< get_http_response_status_code_text(http_response_status_code)
-					<< "\r\n";
+	std::string http_response_head;
+
+	/* Headers are short, one growth at most */
+	http_response_head.reserve(256);
+
+	http_response_head
+		.append(http_version).append(" ")
+		.append(status_code).append(" ")
+		.append(get_http_response_status_code_text(http_response_status_code))
+		.append("\r\n")
+		.append(default_headers);
+
+	/* The prebuilt content carries its own Content-Length and ends the header block */
+	const bool is_prebuilt = is_body_allowed && http_response_prebuilt_content;
 
 	for (const auto& http_response_header : http_response_headers)
-		http_response	<< http_response_header.first
-						<< ": "
-						<< http_response_header.second
-						<< "\r\n";
+	{
+		if (!is_body_allowed && http_response_header.first == "Content-Length")
+			continue;
+
+		if (is_default_http_response_header(http_response_header.first))
+			continue;
+
+		http_response_head
+			.append(http_response_header.first).append(": ")
+			.append(http_response_header.second).append("\r\n");
+	}
+
+	const std::string_view http_response_body_bytes = http_response_static_body.data()
+		? http_response_static_body : std::string_view(http_response_body);
+
+	const size_t http_response_body_length = http_response_file
+		? http_response_file_length : http_response_body_bytes.length();
+
+	if (is_prebuilt)
+	{
+		segments.emplace_back(std::move(http_response_head));
+		segments.emplace_back(std::move(http_response_prebuilt_content));
+
+		return;
+	}
+
+	/* On a persistent connection the client relies on it to find the end of the response */
+	if (is_body_allowed && !http_response_headers.contains("Content-Length"))
+		http_response_head
+			.append("Content-Length: ")
+			.append(std::to_string(http_response_body_length))
+			.append("\r\n");
+
+	http_response_head.append("\r\n");
+
+	segments.emplace_back(std::move(http_response_head));
 
-	http_response << "\r\n";
+	if (!is_body_allowed || !http_response_body_length)
+		return;
 
-	if (!http_response_body.empty())
-		http_response << http_response_body;
+	if (http_response_file)
+		segments.emplace_back(std::move(http_response_file), http_response_file_offset, http_response_file_length);
+	else if (http_response_static_body.data())
+		segments.emplace_back(http_response_static_body);
+	else
+		segments.emplace_back(std::move(http_response_body));
 
-	return http_response.str();
+	http_response_body.clear();
+	http_response_static_body = {};
+	http_response_file.reset();
+	http_response_prebuilt_content.reset();
 }
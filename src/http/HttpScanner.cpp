@@ -0,0 +1,171 @@
+#include <bit>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+# define _HTTP_SCANNER_X86
+#endif
+
+#include "http/HttpScanner.hpp"
+
+static size_t scan_http_header_line_scalar(const char* data, const size_t length, size_t& colon_position) noexcept
+{
+	for (size_t index = 0; index < length; ++index)
+	{
+		if (data[index] == '\n')
+			return index;
+
+		if (data[index] == ':' && colon_position == std::string::npos)
+			colon_position = index;
+	}
+
+	return length;
+}
+
+#ifdef _HTTP_SCANNER_X86
+
+/* The last bytes that do not fill a vector, with the colon index kept relative to data */
+static size_t scan_http_header_line_tail(
+	const char*		data,
+	const size_t	index,
+	const size_t	length,
+	size_t&			colon_position) noexcept
+{
+	size_t tail_colon_position = colon_position == std::string::npos ? std::string::npos : 0;
+
+	const size_t tail_line_end = scan_http_header_line_scalar(data + index, length - index, tail_colon_position);
+
+	if (colon_position == std::string::npos && tail_colon_position != std::string::npos)
+		colon_position = index + tail_colon_position;
+
+	return index + tail_line_end;
+}
+
+/* PCMPESTRI matches any of the needle bytes, once the colon is known only the line feed is left */
+__attribute__((target("sse4.2")))
+static size_t scan_http_header_line_sse42(const char* data, const size_t length, size_t& colon_position) noexcept
+{
+	const __m128i line_delimiters = _mm_setr_epi8('\n', ':', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+	size_t index = 0;
+
+	while (index + 16 <= length)
+	{
+		const __m128i	block		= _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+		const int		match_index	= _mm_cmpestri(
+										line_delimiters,
+										colon_position == std::string::npos ? 2 : 1,
+										block, 16,
+										_SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+
+		if (match_index == 16)
+		{
+			index += 16;
+			continue;
+		}
+
+		index += static_cast<size_t>(match_index);
+
+		if (data[index] == '\n')
+			return index;
+
+		colon_position = index++;
+	}
+
+	return scan_http_header_line_tail(data, index, length, colon_position);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_http_header_line_avx2(const char* data, const size_t length, size_t& colon_position) noexcept
+{
+	const __m256i line_feed	= _mm256_set1_epi8('\n');
+	const __m256i colon		= _mm256_set1_epi8(':');
+
+	size_t index = 0;
+
+	for (; index + 32 <= length; index += 32)
+	{
+		const __m256i	block			= _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+		const uint32_t	line_feed_mask	= static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, line_feed)));
+
+		if (colon_position == std::string::npos)
+		{
+			uint32_t colon_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, colon)));
+
+			/* Only colons before the line feed belong to this line */
+			if (line_feed_mask)
+				colon_mask &= (line_feed_mask & -line_feed_mask) - 1;
+
+			if (colon_mask)
+				colon_position = index + static_cast<size_t>(std::countr_zero(colon_mask));
+		}
+
+		if (line_feed_mask)
+			return index + static_cast<size_t>(std::countr_zero(line_feed_mask));
+	}
+
+	return scan_http_header_line_tail(data, index, length, colon_position);
+}
+
+#endif
+
+static HttpLineScanner select_http_line_scanner() noexcept
+{
+	return HttpScanner::get_http_line_scanner(HttpScanner::get_best_http_scanner_implementation());
+}
+
+const HttpLineScanner HttpScanner::selected_http_line_scanner = select_http_line_scanner();
+
+HttpLineScanner HttpScanner::get_http_line_scanner(const HttpScannerImplementation implementation) noexcept
+{
+#ifdef _HTTP_SCANNER_X86
+	/* May run from a static initializer, before the CPU model is filled in */
+	__builtin_cpu_init();
+#endif
+
+	switch (implementation)
+	{
+	case HttpScannerImplementation::SCALAR:
+		return scan_http_header_line_scalar;
+
+#ifdef _HTTP_SCANNER_X86
+	case HttpScannerImplementation::SSE42:
+		return __builtin_cpu_supports("sse4.2") ? scan_http_header_line_sse42 : nullptr;
+
+	case HttpScannerImplementation::AVX2:
+		return __builtin_cpu_supports("avx2") ? scan_http_header_line_avx2 : nullptr;
+#else
+	case HttpScannerImplementation::SSE42:
+	case HttpScannerImplementation::AVX2:
+		return nullptr;
+#endif
+	}
+
+	return nullptr;
+}
+
+HttpScannerImplementation HttpScanner::get_best_http_scanner_implementation() noexcept
+{
+#ifdef _HTTP_SCANNER_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+		return HttpScannerImplementation::AVX2;
+
+	if (__builtin_cpu_supports("sse4.2"))
+		return HttpScannerImplementation::SSE42;
+#endif
+
+	return HttpScannerImplementation::SCALAR;
+}
+
+const char* HttpScanner::get_http_scanner_implementation_name(const HttpScannerImplementation implementation) noexcept
+{
+	switch (implementation)
+	{
+	case HttpScannerImplementation::SCALAR:	return "scalar";
+	case HttpScannerImplementation::SSE42:	return "sse4.2";
+	case HttpScannerImplementation::AVX2:	return "avx2";
+	}
+
+	return "unknown";
+}
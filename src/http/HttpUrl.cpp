@@ -0,0 +1,157 @@
+#include <array>
+#include <cstdint>
+#include <algorithm>
+
+#include "http/HttpUrl.hpp"
+#include "http/HttpHeader.hpp"
+#include "http/HttpRequestError.hpp"
+
+/* Low nibble: value of a hexadecimal digit */
+#define _HTTP_URL_HEX_DIGIT		0x10
+#define _HTTP_URL_FORBIDDEN		0x20	/* Control characters, space and DEL never appear in a target */
+#define _HTTP_URL_PATH_END		0x40	/* '?' starts the query, '#' the fragment */
+
+static constexpr std::array<uint8_t, 256> make_http_url_character_table() noexcept
+{
+	std::array<uint8_t, 256> character_table{};
+
+	for (unsigned int character = 0; character < 256; ++character)
+	{
+		if (character >= '0' && character <= '9')
+			character_table[character] = static_cast<uint8_t>(_HTTP_URL_HEX_DIGIT | (character - '0'));
+		else if (character >= 'a' && character <= 'f')
+			character_table[character] = static_cast<uint8_t>(_HTTP_URL_HEX_DIGIT | (character - 'a' + 10));
+		else if (character >= 'A' && character <= 'F')
+			character_table[character] = static_cast<uint8_t>(_HTTP_URL_HEX_DIGIT | (character - 'A' + 10));
+		else if (character <= ' ' || character == 0x7F)
+			character_table[character] = _HTTP_URL_FORBIDDEN;
+		else if (character == '?' || character == '#')
+			character_table[character] = _HTTP_URL_PATH_END;
+	}
+
+	return character_table;
+}
+
+static constexpr std::array<uint8_t, 256> http_url_character_table = make_http_url_character_table();
+
+/* std::string_view::find_first_of() searches the set for every byte, one table lookup is enough */
+static size_t find_http_url_path_end(const std::string_view target, size_t position) noexcept
+{
+	while (position < target.length() &&
+		   !(http_url_character_table[static_cast<unsigned char>(target[position])] & _HTTP_URL_PATH_END))
+		++position;
+
+	return position;
+}
+
+[[noreturn]] static void throw_http_url_error(const char* const reason)
+{
+	throw HttpRequestError(HttpStatusCode::HTTP_400_BAD_REQUEST, reason);
+}
+
+std::string_view HttpUrl::get_http_url_path(std::string_view target)
+{
+	if (target.empty() || target.front() != '/')
+	{
+		const size_t scheme_end = target.find("://");
+
+		if (scheme_end == std::string_view::npos ||
+			!(equals_ignore_case_ascii(target.substr(0, scheme_end), "http") ||
+			  equals_ignore_case_ascii(target.substr(0, scheme_end), "https")))
+			throw_http_url_error("Request target is not a path");
+
+		/* The host was already given by the client, an empty path is the root */
+		const size_t path_start = std::min(target.find('/', scheme_end + 3), find_http_url_path_end(target, scheme_end + 3));
+
+		if (path_start >= target.length() || target[path_start] != '/')
+			return "/";
+
+		target.remove_prefix(path_start);
+	}
+
+	return target.substr(0, find_http_url_path_end(target, 0));
+}
+
+void HttpUrl::normalize_http_url_path(std::string& path)
+{
+	if (path.empty() || path.front() != '/')
+		throw_http_url_error("Request path does not start with '/'");
+
+	char* const		data			= path.data();
+	const size_t	length			= path.length();
+	size_t			read_index		= 1;
+	size_t			write_index		= 1;
+	size_t			segment_start	= 1;	/* First byte of the segment being written */
+
+	/* The result is never longer than what was read, so it overwrites bytes already consumed */
+	for (;;)
+	{
+		const bool	is_path_end	= read_index == length;
+		char		character	= '/';
+
+		if (!is_path_end)
+		{
+			character = data[read_index];
+
+			if (http_url_character_table[static_cast<unsigned char>(character)] & _HTTP_URL_FORBIDDEN)
+				throw_http_url_error("Control character in request path");
+
+			if (character == '%')
+			{
+				if (read_index + 2 >= length)
+					throw_http_url_error("Truncated percent escape in request path");
+
+				const uint8_t high_digit	= http_url_character_table[static_cast<unsigned char>(data[read_index + 1])];
+				const uint8_t low_digit		= http_url_character_table[static_cast<unsigned char>(data[read_index + 2])];
+
+				if (!(high_digit & low_digit & _HTTP_URL_HEX_DIGIT))
+					throw_http_url_error("Invalid percent escape in request path");
+
+				character = static_cast<char>(((high_digit & 0x0F) << 4) | (low_digit & 0x0F));
+
+				/* A NUL would cut the path short once handed to the filesystem */
+				if (!character)
+					throw_http_url_error("Escaped NUL in request path");
+
+				read_index += 3;
+			}
+			else
+				++read_index;
+
+			if (character != '/')
+			{
+				data[write_index++] = character;
+				continue;
+			}
+		}
+
+		/* A segment ends, at a slash or at the end of the path */
+		const size_t segment_length = write_index - segment_start;
+
+		if (segment_length == 1 && data[segment_start] == '.')
+			write_index = segment_start;
+
+		else if (segment_length == 2 && data[segment_start] == '.' && data[segment_start + 1] == '.')
+		{
+			if (segment_start == 1)
+				throw_http_url_error("Request path climbs above the root");
+
+			/* Back to the start of the previous segment, after the slash before it */
+			write_index = segment_start - 1;
+
+			while (data[write_index - 1] != '/')
+				--write_index;
+		}
+
+		/* Empty segments are dropped, the slash ending the previous one stands for them */
+		else if (segment_length && !is_path_end)
+			data[write_index++] = '/';
+
+		segment_start = write_index;
+
+		if (is_path_end)
+			break;
+	}
+
+	path.resize(write_index);
+}
@@ -1,8 +1,27 @@
+#include <string>
 #include <cstdlib>
+#include <climits>
 #include <iostream>
+#include <unistd.h>
 
-#include "configuration/Parse.hpp"
-#include "server/Server.hpp"
+#include "server/ServerMaster.hpp"
+
+/* Resolved once at startup, the file may be replaced before an upgrade execs it again */
+static std::string get_executable_path(const char* program_name)
+{
+	char executable_path[PATH_MAX];
+
+	if (std::string(program_name).find('/') != std::string::npos &&
+		realpath(program_name, executable_path))
+		return executable_path;
+
+	const ssize_t length = readlink("/proc/self/exe", executable_path, sizeof(executable_path) - 1);
+
+	if (length < 0)
+		return program_name;
+
+	return std::string(executable_path, static_cast<size_t>(length));
+}
 
 int main(const int argc, char **argv)
 {
@@ -13,13 +32,9 @@ int main(const int argc, char **argv)
 				"Usage: ./webserv [configuration file]"
 			);
 
-		const Parse parser{std::string(argv[1])};
-		parser.parse_server_configuration_file();
-
-		Server server(parser.get_server_configuration());
+		ServerMaster server_master(argv[1], get_executable_path(argv[0]));
 
-		server.setup_server();
-		server.start_server();
+		server_master.run();
 	}
 
 	catch (const std::exception& e)
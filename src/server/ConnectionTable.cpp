@@ -0,0 +1,51 @@
+#include <string>
+#include <utility>
+#include <stdexcept>
+
+#include "server/ConnectionTable.hpp"
+
+ClientConnection& ConnectionTable::insert(const int file_descriptor)
+{
+	if (file_descriptor < 0)
+		throw std::runtime_error(
+			"Invalid client file descriptor: " + std::to_string(file_descriptor)
+		);
+
+	const size_t index = static_cast<size_t>(file_descriptor);
+
+	if (index >= slot_by_file_descriptor.size())
+		slot_by_file_descriptor.resize(index + 1, -1);
+
+	if (slot_by_file_descriptor[index] >= 0)
+		throw std::runtime_error(
+			"Client file descriptor already has a connection: " + std::to_string(file_descriptor)
+		);
+
+	slot_by_file_descriptor[index] = static_cast<int32_t>(connections.size());
+
+	ClientConnection& client_connection = connections.emplace_back();
+	client_connection.file_descriptor = file_descriptor;
+
+	return client_connection;
+}
+
+void ConnectionTable::erase(const int file_descriptor)
+{
+	const int32_t slot = get_slot(file_descriptor);
+
+	if (slot < 0)
+		return;
+
+	/* Swap-remove, the last connection takes over the freed slot */
+	if (static_cast<size_t>(slot) != connections.size() - 1)
+	{
+		connections[static_cast<size_t>(slot)] = std::move(connections.back());
+
+		slot_by_file_descriptor[static_cast<size_t>(
+			connections[static_cast<size_t>(slot)].file_descriptor
+		)] = slot;
+	}
+
+	connections.pop_back();
+	slot_by_file_descriptor[static_cast<size_t>(file_descriptor)] = -1;
+}
@@ -0,0 +1,105 @@
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <stdexcept>
+
+#include "server/EpollEventLoop.hpp"
+
+/* The epoll and poll bit values are identical on Linux, events pass through unchanged */
+static_assert(EPOLLIN == POLLIN && EPOLLOUT == POLLOUT, "epoll and poll flags differ");
+static_assert(EPOLLERR == POLLERR && EPOLLHUP == POLLHUP, "epoll and poll flags differ");
+
+EpollEventLoop::EpollEventLoop()
+	:	epoll_file_descriptor(epoll_create1(EPOLL_CLOEXEC)),
+		epoll_events{}
+{
+	if (epoll_file_descriptor < 0)
+		throw std::runtime_error(
+			"Failed to create epoll instance: " + std::string(strerror(errno))
+		);
+}
+
+EpollEventLoop::~EpollEventLoop()
+{
+	close(epoll_file_descriptor);
+}
+
+void EpollEventLoop::add_file_descriptor(const int file_descriptor, const uint32_t events)
+{
+	epoll_event epoll_file_descriptor_event	= {};
+
+	epoll_file_descriptor_event.events		= events;
+	epoll_file_descriptor_event.data.fd		= file_descriptor;
+
+	++backend_syscall_count;
+
+	if (epoll_ctl(
+		epoll_file_descriptor, EPOLL_CTL_ADD,
+		file_descriptor, &epoll_file_descriptor_event) < 0)
+		throw std::runtime_error(
+			"Epoll add failed for file descriptor "
+			+ std::to_string(file_descriptor)
+			+ ": " + strerror(errno)
+		);
+}
+
+void EpollEventLoop::modify_file_descriptor(const int file_descriptor, const uint32_t events)
+{
+	epoll_event epoll_file_descriptor_event	= {};
+
+	epoll_file_descriptor_event.events		= events;
+	epoll_file_descriptor_event.data.fd		= file_descriptor;
+
+	++backend_syscall_count;
+
+	if (epoll_ctl(
+		epoll_file_descriptor, EPOLL_CTL_MOD,
+		file_descriptor, &epoll_file_descriptor_event) < 0)
+		throw std::runtime_error(
+			"Epoll modify failed for file descriptor "
+			+ std::to_string(file_descriptor)
+			+ ": " + strerror(errno)
+		);
+}
+
+void EpollEventLoop::remove_file_descriptor(const int file_descriptor)
+{
+	++backend_syscall_count;
+
+	/* Failure only means the descriptor was never registered */
+	epoll_ctl(epoll_file_descriptor, EPOLL_CTL_DEL, file_descriptor, nullptr);
+}
+
+size_t EpollEventLoop::wait_for_events(
+	std::vector<EventLoopEvent>&	ready_events,
+	const int						timeout_milliseconds)
+{
+	ready_events.clear();
+
+	const int epoll_result = epoll_wait(
+		epoll_file_descriptor,
+		epoll_events,
+		_MAX_EPOLL_EVENTS,
+		timeout_milliseconds
+	);
+
+	++backend_syscall_count;
+
+	if (epoll_result < 0)
+	{
+		if (errno == EINTR)
+			return 0;
+
+		throw std::runtime_error(
+			"Epoll wait syscall failed."
+		);
+	}
+
+	for (int i = 0; i < epoll_result; ++i)
+		ready_events.push_back({
+			epoll_events[i].data.fd,
+			epoll_events[i].events
+		});
+
+	return ready_events.size();
+}
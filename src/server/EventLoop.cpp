@@ -0,0 +1,38 @@
+#include <iostream>
+#include <stdexcept>
+
+#include "server/EventLoop.hpp"
+#include "server/PollEventLoop.hpp"
+#include "server/EpollEventLoop.hpp"
+#include "server/UringEventLoop.hpp"
+
+std::unique_ptr<EventLoop> EventLoop::create(const EventLoopBackend backend)
+{
+	switch (backend)
+	{
+	case EventLoopBackend::POLL:
+		return std::make_unique<PollEventLoop>();
+
+	case EventLoopBackend::EPOLL:
+		return std::make_unique<EpollEventLoop>();
+
+	case EventLoopBackend::IO_URING:
+		try
+		{
+			return std::make_unique<UringEventLoop>();
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr
+				<< "WARNING: io_uring unavailable, falling back to poll: "
+				<< e.what()
+				<< "\n";
+
+			return std::make_unique<PollEventLoop>();
+		}
+	}
+
+	throw std::runtime_error(
+		"Unknown event loop backend"
+	);
+}
@@ -0,0 +1,103 @@
+#include <cerrno>
+#include <stdexcept>
+
+#include "server/PollEventLoop.hpp"
+
+void PollEventLoop::add_file_descriptor(const int file_descriptor, const uint32_t events)
+{
+	const size_t position_index = static_cast<size_t>(file_descriptor);
+
+	if (position_index >= poll_file_descriptor_positions.size())
+		poll_file_descriptor_positions.resize(position_index + 1, -1);
+
+	if (poll_file_descriptor_positions[position_index] != -1)
+		throw std::runtime_error(
+			"File descriptor is already monitored: " + std::to_string(file_descriptor)
+		);
+
+	pollfd poll_file_descriptor	= {};
+
+	poll_file_descriptor.fd		= file_descriptor;
+	poll_file_descriptor.events	= static_cast<short>(events);
+
+	poll_file_descriptor_positions[position_index] = static_cast<int>(poll_file_descriptors.size());
+	poll_file_descriptors.push_back(poll_file_descriptor);
+}
+
+void PollEventLoop::modify_file_descriptor(const int file_descriptor, const uint32_t events)
+{
+	const size_t position_index = static_cast<size_t>(file_descriptor);
+
+	if (position_index >= poll_file_descriptor_positions.size() ||
+		poll_file_descriptor_positions[position_index] == -1)
+		throw std::runtime_error(
+			"File descriptor is not monitored: " + std::to_string(file_descriptor)
+		);
+
+	poll_file_descriptors[static_cast<size_t>(
+		poll_file_descriptor_positions[position_index]
+	)].events = static_cast<short>(events);
+}
+
+void PollEventLoop::remove_file_descriptor(const int file_descriptor)
+{
+	const size_t position_index = static_cast<size_t>(file_descriptor);
+
+	if (position_index >= poll_file_descriptor_positions.size() ||
+		poll_file_descriptor_positions[position_index] == -1)
+		return;
+
+	const size_t removed_position = static_cast<size_t>(
+		poll_file_descriptor_positions[position_index]
+	);
+
+	/* Swap remove, the last entry takes the freed slot */
+	const pollfd& last_poll_file_descriptor = poll_file_descriptors.back();
+
+	poll_file_descriptor_positions[static_cast<size_t>(last_poll_file_descriptor.fd)] =
+		static_cast<int>(removed_position);
+
+	poll_file_descriptors[removed_position] = last_poll_file_descriptor;
+	poll_file_descriptors.pop_back();
+
+	poll_file_descriptor_positions[position_index] = -1;
+}
+
+size_t PollEventLoop::wait_for_events(
+	std::vector<EventLoopEvent>&	ready_events,
+	const int						timeout_milliseconds)
+{
+	ready_events.clear();
+
+	const int poll_result = poll(
+		poll_file_descriptors.data(),
+		poll_file_descriptors.size(),
+		timeout_milliseconds
+	);
+
+	++backend_syscall_count;
+
+	if (poll_result < 0)
+	{
+		if (errno == EINTR)
+			return 0;
+
+		throw std::runtime_error(
+			"Poll syscall failed."
+		);
+	}
+
+	for (const pollfd& poll_file_descriptor : poll_file_descriptors)
+	{
+		if (ready_events.size() == static_cast<size_t>(poll_result))
+			break;
+
+		if (poll_file_descriptor.revents)
+			ready_events.push_back({
+				poll_file_descriptor.fd,
+				static_cast<uint32_t>(static_cast<unsigned short>(poll_file_descriptor.revents))
+			});
+	}
+
+	return ready_events.size();
+}
@@ -1,10 +1,12 @@
 #include <fstream>
 #include <sstream>
+#include <cerrno>
 #include <cstring>
 #include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <iostream>
+#include <algorithm>
 #include <sys/stat.h>
 #include <filesystem>
 
@@ -12,31 +14,9 @@
 #include "server/RequestManager.hpp"
 
 RequestManager::RequestManager(
-	const ServerConfiguration* server_configuration
-)	: configuration(server_configuration) {}
-
-std::string RequestManager::resolve_url_path(const std::string &url) const
-{
-	const std::string clean_url = url.substr(0, url.find('?'));
-	std::string full_file_path = configuration->get_root_directory() + clean_url;
-
-	if (full_file_path.find("..") != std::string::npos)
-		throw std::runtime_error(
-			"Attempt to access restricted files"
-		);
-
-	return full_file_path;
-}
-
-bool RequestManager::is_directory(const std::string &directory_path) const
-{
-	struct stat directory_status = {};
-
-	if (stat(directory_path.c_str(), &directory_status))
-		return false;
-
-	return S_ISDIR((directory_status.st_mode));
-}
+	const ServerConfiguration*	server_configuration,
+	StaticFileCache&			file_cache
+)	: configuration(server_configuration), static_file_cache(file_cache) {}
 
 bool RequestManager::file_exists(const std::string &file_path) const
 {
@@ -44,61 +24,6 @@ bool RequestManager::file_exists(const std::string &file_path) const
 	return (!stat(file_path.c_str(), &file_status));
 }
 
-std::string RequestManager::url_decode(const std::string& encoded) const
-{
-	std::string decoded;
-
-	for (size_t i = 0; i < encoded.length(); ++i)
-	{
-		if (encoded[i] == '%' && i + 2 < encoded.length())
-		{
-			std::string hex_str = encoded.substr(i + 1, 2);
-
-			const char decoded_char = static_cast<char>(
-				std::stoi(hex_str, nullptr, 16)
-			);
-
-			decoded	+= decoded_char;
-			i		+= 2;
-		}
-		else if (encoded[i] == '+')
-			decoded += ' ';
-		else
-			decoded += encoded[i];
-	}
-
-	return (decoded);
-}
-
-std::string RequestManager::get_http_request_content_type(const std::string &file_path) const
-{
-	static const
-	std::unordered_map<std::string, std::string>
-	mime_types =
-	{
-		{"txt",		"txt"				},
-		{"html",	"text/html"			},
-		{"htm",		"text/html"			},
-		{"css",		"text/css"			},
-		{"jpg",		"image/jpeg"		},
-		{"jpeg",	"image/jpeg"		},
-		{"gif",		"image/gif"			},
-		{"pdf",		"application/pdf"	}
-	};
-
-	size_t dot_position = file_path.find_last_of('.');
-	if (dot_position == std::string::npos)
-		return "application/octet-stream";
-
-	std::string file_extension = file_path.substr(dot_position + 1);
-
-	auto it = mime_types.find(file_extension);
-	if (it != mime_types.end())
-		return it->second;
-	
-	return "application/octet-stream";
-}
-
 std::string RequestManager::get_directory_listing(
 	const std::string &directory_path,
 	const std::string &url
@@ -168,11 +93,15 @@ std::string RequestManager::get_directory_listing(
 			/* Enough for largest date string */
 			char time_str[25];
 
+			/* Reentrant variant, listings are built on every worker thread */
+			std::tm modification_time = {};
+			localtime_r(&file_stat.st_mtime, &modification_time);
+
 			std::strftime(
 				time_str,
 				sizeof(time_str),
 				"%Y-%m-%d %H:%M:%S",
-				localtime(&file_stat.st_mtime)
+				&modification_time
 			);
 
 			/* Determine buffer size at compile time since macro is known */
@@ -208,20 +137,16 @@ std::string RequestManager::handle_directory_listing(
 	const std::string&	url,
 	HttpResponse&		http_response) const
 {
-	if (!url_route->is_directory_listing_enabled())
-	{
-		if (!url_route->get_index_file().empty())
-		{
-			const std::string index_path = directory_path + "/"
-										 + url_route->get_index_file();
-
-			if (file_exists(index_path))
-				return index_path;
-		}
+	/* Remembered on the directory's cache entry, no stat() once it is cached */
+	const std::string index_path = static_file_cache.resolve_directory_index(
+		directory_path, url_route->get_index_file()
+	);
 
-		if (file_exists(directory_path + "/index.html"))
-			return directory_path + "/index.html";
+	if (!index_path.empty())
+		return index_path;
 
+	if (!url_route->is_directory_listing_enabled())
+	{
 		std::cerr
 			<< "ERROR INFO: No index file found and directory listing is disabled for: "
 			<< directory_path
@@ -235,43 +160,6 @@ std::string RequestManager::handle_directory_listing(
 		return "";
 	}
 
-	if (!file_exists(directory_path))
-	{
-		try
-		{
-			std::cout	<< "INFO: Creating directory: "
-						<< directory_path
-						<< "\n";
-
-			std::filesystem::create_directories(directory_path);
-		}
-		catch (const std::exception& e)
-		{
-			std::cerr	<< "ERROR: Failed to create directory: "
-						<< e.what()
-						<< "\n";
-
-			serve_error_page(
-				http_response,
-				HttpStatusCode::HTTP_500_INTERNAL_SERVER_ERROR
-			);
-
-			return "";
-		}
-	}
-
-	if (!url_route->get_index_file().empty())
-	{
-		const std::string index_path = directory_path + "/"
-									 + url_route->get_index_file();
-
-		if (file_exists(index_path))
-			return index_path;
-	}
-
-	if (file_exists(directory_path + "/index.html"))
-		return directory_path + "/index.html";
-
 	try
 	{
 		http_response.set_http_response_content_type("text/html");
@@ -304,9 +192,8 @@ void RequestManager::handle_http_get_request(
 {
 	try
 	{
-		const std::string	decoded_url = url_decode(url);
-		const Route*		url_route	= configuration->find_url_route_for_listening_port(
-											server_listening_port, decoded_url);
+		const Route* url_route = configuration->find_url_route_for_listening_port(
+									server_listening_port, url);
 
 		if (!url_route)
 		{
@@ -347,11 +234,18 @@ void RequestManager::handle_http_get_request(
 		}
 
 		const std::string	url_route_root_directory	= url_route->get_filesystem_root();
-		std::string			directory_path				= url_route_root_directory + decoded_url;
+		std::string			directory_path				= url_route_root_directory + url;
 
 		if (handle_cgi_request(url_route, directory_path, request, http_response)) return;
 
-		if (is_directory(directory_path))
+		/* Small files of content cache routes are answered from memory */
+		const size_t content_max_size = url_route->is_content_cache_enabled()
+			? configuration->get_content_cache_max_object_size() : 0;
+
+		/* A cached path costs no stat() and no open() */
+		const StaticFileEntry* file_entry = &static_file_cache.lookup(directory_path, content_max_size);
+
+		if (file_entry->type == StaticFileType::DIRECTORY)
 		{
 			const std::string resolved_path = handle_directory_listing(
 				url_route, directory_path, url, http_response
@@ -360,10 +254,11 @@ void RequestManager::handle_http_get_request(
 			if (resolved_path.empty())
 				return;
 
-			directory_path = resolved_path;
+			directory_path	= resolved_path;
+			file_entry		= &static_file_cache.lookup(directory_path, content_max_size);
 		}
 
-		if (!file_exists(directory_path))
+		if (file_entry->type == StaticFileType::MISSING)
 		{
 			std::cerr
 				<< "ERROR INFO: File does not exist: "
@@ -378,9 +273,7 @@ void RequestManager::handle_http_get_request(
 			return;
 		}
 
-		http_response.set_http_response_content_type(get_http_request_content_type(directory_path));
-		http_response.set_http_response_body(get_file_content(directory_path));
-		http_response.set_http_response_status_code(HttpStatusCode::HTTP_200_OK);
+		serve_static_file(*file_entry, http_response);
 	}
 	catch (const std::exception& e)
 	{
@@ -398,6 +291,41 @@ void RequestManager::handle_http_get_request(
 	}
 }
 
+void RequestManager::serve_static_file(
+	const StaticFileEntry&	file_entry,
+	HttpResponse&			http_response) const
+{
+	/* A FIFO or a device has no length to announce and could block the worker */
+	if (file_entry.type != StaticFileType::REGULAR || !file_entry.file)
+	{
+		std::cerr
+			<< "ERROR INFO: Not a readable regular file: "
+			<< file_entry.path
+			<< "\n";
+
+		serve_error_page(
+			http_response,
+			HttpStatusCode::HTTP_403_FORBIDDEN
+		);
+
+		return;
+	}
+
+	/* Headers and body built when the file was cached, the response only adds its own headers */
+	if (file_entry.response_content)
+	{
+		http_response.set_http_response_prebuilt_content(file_entry.response_content);
+		http_response.set_http_response_status_code(HttpStatusCode::HTTP_200_OK);
+
+		return;
+	}
+
+	/* The response shares the cached descriptor, it stays open until the last byte is sent */
+	http_response.set_http_response_content_type(file_entry.content_type);
+	http_response.set_http_response_file_body(file_entry.file, 0, file_entry.size);
+	http_response.set_http_response_status_code(HttpStatusCode::HTTP_200_OK);
+}
+
 void RequestManager::handle_http_post_request(
 	const std::string&	url,
 	const HttpRequest&	http_request,
@@ -406,30 +334,6 @@ void RequestManager::handle_http_post_request(
 {
 	try
 	{
-		if (http_request.has_http_request_header("content-length"))
-		{
-			const size_t http_post_request_expected_length = std::stoull(
-				http_request.get_http_request_header("content-length")
-			);
-
-			if (http_post_request_expected_length > configuration->get_max_post_request_size())
-			{
-				std::cerr
-					<< "ERROR INFO: Content-Length ("
-					<< http_post_request_expected_length
-					<< ") exceeds allowed limit.\n";
-
-				http_response.set_http_response_status_code(
-					HttpStatusCode::HTTP_413_PAYLOAD_TOO_LARGE
-				);
-
-				http_response.set_http_response_content_type("text/html");
-				http_response.set_http_response_body(HTTP_PAGE_413_PAYLOAD_TOO_LARGE);
-
-				return;
-			}
-		}
-
 		const Route* url_route = configuration->find_url_route_for_listening_port(server_listening_port, url);
 
 		if (!url_route || !url_route->is_http_method_allowed(HttpMethod::POST))
@@ -452,47 +356,47 @@ void RequestManager::handle_http_post_request(
 		if (upload_directory.substr(0, 2) == "./")
 			upload_directory = upload_directory.substr(2);
 
-		std::string filename;
-		std::string http_post_request_processed_body;
+		/* The parser already split the form into parts, each file is saved under its own name */
+		if (http_request.is_multipart() && http_request.get_http_request_body_length())
+		{
+			save_http_request_multipart_parts(http_request, upload_directory);
 
-		if (!http_request.has_http_request_header("content-length") ||
-			http_request.get_http_request_header("content-length") == "0")
-			filename = "empty_post_" + std::to_string(std::time(nullptr)) + ".txt";
+			http_response.set_http_response_status_code(HttpStatusCode::HTTP_201_CREATED);
+			http_response.set_http_response_content_type("text/html");
+			http_response.set_http_response_body(HTTP_PAGE_201_CREATED);
 
-		else if (http_request.get_http_request_header("Content-Type")
-					.find("multipart/form-data") != std::string::npos &&
-				!http_request.get_http_request_boundary().empty())
-		{
-			http_post_request_processed_body = remove_http_request_boundary(
-				http_request.get_http_request_body(),
-				http_request.get_http_request_boundary()
-			);
+			return;
+		}
 
-			size_t filename_start_index = http_request.get_http_request_body().find("filename=\"");
-			if (filename_start_index != std::string::npos)
-			{
-				filename_start_index += std::string("filename=\"").length();
+		std::string			filename;
+		std::string_view	http_post_request_processed_body;
 
-				const size_t filename_end_index = http_request.get_http_request_body()
-													.find("\"", filename_start_index);
+		if (!http_request.get_http_request_body_length())
+			filename = "empty_post_" + std::to_string(std::time(nullptr)) + ".txt";
 
-				if (filename_end_index != std::string::npos)
-					filename = http_request.get_http_request_body().substr(
-						filename_start_index, filename_end_index - filename_start_index
-					);
-			}
-		}
 		else
 		{
 			filename = "post_" + std::to_string(std::time(nullptr)) + ".txt";
 			http_post_request_processed_body = http_request.get_http_request_body();
 		}
 
-		if (filename.empty())
-			filename = "unnamed_" + std::to_string(std::time(nullptr)) + ".txt";
-
 		const std::string filepath = upload_directory + "/" + filename;
 
+		/* A GET pipelined right behind must not be served the previous file */
+		static_file_cache.invalidate(filepath);
+
+		/* The spool file is the upload, it is linked into place instead of copied */
+		if (http_request.is_http_request_body_spooled())
+		{
+			http_request.get_http_request_body_spool().save_as(filepath);
+
+			http_response.set_http_response_status_code(HttpStatusCode::HTTP_201_CREATED);
+			http_response.set_http_response_content_type("text/html");
+			http_response.set_http_response_body(HTTP_PAGE_201_CREATED);
+
+			return;
+		}
+
 		const int file_descriptor = open(
 			filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644
 		);
@@ -519,7 +423,7 @@ void RequestManager::handle_http_post_request(
 		if (!http_post_request_processed_body.empty())
 		{
 			bytes_written = write(file_descriptor,
-				http_post_request_processed_body.c_str(),
+				http_post_request_processed_body.data(),
 				http_post_request_processed_body.length()
 			);
 
@@ -561,6 +465,59 @@ void RequestManager::handle_http_post_request(
 	}
 }
 
+bool RequestManager::accept_http_request_body(
+	const HttpRequest&	http_request,
+	HttpResponse&		http_response,
+	const int			server_listening_port) const
+{
+	const std::string&	url			= http_request.get_http_request_path();
+	const HttpMethod	http_method	= http_request.get_http_request_method();
+
+	/* Same lookup as the handlers */
+	const Route* url_route = configuration->find_url_route_for_listening_port(server_listening_port, url);
+
+	switch (http_method)
+	{
+	case HttpMethod::GET:
+		if (url_route)
+			return true;
+		break;
+
+	case HttpMethod::POST:
+		if (url_route && url_route->is_http_method_allowed(HttpMethod::POST))
+			return true;
+		break;
+
+	case HttpMethod::DELETE:
+		if (url_route && url_route->is_http_method_allowed(HttpMethod::DELETE))
+			return true;
+		break;
+
+	default:
+		break;
+	}
+
+	std::cerr
+		<< "ERROR INFO: Refused the body of the request for URL: "
+		<< url
+		<< " on port: "
+		<< server_listening_port
+		<< "\n";
+
+	/* A missing route is forbidden for GET and DELETE, POST and unknown methods answer 405 like their handlers */
+	if (!url_route && (http_method == HttpMethod::GET || http_method == HttpMethod::DELETE))
+	{
+		http_response.set_http_response_status_code(HttpStatusCode::HTTP_403_FORBIDDEN);
+		return false;
+	}
+
+	http_response.set_http_response_status_code(HttpStatusCode::HTTP_405_METHOD_NOT_ALLOWED);
+	http_response.set_http_response_content_type("text/html");
+	http_response.set_http_response_body(HTTP_PAGE_405_METHOD_NOT_ALLOWED);
+
+	return false;
+}
+
 void RequestManager::handle_http_delete_request(
 	const std::string&	url,
 	HttpResponse&		http_response,
@@ -608,8 +565,8 @@ void RequestManager::handle_http_delete_request(
 		if (upload_directory.substr(0, 2) == "./")
 			upload_directory = upload_directory.substr(2);
 
-		const std::string encoded_filename	= url.substr(url.find_last_of('/') + 1);
-		const std::string filename			= url_decode(encoded_filename);
+		/* Already decoded, and a normalized path has no ".." segment */
+		const std::string filename = url.substr(url.find_last_of('/') + 1);
 
 		if (filename.empty())
 		{
@@ -641,6 +598,8 @@ void RequestManager::handle_http_delete_request(
 			return;
 		}
 
+		static_file_cache.invalidate(filepath);
+
 		if (std::remove(filepath.c_str()) != 0)
 		{
 			std::cerr
@@ -741,14 +700,17 @@ void RequestManager::serve_error_page(
 		const std::string error_page_path = configuration->get_root_directory() + '/'
 										  + configuration->get_default_error_page_path();
 
-		if (file_exists(error_page_path))
+		const StaticFileEntry& error_page = static_file_cache.lookup(error_page_path);
+
+		/* Sent from the cached descriptor like any other file */
+		if (error_page.type == StaticFileType::REGULAR && error_page.file)
 		{
 			http_response.set_http_response_content_type("text/html");
-			http_response.set_http_response_body(get_file_content(error_page_path));
+			http_response.set_http_response_file_body(error_page.file, 0, error_page.size);
 		}
 		else
 		{
-			const std::string basic_error =
+			std::string basic_error =
 			"<html><body><h1>Error "
 			+ std::to_string(static_cast<int>(http_status_code))
 			+ "</h1><p>"
@@ -756,7 +718,7 @@ void RequestManager::serve_error_page(
 			+ "</p></body></html>";
 
 			http_response.set_http_response_content_type("text/html");
-			http_response.set_http_response_body(basic_error);
+			http_response.set_http_response_body(std::move(basic_error));
 		}
 
 		http_response.set_http_response_status_code(http_status_code);
@@ -777,37 +739,83 @@ void RequestManager::serve_error_page(
 	}
 }
 
-std::string RequestManager::remove_http_request_boundary(
-	const std::string&	http_request_body,
-	const std::string&	http_request_boundary) const
+std::string RequestManager::get_upload_filename(std::string_view filename)
 {
-	std::string full_boundary = "--" + http_request_boundary;
-	
-	size_t pos = http_request_body.find(full_boundary);
+	/* Browsers on Windows used to send the full path of the file */
+	const size_t separator_position = filename.find_last_of("/\\");
 
-	if (pos == std::string::npos)
-		throw std::runtime_error(
-			"Couldn't find first request boundary"
-		);
-	
-	pos = http_request_body.find("\r\n\r\n", pos);
-	if (pos == std::string::npos)
-		throw std::runtime_error(
-			"Couldn't find end of request headers"
-		);
-	
-	const size_t content_start = pos + 4;
-	
-	size_t content_end = http_request_body.find(full_boundary, content_start);
-	if (content_end == std::string::npos)
-		throw std::runtime_error(
-			"Couldn't find ending request boundary"
-		);
-	
-	if (content_end >= 2 && http_request_body.substr(content_end - 2, 2) == "\r\n")
-		content_end -= 2;
-	
-	return http_request_body.substr(
-		content_start, content_end - content_start
-	);
+	if (separator_position != std::string_view::npos)
+		filename.remove_prefix(separator_position + 1);
+
+	if (filename == "." || filename == ".." || filename.find('\0') != std::string_view::npos)
+		return "";
+
+	return std::string(filename);
+}
+
+void RequestManager::save_http_request_multipart_parts(
+	const HttpRequest&	http_request,
+	const std::string&	upload_directory) const
+{
+	const std::vector<HttpMultipartPart>& parts = http_request.get_http_request_multipart_parts();
+
+	const bool has_file_part = std::any_of(parts.begin(), parts.end(), [](const HttpMultipartPart& part)
+	{
+		return !part.filename.empty();
+	});
+
+	size_t saved_part_count = 0;
+
+	for (const HttpMultipartPart& part : parts)
+	{
+		if (has_file_part ? part.filename.empty() : &part != &parts.front())
+			continue;
+
+		std::string filename = get_upload_filename(part.filename);
+
+		if (filename.empty())
+			filename = "unnamed_" + std::to_string(std::time(nullptr)) + "_" + std::to_string(saved_part_count) + ".txt";
+
+		const std::string filepath = upload_directory + "/" + filename;
+
+		++saved_part_count;
+
+		static_file_cache.invalidate(filepath);
+
+		if (part.content_spool.is_open())
+		{
+			part.content_spool.save_as(filepath);
+			continue;
+		}
+
+		const int file_descriptor = open(filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+		if (file_descriptor < 0)
+			throw std::runtime_error(
+				"Failed to open file for writing: " + filepath + ": " + strerror(errno)
+			);
+
+		for (std::string_view content = part.content; !content.empty(); )
+		{
+			const ssize_t bytes_written = write(file_descriptor, content.data(), content.length());
+
+			if (bytes_written < 0 && errno == EINTR)
+				continue;
+
+			if (bytes_written < 0)
+			{
+				const int write_errno = errno;
+
+				close(file_descriptor);
+
+				throw std::runtime_error(
+					"Failed to write to file: " + filepath + ": " + strerror(write_errno)
+				);
+			}
+
+			content.remove_prefix(static_cast<size_t>(bytes_written));
+		}
+
+		close(file_descriptor);
+	}
 }
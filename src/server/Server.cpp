@@ -1,221 +1,538 @@
 #include <vector>
 #include <sstream>
 #include <cstring>
+#include <climits>
 #include <fcntl.h>
 #include <unistd.h>
 #include <iostream>
+#include <algorithm>
 #include <stdexcept>
 #include <arpa/inet.h>
 #include <sys/socket.h>
-#include <unordered_set>
+#include <sys/sendfile.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
 
 #include "server/Server.hpp"
 #include "server/RequestManager.hpp"
 
-#include "utils/utils.hpp"
-
-Server::Server(const ServerConfiguration* configuration)
-	:	socket_address_configuration{},
-		server_configuration(configuration)
+Server::Server(const ServerConfiguration* configuration, const size_t worker_index)
+	:	server_configuration(configuration),
+		server_worker_index(worker_index),
+		reserve_file_descriptor(-1),
+		wakeup_file_descriptor(-1),
+		is_draining(false),
+		graceful_shutdown_requested(false),
+		server_running(false)
 {
 	if (!server_configuration || !server_configuration->is_valid())
 		throw std::runtime_error("Invalid server configuration");
 
-	const std::unordered_set<int> server_listening_ports =
-		server_configuration->get_server_listening_ports();
+	static_file_cache.set_content_cache_size(server_configuration->get_content_cache_size());
+	http_response_default_headers.set_keepalive_timeout(server_configuration->get_keepalive_timeout());
+}
+
+Server::~Server()
+{
+	for (const int server_file_descriptor : server_file_descriptors)
+		close(server_file_descriptor);
 
-	for (const int server_listening_port : server_listening_ports)
+	if (reserve_file_descriptor >= 0)
+		close(reserve_file_descriptor);
+
+	if (wakeup_file_descriptor >= 0)
+		close(wakeup_file_descriptor);
+}
+
+int Server::create_server_file_descriptor(const int server_listening_port) const
+{
+	/* Non-blocking so the accept loop can stop at EAGAIN */
+	int server_file_descriptor = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+	if (server_file_descriptor < 0)
 	{
-		main_socket_file_descriptor = socket(AF_INET, SOCK_STREAM, 0);
+		std::cerr
+			<< "ERROR INFO: Failed to create socket for port "
+			<< server_listening_port
+			<< ": "
+			<< strerror(errno)
+			<< "\n";
 
-		if (main_socket_file_descriptor < 0)
-			throw std::runtime_error(
-				"Failed to create main server socket on server listening port "
-				+ std::to_string(server_listening_port)
-			);
+		return -1;
+	}
 
-		const int current_socket_flags = fcntl(main_socket_file_descriptor, F_GETFL, 0);
+	int enable_reuse_socket_address = 1;
 
-		if (current_socket_flags == -1)
-			throw std::runtime_error("Fcntl F_GETFL failed");
+	if (setsockopt(
+		server_file_descriptor,
+		SOL_SOCKET, SO_REUSEADDR,
+		&enable_reuse_socket_address,
+		sizeof(enable_reuse_socket_address)) < 0)
+	{
+		std::cerr
+			<< "ERROR INFO: Setsockopt failed for port "
+			<< server_listening_port
+			<< ": "
+			<< strerror(errno)
+			<< "\n";
 
-		if (fcntl(main_socket_file_descriptor, F_SETFL, current_socket_flags | O_NONBLOCK) == -1)
-			throw std::runtime_error("Fcntl F_SETFL failed");
+		close(server_file_descriptor);
+		return -1;
+	}
 
-		int enable_reuse_socket_address = 1;
+	/* Every worker binds its own socket, the kernel balances connections between them */
+	if (setsockopt(
+		server_file_descriptor,
+		SOL_SOCKET, SO_REUSEPORT,
+		&enable_reuse_socket_address,
+		sizeof(enable_reuse_socket_address)) < 0)
+	{
+		std::cerr
+			<< "ERROR INFO: Setsockopt SO_REUSEPORT failed for port "
+			<< server_listening_port
+			<< ": "
+			<< strerror(errno)
+			<< "\n";
+
+		close(server_file_descriptor);
+		return -1;
+	}
 
-		if (setsockopt(
-			main_socket_file_descriptor,
-			SOL_SOCKET, SO_REUSEADDR,
-			&enable_reuse_socket_address,
-			sizeof(enable_reuse_socket_address)) < 0)
-			throw std::runtime_error("Setsockopt failed");
+	sockaddr_in socket_address = {};
 
-		socket_address_configuration.sin_family			= AF_INET;
-		socket_address_configuration.sin_addr.s_addr	= INADDR_ANY;
-		socket_address_configuration.sin_port			= htons(static_cast
-															<short unsigned int>
-															(server_listening_port));
+	socket_address.sin_family		= AF_INET;
+	socket_address.sin_addr.s_addr	= INADDR_ANY;
+	socket_address.sin_port			= htons(static_cast
+										<short unsigned int>
+										(server_listening_port));
+
+	if (bind(
+		server_file_descriptor,
+		reinterpret_cast<sockaddr*>(&socket_address),
+		sizeof(socket_address)) < 0)
+	{
+		std::cerr
+			<< "ERROR INFO: Failed to bind to port "
+			<< server_listening_port
+			<< ": "
+			<< strerror(errno)
+			<< "\n";
+
+		close(server_file_descriptor);
+		return -1;
+	}
+
+	if (listen(server_file_descriptor, server_configuration->get_listen_backlog()) < 0)
+	{
+		std::cerr
+			<< "ERROR INFO: Failed to listen on port "
+			<< server_listening_port
+			<< ": "
+			<< strerror(errno)
+			<< "\n";
+
+		close(server_file_descriptor);
+		return -1;
 	}
+
+	return server_file_descriptor;
 }
 
-Server::~Server()
+int Server::take_inherited_server_file_descriptor(
+	const int			server_listening_port,
+	std::vector<int>&	inherited_server_file_descriptors)
 {
-	for (const int server_file_descriptor : server_file_descriptors)
-		close(server_file_descriptor);
+	for (auto it = inherited_server_file_descriptors.begin(); it != inherited_server_file_descriptors.end(); ++it)
+	{
+		sockaddr_in	socket_address = {};
+		socklen_t	socket_address_length = sizeof(socket_address);
+
+		if (getsockname(*it, reinterpret_cast<sockaddr*>(&socket_address), &socket_address_length) < 0 ||
+			socket_address.sin_family != AF_INET ||
+			ntohs(socket_address.sin_port) != server_listening_port)
+			continue;
+
+		const int server_file_descriptor = *it;
+
+		inherited_server_file_descriptors.erase(it);
+
+		/* Descriptors passed through execve() lost their close-on-exec flag */
+		fcntl(server_file_descriptor, F_SETFD, FD_CLOEXEC);
+		fcntl(server_file_descriptor, F_SETFL, fcntl(server_file_descriptor, F_GETFL) | O_NONBLOCK);
+
+		return server_file_descriptor;
+	}
+
+	return -1;
 }
 
-void Server::setup_server()
+void Server::setup_server(
+	std::vector<int>&	inherited_server_file_descriptors,
+	const bool			adopt_every_inherited_match)
 {
 	for (const int server_listening_port : server_configuration->get_server_listening_ports())
 	{
-		int server_file_descriptor = socket(AF_INET, SOCK_STREAM, 0);
+		/* A socket that is already listening keeps the connections waiting in its queue */
+		int server_file_descriptor = take_inherited_server_file_descriptor(
+			server_listening_port, inherited_server_file_descriptors
+		);
 
 		if (server_file_descriptor < 0)
-		{
-			std::cerr
-				<< "ERROR INFO: Failed to create socket for port "
-				<< server_listening_port
-				<< ": "
-				<< strerror(errno)
-				<< "\n";
+			server_file_descriptor = create_server_file_descriptor(server_listening_port);
 
+		if (server_file_descriptor < 0)
 			continue;
-		}
 
-		int enable_reuse_socket_address = 1;
+		server_file_descriptors.push_back(server_file_descriptor);
 
-		if (setsockopt(
-			server_file_descriptor,
-			SOL_SOCKET, SO_REUSEADDR,
-			&enable_reuse_socket_address,
-			sizeof(enable_reuse_socket_address)) < 0)
-		{
-			std::cerr
-				<< "ERROR INFO: Setsockopt failed for port "
-				<< server_listening_port
-				<< ": "
-				<< strerror(errno)
-				<< "\n";
+		while (adopt_every_inherited_match &&
+			(server_file_descriptor = take_inherited_server_file_descriptor(
+				server_listening_port, inherited_server_file_descriptors)) >= 0)
+			server_file_descriptors.push_back(server_file_descriptor);
+	}
 
-			close(server_file_descriptor);
-			continue;
-		}
+	if (server_file_descriptors.empty())
+		throw std::runtime_error(
+			"No valid ports to bind and listen to. Exiting..."
+		);
 
-		sockaddr_in socket_address = {};
+	reserve_file_descriptor	= open("/dev/null", O_RDONLY | O_CLOEXEC);
+	wakeup_file_descriptor	= eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
 
-		socket_address.sin_family		= AF_INET;
-		socket_address.sin_addr.s_addr	= INADDR_ANY;
-		socket_address.sin_port			= htons(static_cast
-											<short unsigned int>
-											(server_listening_port));
+	if (wakeup_file_descriptor < 0)
+		throw std::runtime_error(
+			"Failed to create the worker wakeup descriptor: " + std::string(strerror(errno))
+		);
 
-		if (bind(
-			server_file_descriptor,
-			reinterpret_cast<sockaddr*>(&socket_address),
-			sizeof(socket_address)) < 0)
+	/* Set here rather than in start_server() so a stop requested before the thread runs is not lost */
+	set_server_running(true);
+}
+
+void Server::wake_up() noexcept
+{
+	const uint64_t increment = 1;
+
+	[[maybe_unused]] const ssize_t bytes_written = write(wakeup_file_descriptor, &increment, sizeof(increment));
+}
+
+void Server::request_stop() noexcept
+{
+	set_server_running(false);
+	wake_up();
+}
+
+void Server::request_graceful_shutdown() noexcept
+{
+	graceful_shutdown_requested = true;
+	wake_up();
+}
+
+void Server::begin_graceful_shutdown()
+{
+	is_draining		= true;
+	drain_deadline	= TimerWheel::Clock::now()
+					+ std::chrono::seconds(server_configuration->get_shutdown_timeout());
+
+	/* Pending connections stay queued on the sockets for whoever else still holds them */
+	for (const int server_file_descriptor : server_file_descriptors)
+	{
+		event_loop->remove_file_descriptor(server_file_descriptor);
+		close(server_file_descriptor);
+	}
+
+	server_file_descriptors.clear();
+
+	/* The only scan of the table, the busy connections are closed as they finish */
+	close_idle_client_connections();
+
+	std::cout
+		<< "INFO: Worker " << server_worker_index
+		<< " stopped accepting, draining "
+		<< client_connections.size()
+		<< " connections\n";
+}
+
+bool Server::is_client_connection_idle(const ClientConnection& client_connection) const
+{
+	if (!client_connection.pending_http_response_segments.empty() ||
+		client_connection.http_request.has_http_request_data())
+		return false;
+
+	char unread_byte;
+
+	/* A request already waiting in the socket is still served */
+	return recv(client_connection.file_descriptor, &unread_byte, 1, MSG_PEEK | MSG_DONTWAIT) <= 0;
+}
+
+void Server::close_idle_client_connections()
+{
+	std::vector<int> idle_file_descriptors;
+
+	for (const ClientConnection& client_connection : client_connections)
+		if (is_client_connection_idle(client_connection))
+			idle_file_descriptors.push_back(client_connection.file_descriptor);
+
+	for (const int client_file_descriptor : idle_file_descriptors)
+		close_client_connection(client_file_descriptor);
+}
+
+void Server::close_all_client_connections()
+{
+	std::vector<int> client_file_descriptors;
+
+	for (const ClientConnection& client_connection : client_connections)
+		client_file_descriptors.push_back(client_connection.file_descriptor);
+
+	for (const int client_file_descriptor : client_file_descriptors)
+		close_client_connection(client_file_descriptor);
+}
+
+void Server::handle_client_write(const int client_file_descriptor)
+{
+	flush_http_responses(client_file_descriptor);
+}
+
+/* Logs the 1st, 2nd, 4th, 8th... occurrence so a sustained overload does not flood the log */
+static inline bool is_power_of_two(const size_t count)
+{
+	return count && !(count & (count - 1));
+}
+
+void Server::handle_incoming_client_connection(const int server_file_descriptor)
+{
+	for (size_t accept_count = 0; accept_count < _MAX_ACCEPTS_PER_EVENT; ++accept_count)
+	{
+		sockaddr_in client_address;
+
+		socklen_t client_address_length		= sizeof(client_address);
+		const int client_file_descriptor	= accept4(
+												server_file_descriptor,
+												reinterpret_cast<sockaddr*>(&client_address),
+												&client_address_length,
+												SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+		if (client_file_descriptor < 0)
 		{
+			/* Queue drained */
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return;
+
+			/* The client gave up while queued, or a signal arrived */
+			if (errno == ECONNABORTED || errno == EINTR)
+				continue;
+
+			if (errno == EMFILE || errno == ENFILE)
+			{
+				handle_descriptor_exhaustion(server_file_descriptor);
+				return;
+			}
+
 			std::cerr
-				<< "ERROR INFO: Failed to bind to port "
-				<< server_listening_port
-				<< ": "
+				<< "ERROR INFO: Failed to accept client connection on server socket "
+				<< server_file_descriptor
+				<< ". Error: "
 				<< strerror(errno)
 				<< "\n";
 
-			close(server_file_descriptor);
-			continue;
+			return;
 		}
 
-		if (listen(server_file_descriptor, 5) < 0)
+		try
+		{
+			event_loop->add_file_descriptor(client_file_descriptor, POLLIN);
+		}
+		catch (const std::exception& e)
 		{
 			std::cerr
-				<< "ERROR INFO: Failed to listen on port "
-				<< server_listening_port
+				<< "ERROR INFO: Failed to monitor client socket "
+				<< client_file_descriptor
 				<< ": "
-				<< strerror(errno)
+				<< e.what()
 				<< "\n";
 
-			close(server_file_descriptor);
+			close(client_file_descriptor);
 			continue;
 		}
 
-		server_file_descriptors.push_back(server_file_descriptor);
-	}
+		ClientConnection& client_connection = client_connections.insert(client_file_descriptor);
 
-	if (server_file_descriptors.empty())
-		throw std::runtime_error(
-			"No valid ports to bind and listen to. Exiting..."
+		client_connection.http_request.set_http_request_max_body_size(
+			server_configuration->get_max_request_body_size(),
+			server_configuration->get_max_post_request_size()
 		);
 
-	Utils::register_signal_handler(this);
-}
+		client_connection.http_request.set_http_request_body_spooling(
+			server_configuration->get_client_body_buffer_size(),
+			server_configuration->get_client_body_temp_path()
+		);
 
-void Server::handle_client_write(const size_t index)
-{
-	const int client_file_descriptor	= poll_file_descriptors[index].fd;
-	const HttpRequest& http_request		= client_http_requests[client_file_descriptor];
+		arm_connection_timer(client_connection);
+
+		++accept_counters.accepted_connections;
+
+		std::cout
+			<< "INFO: New client connection accepted on socket "
+			<< server_file_descriptor
+			<< "\n";
+	}
+
+	/* Still connections waiting, the rest is accepted after the other ready sockets had their turn */
+	++accept_counters.accept_limit_hits;
+
+	tcp_info listen_queue_info = {};
+	socklen_t listen_queue_info_length = sizeof(listen_queue_info);
 
-	if (http_request.is_http_request_complete_check())
+	/* On a listening socket tcpi_unacked is the accept queue length and tcpi_sacked its limit */
+	if (!getsockopt(server_file_descriptor, IPPROTO_TCP, TCP_INFO, &listen_queue_info, &listen_queue_info_length) &&
+		listen_queue_info.tcpi_unacked >= listen_queue_info.tcpi_sacked)
 	{
-		determine_http_method_from_http_request(client_file_descriptor, http_request);
-		poll_file_descriptors[index].events = POLLIN;
+		++accept_counters.full_listen_queue_observations;
+
+		if (is_power_of_two(accept_counters.full_listen_queue_observations))
+			std::cerr
+				<< "ERROR INFO: Accept queue of server socket "
+				<< server_file_descriptor
+				<< " is full ("
+				<< listen_queue_info.tcpi_sacked
+				<< " connections), new handshakes are being dropped. Consider raising listen_backlog.\n";
 	}
 }
 
-void Server::handle_incoming_client_connection(const int server_file_descriptor)
+void Server::handle_descriptor_exhaustion(const int server_file_descriptor)
 {
-	sockaddr_in client_address;
-
-	socklen_t client_address_length		= sizeof(client_address);
-	const int client_file_descriptor	= accept(
-											server_file_descriptor,
-											reinterpret_cast<sockaddr*>(&client_address),
-											&client_address_length);
+	++accept_counters.descriptor_exhaustion_drops;
 
-	if (client_file_descriptor < 0)
-	{
+	if (is_power_of_two(accept_counters.descriptor_exhaustion_drops))
 		std::cerr
-			<< "ERROR INFO: Failed to accept client connection on server socket "
+			<< "ERROR INFO: Out of file descriptors, dropping a pending connection on server socket "
 			<< server_file_descriptor
-			<< ". Error: "
-			<< strerror(errno)
 			<< "\n";
 
+	/*
+		The pending connection keeps the listening socket readable, so leaving it
+		queued would spin the event loop. The reserved descriptor is released to
+		accept it and close it right away, then reserved again.
+	*/
+	if (reserve_file_descriptor < 0)
 		return;
-	}
 
-	const int current_socket_status_flags = fcntl(client_file_descriptor, F_GETFL, 0);
+	close(reserve_file_descriptor);
 
-	if (current_socket_status_flags == -1 || fcntl(
-			client_file_descriptor, F_SETFL,
-			current_socket_status_flags | O_NONBLOCK
-		) == -1)
-	{
-		std::cerr
-			<< "ERROR INFO: Failed to set client socket "
-			<< client_file_descriptor
-			<< " to non-blocking mode.\n";
+	const int client_file_descriptor = accept4(server_file_descriptor, nullptr, nullptr, SOCK_CLOEXEC);
 
+	if (client_file_descriptor >= 0)
 		close(client_file_descriptor);
-		return;
+
+	reserve_file_descriptor = open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+void Server::close_client_connection(const int client_file_descriptor)
+{
+	event_loop->remove_file_descriptor(client_file_descriptor);
+	close(client_file_descriptor);
+
+	connection_timers.cancel(client_file_descriptor);
+	client_connections.erase(client_file_descriptor);
+}
+
+void Server::arm_connection_timer(ClientConnection& client_connection)
+{
+	const HttpRequest& http_request = client_connection.http_request;
+
+	ConnectionTimeout	connection_timeout;
+	size_t				timeout_seconds;
+
+	if (client_connection.is_lingering)
+	{
+		connection_timeout	= ConnectionTimeout::LINGER;
+		timeout_seconds		= _LINGERING_TIMEOUT_SECONDS;
+	}
+	else if (client_connection.is_waiting_for_writable)
+	{
+		connection_timeout	= ConnectionTimeout::SEND;
+		timeout_seconds		= server_configuration->get_send_timeout();
+	}
+	else if (!http_request.has_http_request_data() && client_connection.served_request_count)
+	{
+		connection_timeout	= ConnectionTimeout::KEEPALIVE;
+		timeout_seconds		= server_configuration->get_keepalive_timeout();
+	}
+	else if (!http_request.are_http_request_headers_complete())
+	{
+		connection_timeout	= ConnectionTimeout::HEADER;
+		timeout_seconds		= server_configuration->get_client_header_timeout();
+	}
+	else
+	{
+		connection_timeout	= ConnectionTimeout::BODY;
+		timeout_seconds		= server_configuration->get_client_body_timeout();
 	}
 
-	pollfd client_poll_file_descriptor	= {};
+	/* The header deadline counts from the start of the request, trickling bytes does not extend it */
+	if (connection_timeout == ConnectionTimeout::HEADER &&
+		client_connection.active_timeout == ConnectionTimeout::HEADER &&
+		connection_timers.is_scheduled(client_connection.file_descriptor))
+		return;
 
-	client_poll_file_descriptor.fd		= client_file_descriptor;
-	client_poll_file_descriptor.events	= POLLIN;
+	client_connection.active_timeout = connection_timeout;
 
-	poll_file_descriptors.push_back(client_poll_file_descriptor);
+	connection_timers.schedule(
+		client_connection.file_descriptor,
+		std::chrono::seconds(timeout_seconds)
+	);
+}
 
-	client_http_requests[client_file_descriptor] = HttpRequest();
+void Server::handle_expired_connection_timers()
+{
+	connection_timers.advance(expired_file_descriptors);
 
-	std::cout
-		<< "INFO: New client connection accepted on socket "
-		<< server_file_descriptor
-		<< "\n";
+	for (const int client_file_descriptor : expired_file_descriptors)
+	{
+		ClientConnection* client_connection = client_connections.find(client_file_descriptor);
+
+		if (!client_connection)
+			continue;
+
+		const bool is_request_timeout
+			= (client_connection->active_timeout == ConnectionTimeout::HEADER ||
+			   client_connection->active_timeout == ConnectionTimeout::BODY)
+			&& client_connection->http_request.has_http_request_data();
+
+		/* Idle keep-alive, stalled send or a connection that never sent a byte */
+		if (!is_request_timeout)
+		{
+			close_client_connection(client_file_descriptor);
+			continue;
+		}
+
+		std::cerr
+			<< "INFO: Request timed out. Client FD: "
+			<< client_file_descriptor
+			<< "\n";
+
+		HttpResponse http_response(HttpStatusCode::HTTP_408_REQUEST_TIMEOUT);
+		http_response.set_http_response_content_type("text/html");
+		http_response.set_http_response_body(HTTP_PAGE_408_REQUEST_TIMEOUT);
+
+		client_connection->close_after_response = true;
+
+		queue_http_response(client_file_descriptor, http_response);
+		flush_http_responses(client_file_descriptor);
+	}
+}
+
+/* Statuses without a dedicated page are sent with an empty body */
+static std::string_view get_http_request_error_page(const HttpStatusCode http_status_code) noexcept
+{
+	switch (http_status_code)
+	{
+	case HttpStatusCode::HTTP_400_BAD_REQUEST:			return HTTP_PAGE_400_BAD_REQUEST;
+	case HttpStatusCode::HTTP_413_PAYLOAD_TOO_LARGE:	return HTTP_PAGE_413_PAYLOAD_TOO_LARGE;
+	default:											return "";
+	}
 }
 
-void Server::handle_http_request_client(const size_t index)
+void Server::handle_http_request_client(const int client_file_descriptor)
 {
 	/* Ensure no stack issues */
 	char buffer[_MAX_REQUEST_READ_SIZE];
@@ -223,12 +540,20 @@ void Server::handle_http_request_client(const size_t index)
 	const size_t read_size	= server_configuration->get_request_read_size() > _MAX_REQUEST_READ_SIZE
 							? _MAX_REQUEST_READ_SIZE : server_configuration->get_request_read_size();
 
-	const int client_file_descriptor = poll_file_descriptors[index].fd;
-
-	HttpRequest& http_request = client_http_requests[client_file_descriptor];
+	ClientConnection&	client_connection	= client_connections.get(client_file_descriptor);
+	HttpRequest&		http_request		= client_connection.http_request;
 
 	ssize_t	bytes_read = read(client_file_descriptor, buffer, read_size);
 
+	/* The rest of a refused request is dropped, the timer armed by start_lingering_close() is not extended */
+	if (client_connection.is_lingering)
+	{
+		if (!bytes_read || (bytes_read < 0 && errno != EAGAIN && errno != EINTR))
+			close_client_connection(client_file_descriptor);
+
+		return;
+	}
+
 	if (bytes_read < 0)
 	{
 		std::cerr
@@ -236,129 +561,305 @@ void Server::handle_http_request_client(const size_t index)
 			<< client_file_descriptor
 			<< "\n";
 
-		close(client_file_descriptor);
-
-		poll_file_descriptors.erase(poll_file_descriptors.begin()
-			+ static_cast<std::vector<pollfd>::difference_type>(index));
-		client_http_requests.erase(client_file_descriptor);
-
+		close_client_connection(client_file_descriptor);
 		return;
 	}
 
-	bool is_http_request_complete = http_request.process_incoming_http_request(
-		std::string(buffer, static_cast<size_t>(bytes_read))
-	);
-
-	if (!is_http_request_complete)
+	if (!bytes_read)
 	{
-		if (!bytes_read)
+		/* Closing an idle persistent connection is the normal way for a client to leave */
+		if (http_request.has_http_request_data())
 			std::cerr
 				<< "INFO: Client disconnected before sending complete request. Client FD: "
 				<< client_file_descriptor
 				<< "\n";
-		else
-			std::cerr
-				<< "INFO: Invalid HTTP request from client. Client FD: "
-				<< client_file_descriptor
-				<< "\n";
 
-		close(client_file_descriptor);
-
-		poll_file_descriptors.erase(poll_file_descriptors.begin()
-			+ static_cast<std::vector<pollfd>::difference_type>(index));
-		client_http_requests.erase(client_file_descriptor);
+		close_client_connection(client_file_descriptor);
+		return;
 	}
 
-	if (is_http_request_complete && http_request.get_http_request_body() == "413 Payload Too Large")
+	std::string received_data(buffer, static_cast<size_t>(bytes_read));
+
+	/* One read may carry several pipelined requests, answer each of them in order */
+	while (!client_connection.close_after_response)
 	{
-		HttpResponse http_response;
-		http_response.set_http_response_status_code(HttpStatusCode::HTTP_413_PAYLOAD_TOO_LARGE);
-		http_response.set_http_response_content_type("text/html");
-		http_response.set_http_response_body(
-			"<html><body><h1>413 Payload Too Large</h1><p>File too large. Maximum size is 10MB.</p></body></html>"
-		);
+		bool is_http_request_complete = false;
 
-		send_http_response(client_file_descriptor, http_response);
-	
-		close(client_file_descriptor);
+		try
+		{
+			is_http_request_complete = http_request.process_incoming_http_request(received_data);
+		}
+		catch (const HttpRequestError& e)
+		{
+			std::cerr
+				<< "ERROR INFO: Rejected HTTP request: "
+				<< e.what()
+				<< "\n";
 
-		poll_file_descriptors.erase(poll_file_descriptors.begin()
-			+ static_cast<std::vector<pollfd>::difference_type>(index));
-		client_http_requests.erase(client_file_descriptor);
+			HttpResponse http_response(e.get_http_status_code());
+			http_response.set_http_response_content_type("text/html");
+			http_response.set_http_response_static_body(get_http_request_error_page(e.get_http_status_code()));
 
-		return;
-	}
+			/* The unread part of the body would be mistaken for the next request */
+			client_connection.close_after_response	= true;
+			client_connection.linger_after_response	= true;
 
-	if (http_request.has_http_request_header("Content-Length"))
-	{
-		const size_t expected_http_request_length = std::stoul(
-			http_request.get_http_request_header("Content-Length")
-		);
+			queue_http_response(client_file_descriptor, http_response);
+			break;
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr
+				<< "ERROR INFO: Malformed HTTP request: "
+				<< e.what()
+				<< "\n";
+
+			HttpResponse http_response(HttpStatusCode::HTTP_400_BAD_REQUEST);
+			http_response.set_http_response_content_type("text/html");
+			http_response.set_http_response_body(HTTP_PAGE_400_BAD_REQUEST);
 
-		if (is_http_request_complete && http_request.get_http_request_body().length() >= expected_http_request_length)
+			/* The rest of the stream cannot be trusted to start at a request boundary */
+			client_connection.close_after_response	= true;
+			client_connection.linger_after_response	= true;
+
+			queue_http_response(client_file_descriptor, http_response);
+			break;
+		}
+
+		/* Partial request, wait for the rest */
+		if (!is_http_request_complete)
 		{
-			determine_http_method_from_http_request(client_file_descriptor, http_request);
-			client_http_requests.erase(client_file_descriptor);
+			/* A client waiting for permission to send its body gets an answer now */
+			if (http_request.take_http_request_continue_expectation())
+				answer_http_request_expectation(client_file_descriptor, http_request);
+
+			break;
 		}
-		else
-			poll_file_descriptors[index].events = POLLIN;
-	}
-	else if (is_http_request_complete)
-	{
+
+		received_data = http_request.take_pipelined_http_request_data();
+
+		/* Resets the request for the next one unless the connection is closing */
 		determine_http_method_from_http_request(client_file_descriptor, http_request);
-		client_http_requests.erase(client_file_descriptor);
+
+		if (received_data.empty())
+			break;
 	}
+
+	flush_http_responses(client_file_descriptor);
 }
 
-void Server::send_http_response(
-	const int			client_file_descriptor,
-	const HttpResponse&	http_response)
+bool Server::should_keep_connection_alive(const ClientConnection& client_connection) const
 {
-	const std::string http_response_string = http_response.build_http_response();
+	return server_running
+		&& !is_draining
+		&& !client_connection.close_after_response
+		&& server_configuration->get_keepalive_timeout()
+		&& client_connection.served_request_count + 1 < server_configuration->get_keepalive_requests()
+		&& client_connection.http_request.is_keep_alive_requested();
+}
+
+void Server::queue_http_response(
+	const int		client_file_descriptor,
+	HttpResponse&	http_response)
+{
+	ClientConnection& client_connection = client_connections.get(client_file_descriptor);
+
+	const bool keep_connection_alive = should_keep_connection_alive(client_connection);
 
-	const ssize_t bytes_sent = send(
-		client_file_descriptor,
-		http_response_string.c_str(),
-		http_response_string.length(),
-		0
+	/* Connection and Keep-Alive come with Date and Server, serialized in advance */
+	http_response.append_http_response_segments(
+		client_connection.pending_http_response_segments,
+		http_response_default_headers.get_http_response_default_headers(keep_connection_alive)
 	);
 
-	if (bytes_sent <= 0)
+	/* Nothing after this response will be answered, pipelined or not */
+	if (!keep_connection_alive)
 	{
-		std::cerr
-			<< "ERROR INFO: Failed to send HTTP response to client."
-			<< "\n";
+		client_connection.close_after_response = true;
+		return;
+	}
 
-		close(client_file_descriptor);
-		client_http_requests.erase(client_file_descriptor);
+	client_connection.http_request.reset_http_request();
+
+	++client_connection.served_request_count;
+}
+
+void Server::flush_http_responses(const int client_file_descriptor)
+{
+	ClientConnection& client_connection = client_connections.get(client_file_descriptor);
 
-		for (size_t i = 0; i < poll_file_descriptors.size(); ++i)
+	std::vector<HttpResponseSegment>& pending_http_response_segments = client_connection.pending_http_response_segments;
+
+	while (client_connection.pending_segment_index < pending_http_response_segments.size())
+	{
+		const HttpResponseSegment& first_segment = pending_http_response_segments[client_connection.pending_segment_index];
+
+		ssize_t bytes_sent;
+
+		if (first_segment.is_file())
+		{
+			/*
+				The kernel copies the file to the socket, an explicit offset leaves the descriptor's own untouched.
+				There is no MSG_NOSIGNAL here, a reset client gives EPIPE because ServerMaster::run() ignores SIGPIPE.
+			*/
+			off_t file_offset = static_cast<off_t>(first_segment.get_file_offset() + client_connection.pending_segment_offset);
+
+			bytes_sent = sendfile(
+				client_file_descriptor,
+				first_segment.get_file_descriptor(),
+				&file_offset,
+				first_segment.get_length() - client_connection.pending_segment_offset
+			);
+
+			/* Content-Length is already on the wire, the connection cannot be saved */
+			if (!bytes_sent)
+			{
+				std::cerr
+					<< "ERROR INFO: File shrank while being sent to client\n";
+
+				close_client_connection(client_file_descriptor);
+				return;
+			}
+		}
+		else
 		{
-			if (poll_file_descriptors[i].fd == client_file_descriptor)
+			iovec	response_segments[IOV_MAX];
+			size_t	segment_count	= 0;
+			int		send_flags		= MSG_NOSIGNAL;	/* Same as writev(), without SIGPIPE even if the process stopped ignoring it */
+
+			/* Responses are queued in request order, one gathered send keeps that order on the wire */
+			for (size_t index = client_connection.pending_segment_index;
+				 index < pending_http_response_segments.size() && segment_count < IOV_MAX;
+				 ++index)
 			{
-				poll_file_descriptors.erase(poll_file_descriptors.begin()
-					+ static_cast<std::vector<pollfd>::difference_type>(i));
+				/* The head of a file response leaves in the same packet as the start of the file */
+				if (pending_http_response_segments[index].is_file())
+				{
+					send_flags |= MSG_MORE;
+					break;
+				}
+
+				const std::string_view segment_bytes = pending_http_response_segments[index].get_bytes();
+
+				/* sendmsg() only reads the buffers */
+				response_segments[segment_count].iov_base	= const_cast<char*>(segment_bytes.data());
+				response_segments[segment_count].iov_len	= segment_bytes.length();
+				++segment_count;
+			}
+
+			/* The first segment may already be partly sent */
+			response_segments[0].iov_base	= static_cast<char*>(response_segments[0].iov_base)
+											+ client_connection.pending_segment_offset;
+			response_segments[0].iov_len	-= client_connection.pending_segment_offset;
+
+			msghdr response_message = {};
+
+			response_message.msg_iov	= response_segments;
+			response_message.msg_iovlen	= segment_count;
 
+			bytes_sent = sendmsg(client_file_descriptor, &response_message, send_flags);
+		}
+
+		if (bytes_sent < 0)
+		{
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+				break;
+
+			std::cerr
+				<< "ERROR INFO: Failed to send HTTP response to client: "
+				<< strerror(errno)
+				<< "\n";
+
+			close_client_connection(client_file_descriptor);
+			return;
+		}
+
+		size_t remaining_bytes = static_cast<size_t>(bytes_sent);
+
+		while (remaining_bytes)
+		{
+			const size_t unsent_segment_bytes
+				= pending_http_response_segments[client_connection.pending_segment_index].get_length()
+				- client_connection.pending_segment_offset;
+
+			if (remaining_bytes < unsent_segment_bytes)
+			{
+				client_connection.pending_segment_offset += remaining_bytes;
 				break;
 			}
+
+			remaining_bytes -= unsent_segment_bytes;
+
+			client_connection.pending_segment_offset = 0;
+			++client_connection.pending_segment_index;
+		}
+
+		/* A short write means the socket buffer is full, wait for POLLOUT instead of retrying */
+		if (client_connection.pending_segment_offset)
+			break;
+	}
+
+	if (client_connection.pending_segment_index < pending_http_response_segments.size())
+	{
+		/* Stop reading until the client drains its responses, so the queue cannot grow unbounded */
+		if (!client_connection.is_waiting_for_writable)
+		{
+			event_loop->modify_file_descriptor(client_file_descriptor, POLLOUT);
+			client_connection.is_waiting_for_writable = true;
 		}
 
+		/* Restarted on every write that made progress */
+		arm_connection_timer(client_connection);
 		return;
 	}
 
-	close(client_file_descriptor);
-	client_http_requests.erase(client_file_descriptor);
+	pending_http_response_segments.clear();
+	client_connection.pending_segment_index = 0;
 
-	for (size_t i = 0; i < poll_file_descriptors.size(); ++i)
+	if (client_connection.close_after_response)
 	{
-		if (poll_file_descriptors[i].fd == client_file_descriptor)
-		{
-			poll_file_descriptors.erase(poll_file_descriptors.begin()
-				+ static_cast<std::vector<pollfd>::difference_type>(i));
+		if (client_connection.linger_after_response)
+			start_lingering_close(client_connection);
+		else
+			close_client_connection(client_file_descriptor);
 
-			break;
-		}
+		return;
+	}
+
+	/* Kept alive by a response queued before the drain started */
+	if (is_draining && is_client_connection_idle(client_connection))
+	{
+		close_client_connection(client_file_descriptor);
+		return;
+	}
+
+	if (client_connection.is_waiting_for_writable)
+	{
+		event_loop->modify_file_descriptor(client_file_descriptor, POLLIN);
+		client_connection.is_waiting_for_writable = false;
+	}
+
+	/* Every read and every completed flush ends here, so the deadline always matches the state */
+	arm_connection_timer(client_connection);
+}
+
+void Server::start_lingering_close(ClientConnection& client_connection)
+{
+	if (shutdown(client_connection.file_descriptor, SHUT_WR) < 0)
+	{
+		close_client_connection(client_connection.file_descriptor);
+		return;
+	}
+
+	client_connection.is_lingering = true;
+
+	if (client_connection.is_waiting_for_writable)
+	{
+		event_loop->modify_file_descriptor(client_connection.file_descriptor, POLLIN);
+		client_connection.is_waiting_for_writable = false;
 	}
+
+	arm_connection_timer(client_connection);
 }
 
 int Server::get_server_listening_port_for_socket(const int socket_file_descriptor) const
@@ -382,6 +883,32 @@ int Server::get_server_listening_port_for_socket(const int socket_file_descripto
 	return ntohs(socket_address.sin_port);
 }
 
+void Server::answer_http_request_expectation(
+	const int			client_file_descriptor,
+	const HttpRequest&	http_request)
+{
+	ClientConnection& client_connection = client_connections.get(client_file_descriptor);
+
+	HttpResponse http_response;
+
+	const RequestManager request_manager(server_configuration, static_file_cache);
+
+	if (request_manager.accept_http_request_body(
+			http_request, http_response,
+			get_server_listening_port_for_socket(client_file_descriptor)))
+	{
+		/* Interim response, the request stays in place for its body */
+		client_connection.pending_http_response_segments.emplace_back(std::string_view(_HTTP_100_CONTINUE_RESPONSE));
+		return;
+	}
+
+	/* The client may send the body anyway, it is discarded rather than parsed */
+	client_connection.close_after_response	= true;
+	client_connection.linger_after_response	= true;
+
+	queue_http_response(client_file_descriptor, http_response);
+}
+
 void Server::determine_http_method_from_http_request(
 	const int			client_file_descriptor,
 	const HttpRequest&	http_request)
@@ -396,12 +923,12 @@ void Server::determine_http_method_from_http_request(
 		std::cerr << "ERROR INFO: Configuration is null!\n";
 
 		http_response.set_http_response_status_code(HttpStatusCode::HTTP_500_INTERNAL_SERVER_ERROR);
-		send_http_response(client_file_descriptor, http_response);
+		queue_http_response(client_file_descriptor, http_response);
 
 		return;
 	}
 
-	const RequestManager request_manager(server_configuration);
+	const RequestManager request_manager(server_configuration, static_file_cache);
 
 	try
 	{
@@ -409,7 +936,7 @@ void Server::determine_http_method_from_http_request(
 		{
 		case HttpMethod::GET:
 			request_manager.handle_http_get_request(
-				http_request.get_http_request_url(),
+				http_request.get_http_request_path(),
 				http_request, http_response,
 				server_listening_port
 			);
@@ -417,7 +944,7 @@ void Server::determine_http_method_from_http_request(
 
 		case HttpMethod::POST:
 			request_manager.handle_http_post_request(
-				http_request.get_http_request_url(),
+				http_request.get_http_request_path(),
 				http_request, http_response,
 				server_listening_port
 			);
@@ -425,7 +952,7 @@ void Server::determine_http_method_from_http_request(
 
 		case HttpMethod::DELETE:
 			request_manager.handle_http_delete_request(
-				http_request.get_http_request_url(),
+				http_request.get_http_request_path(),
 				http_response,
 				server_listening_port
 			);
@@ -449,89 +976,129 @@ void Server::determine_http_method_from_http_request(
 		);
 	}
 
-	send_http_response(client_file_descriptor, http_response);
+	queue_http_response(client_file_descriptor, http_response);
 }
 
-void Server::setup_poll_file_descriptors()
+void Server::setup_event_loop()
 {
-	if (!poll_file_descriptors.size())
-		poll_file_descriptors.clear();
+	event_loop = EventLoop::create(server_configuration->get_event_loop_backend());
 
 	for (const int server_file_descriptor : server_file_descriptors)
-	{
-		pollfd server_poll_file_descriptor	= {};
+		event_loop->add_file_descriptor(server_file_descriptor, POLLIN);
 
-		server_poll_file_descriptor.fd		= server_file_descriptor;
-		server_poll_file_descriptor.events	= POLLIN;
+	event_loop->add_file_descriptor(wakeup_file_descriptor, POLLIN);
 
-		poll_file_descriptors.push_back(server_poll_file_descriptor);
-	}
+	if (static_file_cache.get_inotify_file_descriptor() >= 0)
+		event_loop->add_file_descriptor(static_file_cache.get_inotify_file_descriptor(), POLLIN);
 }
 
-void Server::handle_poll_events()
+void Server::handle_ready_events()
 {
-	for (size_t i = 0; i < poll_file_descriptors.size(); ++i)
+	for (const EventLoopEvent& ready_event : ready_events)
 	{
-		if (!poll_file_descriptors[i].revents)
-			continue;
-
-		if (poll_file_descriptors[i].revents & (POLLERR | POLLHUP | POLLNVAL))
+		/* Only interrupts the wait, the requests themselves are atomics checked by the loop */
+		if (ready_event.fd == wakeup_file_descriptor)
 		{
-			close(poll_file_descriptors[i].fd);
+			uint64_t wakeup_count;
 
-			poll_file_descriptors.erase(
-				poll_file_descriptors.begin() +
-				static_cast<std::vector<pollfd>::difference_type>(i)
-			);
+			[[maybe_unused]] const ssize_t bytes_read = read(wakeup_file_descriptor, &wakeup_count, sizeof(wakeup_count));
+			continue;
+		}
 
+		/* Served files changed on disk */
+		if (ready_event.fd == static_file_cache.get_inotify_file_descriptor())
+		{
+			static_file_cache.handle_file_events();
 			continue;
 		}
 
 		if (std::find(
 				server_file_descriptors.begin(),
 				server_file_descriptors.end(),
-				poll_file_descriptors[i].fd
+				ready_event.fd
 			) != server_file_descriptors.end())
 		{
-			if (poll_file_descriptors[i].revents & POLLIN)
-				handle_incoming_client_connection(poll_file_descriptors[i].fd);
+			if (ready_event.events & POLLIN)
+				handle_incoming_client_connection(ready_event.fd);
 
 			continue;
 		}
 
+		/* An earlier event in this batch may have closed the connection */
+		if (!client_connections.contains(ready_event.fd))
+			continue;
+
+		if (ready_event.events & (POLLERR | POLLHUP | POLLNVAL))
+		{
+			close_client_connection(ready_event.fd);
+			continue;
+		}
+
 		/* Double if instead of else if for concurrency */
 
-		if (poll_file_descriptors[i].revents & POLLOUT)
-			handle_client_write(i);
+		if (ready_event.events & POLLOUT)
+			handle_client_write(ready_event.fd);
 
-		if (poll_file_descriptors[i].revents & POLLIN)
-			handle_http_request_client(i);
+		if ((ready_event.events & POLLIN) && client_connections.contains(ready_event.fd))
+			handle_http_request_client(ready_event.fd);
 	}
 }
 
 void Server::start_server()
 {
-	setup_poll_file_descriptors();
+	setup_event_loop();
 
-	std::cout << "Server successfully initialized.\n";
-	std::cout << server_configuration->get_server_configuration_string() << "\n";
-	std::cout << "Ready.\n\n";
+	/* Only the first worker prints the shared configuration */
+	if (!server_worker_index)
+	{
+		std::cout << "Server successfully initialized.\n";
+		std::cout << server_configuration->get_server_configuration_string() << "\n";
+	}
 
-	set_server_running(true);
+	std::cout
+		<< "Worker " << server_worker_index
+		<< " ready, event loop backend in use: "
+		<< event_loop->get_backend_name()
+		<< "\n";
 
 	while (server_running)
 	{
-		const int poll_result = poll(
-			poll_file_descriptors.data(),
-			poll_file_descriptors.size(),
-			-1
-		);
+		if (graceful_shutdown_requested && !is_draining)
+			begin_graceful_shutdown();
 
-		if (poll_result < 0)
-			throw std::runtime_error(
-				"Poll syscall failed."
-			);
+		/* Blocks until the next timer is due at the latest, forever without timers */
+		int wait_timeout_milliseconds = connection_timers.get_wait_timeout_milliseconds();
 
-		handle_poll_events();
+		if (is_draining)
+		{
+			const auto remaining_drain_milliseconds = std::chrono::ceil<std::chrono::milliseconds>(
+				drain_deadline - TimerWheel::Clock::now()
+			).count();
+
+			if (client_connections.empty() || remaining_drain_milliseconds <= 0)
+				break;
+
+			if (wait_timeout_milliseconds < 0 || wait_timeout_milliseconds > remaining_drain_milliseconds)
+				wait_timeout_milliseconds = static_cast<int>(remaining_drain_milliseconds);
+		}
+
+		event_loop->wait_for_events(ready_events, wait_timeout_milliseconds);
+
+		/* Every response answered in this iteration shares the Date */
+		http_response_default_headers.refresh();
+
+		handle_ready_events();
+		handle_expired_connection_timers();
 	}
+
+	if (is_draining && !client_connections.empty())
+		std::cerr
+			<< "INFO: Worker " << server_worker_index
+			<< " shutdown timeout reached, closing "
+			<< client_connections.size()
+			<< " connections\n";
+
+	close_all_client_connections();
+
+	set_server_running(false);
 }
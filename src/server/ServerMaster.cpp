@@ -0,0 +1,461 @@
+#include <poll.h>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sstream>
+#include <unistd.h>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <sys/wait.h>
+#include <sys/socket.h>
+
+#include "server/ServerMaster.hpp"
+
+#include "utils/utils.hpp"
+
+/* A failing worker only reports it, exiting here would drop the connections of every other worker */
+static void run_server_worker(Server& server, WorkerGeneration& worker_generation)
+{
+	try
+	{
+		server.start_server();
+	}
+
+	catch (const std::exception& e)
+	{
+		std::cerr	<< "ERROR INFO: Worker failed: "
+					<< e.what()
+					<< "\n";
+
+		worker_generation.has_failed_worker = true;
+	}
+
+	--worker_generation.running_worker_count;
+}
+
+/* The counters are only read once their worker thread was joined */
+static void join_worker_generation(WorkerGeneration& worker_generation)
+{
+	AcceptCounters generation_accept_counters;
+
+	for (std::thread& worker_thread : worker_generation.worker_threads)
+		if (worker_thread.joinable())
+			worker_thread.join();
+
+	for (const auto& server : worker_generation.servers)
+	{
+		const AcceptCounters& accept_counters = server->get_accept_counters();
+
+		generation_accept_counters.accepted_connections				+= accept_counters.accepted_connections;
+		generation_accept_counters.accept_limit_hits				+= accept_counters.accept_limit_hits;
+		generation_accept_counters.full_listen_queue_observations	+= accept_counters.full_listen_queue_observations;
+		generation_accept_counters.descriptor_exhaustion_drops		+= accept_counters.descriptor_exhaustion_drops;
+	}
+
+	std::cout
+		<< "INFO: Workers stopped after accepting "
+		<< generation_accept_counters.accepted_connections
+		<< " connections, accept limit reached "
+		<< generation_accept_counters.accept_limit_hits
+		<< " times, accept queue full "
+		<< generation_accept_counters.full_listen_queue_observations
+		<< " times, "
+		<< generation_accept_counters.descriptor_exhaustion_drops
+		<< " connections dropped for lack of descriptors\n";
+}
+
+static void close_file_descriptors(const std::vector<int>& file_descriptors)
+{
+	for (const int file_descriptor : file_descriptors)
+		close(file_descriptor);
+}
+
+ServerMaster::ServerMaster(std::string configuration_path, std::string program_path)
+	:	configuration_file_path(std::move(configuration_path)),
+		executable_path(std::move(program_path)),
+		is_shutting_down(false),
+		has_failed_worker(false)
+{
+}
+
+ServerMaster::~ServerMaster()
+{
+	for (const auto& worker_generation : worker_generations)
+	{
+		for (const auto& server : worker_generation->servers)
+			server->request_stop();
+
+		join_worker_generation(*worker_generation);
+	}
+}
+
+std::vector<int> ServerMaster::take_environment_file_descriptors(const char* environment_variable)
+{
+	std::vector<int> file_descriptors;
+
+	const char* environment_value = getenv(environment_variable);
+
+	if (!environment_value)
+		return file_descriptors;
+
+	std::istringstream	value_stream(environment_value);
+	std::string			file_descriptor_string;
+
+	while (std::getline(value_stream, file_descriptor_string, ','))
+	{
+		char*		end = nullptr;
+		const long	file_descriptor = strtol(file_descriptor_string.c_str(), &end, 10);
+
+		if (file_descriptor_string.empty() || *end || file_descriptor < 0 || file_descriptor > INT_MAX ||
+			fcntl(static_cast<int>(file_descriptor), F_SETFD, FD_CLOEXEC) < 0)
+		{
+			std::cerr
+				<< "ERROR INFO: Ignoring invalid inherited descriptor \""
+				<< file_descriptor_string
+				<< "\" in "
+				<< environment_variable
+				<< "\n";
+
+			continue;
+		}
+
+		file_descriptors.push_back(static_cast<int>(file_descriptor));
+	}
+
+	unsetenv(environment_variable);
+
+	return file_descriptors;
+}
+
+std::unique_ptr<WorkerGeneration> ServerMaster::start_worker_generation(
+	std::vector<int>& inherited_server_file_descriptors) const
+{
+	auto worker_generation = std::make_unique<WorkerGeneration>();
+
+	worker_generation->parser = std::make_unique<Parse>(configuration_file_path);
+	worker_generation->parser->parse_server_configuration_file();
+
+	const ServerConfiguration* server_configuration	= worker_generation->parser->get_server_configuration();
+	const size_t worker_thread_count				= server_configuration->get_worker_thread_count();
+
+	for (size_t worker_index = 0; worker_index < worker_thread_count; ++worker_index)
+	{
+		worker_generation->servers.push_back(std::make_unique<Server>(server_configuration, worker_index));
+
+		/* The last worker also takes the surplus sockets of a generation that had more workers */
+		worker_generation->servers.back()->setup_server(
+			inherited_server_file_descriptors,
+			worker_index + 1 == worker_thread_count
+		);
+	}
+
+	worker_generation->running_worker_count = worker_generation->servers.size();
+
+	for (const auto& server : worker_generation->servers)
+		worker_generation->worker_threads.emplace_back(
+			run_server_worker,
+			std::ref(*server),
+			std::ref(*worker_generation)
+		);
+
+	return worker_generation;
+}
+
+std::vector<int> ServerMaster::get_current_server_file_descriptors() const
+{
+	std::vector<int> server_file_descriptors;
+
+	if (is_shutting_down || worker_generations.empty())
+		return server_file_descriptors;
+
+	for (const auto& server : worker_generations.back()->servers)
+		server_file_descriptors.insert(
+			server_file_descriptors.end(),
+			server->get_server_file_descriptors().begin(),
+			server->get_server_file_descriptors().end()
+		);
+
+	return server_file_descriptors;
+}
+
+void ServerMaster::reap_finished_generations()
+{
+	std::erase_if(worker_generations, [](const std::unique_ptr<WorkerGeneration>& worker_generation)
+	{
+		if (worker_generation->running_worker_count)
+			return false;
+
+		join_worker_generation(*worker_generation);
+
+		return true;
+	});
+}
+
+void ServerMaster::reload_configuration()
+{
+	std::cout << "INFO: Reloading configuration from " << configuration_file_path << "\n";
+
+	std::vector<int> inherited_server_file_descriptors;
+
+	for (const int server_file_descriptor : get_current_server_file_descriptors())
+	{
+		const int duplicate_file_descriptor = fcntl(server_file_descriptor, F_DUPFD_CLOEXEC, 0);
+
+		if (duplicate_file_descriptor >= 0)
+			inherited_server_file_descriptors.push_back(duplicate_file_descriptor);
+	}
+
+	std::unique_ptr<WorkerGeneration> worker_generation;
+
+	try
+	{
+		worker_generation = start_worker_generation(inherited_server_file_descriptors);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr
+			<< "ERROR INFO: Reload failed, keeping the current configuration: "
+			<< e.what()
+			<< "\n";
+
+		close_file_descriptors(inherited_server_file_descriptors);
+		return;
+	}
+
+	/* Ports no longer configured, the old workers close their own copies while draining */
+	close_file_descriptors(inherited_server_file_descriptors);
+
+	for (const auto& server : worker_generations.back()->servers)
+		server->request_graceful_shutdown();
+
+	worker_generations.push_back(std::move(worker_generation));
+
+	std::cout << "INFO: Configuration reloaded, the previous workers are draining\n";
+}
+
+bool ServerMaster::upgrade_executable()
+{
+	const std::vector<int> server_file_descriptors = get_current_server_file_descriptors();
+
+	std::cout << "INFO: Upgrading to " << executable_path << "\n";
+
+	int ready_pipe[2];
+
+	if (pipe2(ready_pipe, O_CLOEXEC) < 0)
+	{
+		std::cerr << "ERROR INFO: Upgrade failed, cannot create the ready pipe: " << strerror(errno) << "\n";
+		return false;
+	}
+
+	/* Everything that allocates is prepared before fork(), like for CGI scripts */
+	std::string listen_file_descriptors;
+
+	for (const int server_file_descriptor : server_file_descriptors)
+	{
+		if (!listen_file_descriptors.empty())
+			listen_file_descriptors += ',';
+
+		listen_file_descriptors += std::to_string(server_file_descriptor);
+	}
+
+	std::vector<std::string>	environment_strings;
+	std::vector<char*>			environment_pointers;
+
+	for (char** inherited = environ; *inherited; ++inherited)
+		if (strncmp(*inherited, _LISTEN_FDS_ENVIRONMENT_VARIABLE "=", sizeof(_LISTEN_FDS_ENVIRONMENT_VARIABLE)) &&
+			strncmp(*inherited, _READY_FD_ENVIRONMENT_VARIABLE "=", sizeof(_READY_FD_ENVIRONMENT_VARIABLE)))
+			environment_strings.emplace_back(*inherited);
+
+	environment_strings.push_back(_LISTEN_FDS_ENVIRONMENT_VARIABLE "=" + listen_file_descriptors);
+	environment_strings.push_back(_READY_FD_ENVIRONMENT_VARIABLE "=" + std::to_string(ready_pipe[1]));
+
+	for (std::string& environment_string : environment_strings)
+		environment_pointers.push_back(environment_string.data());
+
+	environment_pointers.push_back(nullptr);
+
+	char* const argument_pointers[] = {
+		const_cast<char*>(executable_path.c_str()),
+		const_cast<char*>(configuration_file_path.c_str()),
+		nullptr
+	};
+
+	const pid_t pid = fork();
+
+	if (pid < 0)
+	{
+		std::cerr << "ERROR INFO: Upgrade failed, fork failed: " << strerror(errno) << "\n";
+
+		close(ready_pipe[0]);
+		close(ready_pipe[1]);
+		return false;
+	}
+
+	if (!pid)
+	{
+		for (const int server_file_descriptor : server_file_descriptors)
+			fcntl(server_file_descriptor, F_SETFD, 0);
+
+		fcntl(ready_pipe[1], F_SETFD, 0);
+
+		execve(executable_path.c_str(), argument_pointers, environment_pointers.data());
+
+		_exit(127);
+	}
+
+	close(ready_pipe[1]);
+
+	pollfd	ready_poll		= {ready_pipe[0], POLLIN, 0};
+	char	ready_byte		= 0;
+	int		poll_result;
+
+	while ((poll_result = poll(&ready_poll, 1, _UPGRADE_READY_TIMEOUT_MILLISECONDS)) < 0 && errno == EINTR)
+		;
+
+	/* End of file without a byte means the new binary exited */
+	const bool is_new_binary_ready = poll_result > 0 && read(ready_pipe[0], &ready_byte, 1) == 1;
+
+	close(ready_pipe[0]);
+
+	if (!is_new_binary_ready)
+	{
+		std::cerr
+			<< "ERROR INFO: Upgrade failed, the new binary (PID "
+			<< pid
+			<< ") did not start serving, keeping this one\n";
+
+		kill(pid, SIGKILL);
+		waitpid(pid, nullptr, 0);
+		return false;
+	}
+
+	std::cout
+		<< "INFO: New binary (PID "
+		<< pid
+		<< ") is serving, draining this process\n";
+
+	return true;
+}
+
+void ServerMaster::handle_failed_workers()
+{
+	for (const auto& worker_generation : worker_generations)
+	{
+		if (!worker_generation->has_failed_worker.exchange(false))
+			continue;
+
+		/* Only the current generation serves new connections, an old one is draining anyway */
+		if (is_shutting_down || worker_generation != worker_generations.back())
+			continue;
+
+		std::cerr << "ERROR INFO: The current workers are incomplete, draining them before stopping\n";
+
+		has_failed_worker = true;
+
+		shutdown_generations(true);
+		return;
+	}
+}
+
+void ServerMaster::shutdown_generations(const bool graceful)
+{
+	is_shutting_down = true;
+
+	for (const auto& worker_generation : worker_generations)
+		for (const auto& server : worker_generation->servers)
+		{
+			if (graceful)
+				server->request_graceful_shutdown();
+			else
+				server->request_stop();
+		}
+	/* Workers return within one loop iteration, no need to wait for the next reap */
+	if (graceful)
+		return;
+
+	for (const auto& worker_generation : worker_generations)
+		join_worker_generation(*worker_generation);
+
+	worker_generations.clear();
+}
+
+void ServerMaster::run()
+{
+	Utils::block_server_signals();
+
+	/* sendfile() has no MSG_NOSIGNAL, a client resetting the connection mid-file must not kill the process */
+	if (signal(SIGPIPE, SIG_IGN) == SIG_ERR)
+		throw std::runtime_error("Failed to ignore SIGPIPE: " + std::string(strerror(errno)));
+
+	std::vector<int> inherited_server_file_descriptors
+		= take_environment_file_descriptors(_LISTEN_FDS_ENVIRONMENT_VARIABLE);
+
+	const std::vector<int> ready_file_descriptors
+		= take_environment_file_descriptors(_READY_FD_ENVIRONMENT_VARIABLE);
+
+	if (!inherited_server_file_descriptors.empty())
+		std::cout
+			<< "INFO: Inherited "
+			<< inherited_server_file_descriptors.size()
+			<< " listening sockets from the previous binary\n";
+
+	worker_generations.push_back(start_worker_generation(inherited_server_file_descriptors));
+
+	/* Ports the new configuration no longer listens on */
+	close_file_descriptors(inherited_server_file_descriptors);
+
+	/* The previous binary starts draining as soon as it reads this */
+	for (const int ready_file_descriptor : ready_file_descriptors)
+	{
+		[[maybe_unused]] const ssize_t bytes_written = write(ready_file_descriptor, "1", 1);
+		close(ready_file_descriptor);
+	}
+
+	while (true)
+	{
+		handle_failed_workers();
+		reap_finished_generations();
+
+		if (worker_generations.empty())
+			break;
+
+		const int signal_number = Utils::wait_for_server_signal(_SIGNAL_WAIT_MILLISECONDS);
+
+		if (!signal_number)
+			continue;
+
+		std::cout << "\nSignal (" << signal_number << ") received.\n";
+
+		switch (signal_number)
+		{
+			case SIGINT:
+			case SIGTERM:
+				shutdown_generations(false);
+				break;
+
+			case SIGQUIT:
+				shutdown_generations(true);
+				break;
+
+			case SIGHUP:
+				if (!is_shutting_down)
+					reload_configuration();
+				break;
+
+			case SIGUSR2:
+				if (!is_shutting_down && upgrade_executable())
+					shutdown_generations(true);
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	if (has_failed_worker)
+		throw std::runtime_error("A worker failed, the server stopped after draining the others");
+}
@@ -0,0 +1,410 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <iostream>
+#include <iterator>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#include "server/StaticFileCache.hpp"
+
+/* Anything that can change what a path resolves to, or the bytes of a file already open */
+#define _STATIC_FILE_CACHE_WATCH_MASK	(IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_DELETE_SELF \
+										| IN_MODIFY | IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+
+static std::string get_static_file_content_type(const std::string_view file_path)
+{
+	static const
+	std::unordered_map<std::string_view, std::string_view>
+	mime_types =
+	{
+		{"txt",		"txt"				},
+		{"html",	"text/html"			},
+		{"htm",		"text/html"			},
+		{"css",		"text/css"			},
+		{"jpg",		"image/jpeg"		},
+		{"jpeg",	"image/jpeg"		},
+		{"gif",		"image/gif"			},
+		{"pdf",		"application/pdf"	}
+	};
+
+	const size_t dot_position = file_path.find_last_of('.');
+
+	if (dot_position == std::string_view::npos)
+		return "application/octet-stream";
+
+	const auto it = mime_types.find(file_path.substr(dot_position + 1));
+
+	if (it != mime_types.end())
+		return std::string(it->second);
+
+	return "application/octet-stream";
+}
+
+/* The directory whose inotify watch reports changes to the key */
+static std::string_view get_parent_directory(const std::string_view key) noexcept
+{
+	const size_t slash_position = key.rfind('/');
+
+	if (slash_position == std::string_view::npos)
+		return ".";
+
+	return slash_position ? key.substr(0, slash_position) : "/";
+}
+
+StaticFileCache::StaticFileCache()
+	:	inotify_file_descriptor(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+	if (inotify_file_descriptor < 0)
+		std::cerr
+			<< "ERROR INFO: inotify unavailable, cached files are only checked again once they expire: "
+			<< strerror(errno)
+			<< "\n";
+}
+
+StaticFileCache::~StaticFileCache()
+{
+	if (inotify_file_descriptor >= 0)
+		close(inotify_file_descriptor);
+}
+
+void StaticFileCache::make_lookup_key(std::string_view path)
+{
+	while (path.starts_with("./"))
+		path.remove_prefix(2);
+
+	lookup_key.clear();
+
+	for (const char character : path)
+		if (character != '/' || lookup_key.empty() || lookup_key.back() != '/')
+			lookup_key.push_back(character);
+
+	if (lookup_key.length() > 1 && lookup_key.back() == '/')
+		lookup_key.pop_back();
+}
+
+const StaticFileEntry& StaticFileCache::lookup(const std::string_view path, const size_t content_max_size)
+{
+	make_lookup_key(path);
+
+	const auto now		= TimerWheel::Clock::now();
+	const auto indexed	= entry_index.find(lookup_key);
+
+	if (indexed != entry_index.end())
+	{
+		if (now < indexed->second->expiry_time)
+		{
+			entries.splice(entries.begin(), entries, indexed->second);
+
+			StaticFileEntry& entry = entries.front();
+
+			if (content_max_size && !entry.response_content && entry.file && entry.size <= content_max_size)
+				load_entry_content(entry);
+
+			return entry;
+		}
+
+		erase_entry(indexed->second);
+	}
+
+	StaticFileEntry entry;
+
+	entry.path			= lookup_key;
+	entry.expiry_time	= now + std::chrono::seconds(_STATIC_FILE_CACHE_VALID_SECONDS);
+
+	load_entry(entry);
+
+	if (entry.type == StaticFileType::MISSING)
+	{
+		missing_entry = std::move(entry);
+		return missing_entry;
+	}
+
+	if (entries.size() >= _STATIC_FILE_CACHE_MAX_ENTRIES)
+		erase_entry(std::prev(entries.end()));
+
+	entries.push_front(std::move(entry));
+	entry_index.emplace(entries.front().path, entries.begin());
+
+	watch_entry(entries.front());
+
+	if (content_max_size && entries.front().file && entries.front().size <= content_max_size)
+		load_entry_content(entries.front());
+
+	return entries.front();
+}
+
+void StaticFileCache::load_entry_content(StaticFileEntry& entry)
+{
+	const std::string response_head = "Content-Type: " + entry.content_type
+									+ "\r\nContent-Length: " + std::to_string(entry.size)
+									+ "\r\n\r\n";
+
+	const size_t required_size = response_head.length() + entry.size;
+
+	if (required_size > content_cache_size)
+		return;
+
+	/* Least recently used first, the entry being loaded is the most recent one */
+	for (auto victim = entries.rbegin(); content_size + required_size > content_cache_size && &*victim != &entry; ++victim)
+		release_entry_content(*victim);
+
+	std::string response_content;
+
+	response_content.reserve(required_size);
+	response_content.append(response_head);
+	response_content.resize(required_size);
+
+	const int file_descriptor = entry.file->get_file_descriptor();
+
+	/* pread() leaves the descriptor's offset alone, like sendfile() with an explicit offset */
+	for (size_t offset = 0; offset < entry.size;)
+	{
+		const ssize_t bytes_read = pread(
+			file_descriptor,
+			response_content.data() + response_head.length() + offset,
+			entry.size - offset,
+			static_cast<off_t>(offset)
+		);
+
+		if (bytes_read < 0 && errno == EINTR)
+			continue;
+
+		/* Changed under us, inotify is about to drop the entry anyway */
+		if (bytes_read <= 0)
+			return;
+
+		offset += static_cast<size_t>(bytes_read);
+	}
+
+	entry.response_content	= std::make_shared<const std::string>(std::move(response_content));
+	content_size			+= required_size;
+}
+
+void StaticFileCache::release_entry_content(StaticFileEntry& entry) noexcept
+{
+	if (!entry.response_content)
+		return;
+
+	content_size -= entry.response_content->length();
+	entry.response_content.reset();
+}
+
+void StaticFileCache::load_entry(StaticFileEntry& entry)
+{
+	int file_descriptor = open(entry.path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+	/* The cached descriptors are the ones that can be given back */
+	if (file_descriptor < 0 && (errno == EMFILE || errno == ENFILE) && !entries.empty())
+	{
+		clear();
+		file_descriptor = open(entry.path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	}
+
+	struct stat file_status = {};
+
+	if (file_descriptor < 0)
+	{
+		if (errno == ENOENT || errno == ENOTDIR)
+			return;
+
+		/* Not readable, but it may still be a directory to resolve an index in, or a file to refuse */
+		if (stat(entry.path.c_str(), &file_status))
+			return;
+	}
+	else if (fstat(file_descriptor, &file_status))
+	{
+		close(file_descriptor);
+		return;
+	}
+
+	entry.size				= static_cast<size_t>(file_status.st_size);
+	entry.modification_time	= file_status.st_mtime;
+
+	if (S_ISREG(file_status.st_mode))
+	{
+		entry.type			= StaticFileType::REGULAR;
+		entry.content_type	= get_static_file_content_type(entry.path);
+
+		if (file_descriptor >= 0)
+			entry.file = std::make_shared<const HttpResponseFile>(file_descriptor);
+
+		return;
+	}
+
+	entry.type = S_ISDIR(file_status.st_mode) ? StaticFileType::DIRECTORY : StaticFileType::OTHER;
+
+	if (file_descriptor >= 0)
+		close(file_descriptor);
+}
+
+void StaticFileCache::watch_entry(StaticFileEntry& entry)
+{
+	if (inotify_file_descriptor < 0)
+		return;
+
+	const std::string watched_path(
+		entry.type == StaticFileType::DIRECTORY ? std::string_view(entry.path) : get_parent_directory(entry.path)
+	);
+
+	const int watch_descriptor = inotify_add_watch(inotify_file_descriptor, watched_path.c_str(), _STATIC_FILE_CACHE_WATCH_MASK);
+
+	/* Out of watches, the entry still expires */
+	if (watch_descriptor < 0)
+		return;
+
+	WatchedDirectory& watched_directory = watched_directories[watch_descriptor];
+
+	/* The same directory reached through another path keeps the name it was first watched under */
+	if (!watched_directory.entry_count)
+		watched_directory.path = watched_path;
+
+	++watched_directory.entry_count;
+
+	entry.watch_descriptor = watch_descriptor;
+}
+
+void StaticFileCache::erase_entry(const std::list<StaticFileEntry>::iterator entry)
+{
+	const auto watched_directory = watched_directories.find(entry->watch_descriptor);
+
+	if (watched_directory != watched_directories.end() && !--watched_directory->second.entry_count)
+	{
+		inotify_rm_watch(inotify_file_descriptor, entry->watch_descriptor);
+		watched_directories.erase(watched_directory);
+	}
+
+	release_entry_content(*entry);
+
+	entry_index.erase(entry->path);
+	entries.erase(entry);
+}
+
+void StaticFileCache::erase_entry(const std::string_view key)
+{
+	const auto indexed = entry_index.find(key);
+
+	if (indexed != entry_index.end())
+		erase_entry(indexed->second);
+}
+
+void StaticFileCache::clear()
+{
+	for (const auto& [watch_descriptor, watched_directory] : watched_directories)
+		inotify_rm_watch(inotify_file_descriptor, watch_descriptor);
+
+	watched_directories.clear();
+	entry_index.clear();
+	entries.clear();
+
+	content_size = 0;
+}
+
+std::string StaticFileCache::resolve_directory_index(const std::string_view directory_path, const std::string& index_file_name)
+{
+	const StaticFileEntry& directory = lookup(directory_path);
+
+	if (directory.type != StaticFileType::DIRECTORY)
+		return "";
+
+	if (directory.is_index_resolved && directory.index_file_name == index_file_name)
+		return directory.index_path;
+
+	const std::string directory_key = directory.path;
+
+	std::string index_path;
+
+	/* Looking the candidates up caches them too, the index is the next thing served */
+	if (!index_file_name.empty() && lookup(directory_key + "/" + index_file_name).type != StaticFileType::MISSING)
+		index_path = directory_key + "/" + index_file_name;
+
+	else if (lookup(directory_key + "/index.html").type != StaticFileType::MISSING)
+		index_path = directory_key + "/index.html";
+
+	/* The lookups above may have evicted the directory */
+	const auto indexed = entry_index.find(directory_key);
+
+	if (indexed != entry_index.end())
+	{
+		indexed->second->index_file_name	= index_file_name;
+		indexed->second->index_path			= index_path;
+		indexed->second->is_index_resolved	= true;
+	}
+
+	return index_path;
+}
+
+void StaticFileCache::invalidate(const std::string_view path)
+{
+	make_lookup_key(path);
+
+	erase_entry(lookup_key);
+
+	/* Copied, the key is rebuilt in place */
+	const std::string directory_path(get_parent_directory(lookup_key));
+
+	make_lookup_key(directory_path);
+
+	erase_entry(lookup_key);
+}
+
+void StaticFileCache::handle_file_events()
+{
+	alignas(inotify_event) char buffer[4096];
+
+	for (;;)
+	{
+		const ssize_t bytes_read = read(inotify_file_descriptor, buffer, sizeof(buffer));
+
+		if (bytes_read <= 0)
+			return;
+
+		for (ssize_t offset = 0; offset < bytes_read;)
+		{
+			const inotify_event* const file_event = reinterpret_cast<const inotify_event*>(buffer + offset);
+
+			offset += static_cast<ssize_t>(sizeof(inotify_event) + file_event->len);
+
+			/* Events were lost, nothing can be trusted */
+			if (file_event->mask & IN_Q_OVERFLOW)
+			{
+				clear();
+				continue;
+			}
+
+			const auto watched_directory = watched_directories.find(file_event->wd);
+
+			if (watched_directory == watched_directories.end())
+				continue;
+
+			/* The directory itself went away or moved: everything resolved through it */
+			if (file_event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+			{
+				for (auto entry = entries.begin(); entry != entries.end();)
+				{
+					const auto next_entry = std::next(entry);
+
+					if (entry->watch_descriptor == file_event->wd)
+						erase_entry(entry);
+
+					entry = next_entry;
+				}
+
+				watched_directories.erase(file_event->wd);
+				continue;
+			}
+
+			/* The entry stays watched until it is erased, the directory's path is copied first */
+			const std::string directory_path = watched_directory->second.path;
+
+			erase_entry(std::string_view(directory_path));
+
+			if (file_event->len)
+			{
+				make_lookup_key(directory_path + "/" + file_event->name);
+				erase_entry(lookup_key);
+			}
+		}
+	}
+}
@@ -0,0 +1,186 @@
+#include <algorithm>
+
+#include "server/TimerWheel.hpp"
+
+TimerWheel::TimerWheel()
+	:	start_time(Clock::now()),
+		current_tick(0),
+		timer_count(0)
+{
+	slot_heads.fill(-1);
+}
+
+uint64_t TimerWheel::get_tick(const Clock::time_point time_point, const bool round_up) const noexcept
+{
+	if (time_point <= start_time)
+		return 0;
+
+	const uint64_t elapsed_milliseconds = static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::milliseconds>(time_point - start_time).count()
+	);
+
+	return round_up
+		 ? (elapsed_milliseconds + _TIMER_WHEEL_TICK_MILLISECONDS - 1) / _TIMER_WHEEL_TICK_MILLISECONDS
+		 : elapsed_milliseconds / _TIMER_WHEEL_TICK_MILLISECONDS;
+}
+
+void TimerWheel::link_timer(const int key, uint64_t expiry_tick) noexcept
+{
+	constexpr uint64_t wheel_span = uint64_t(1) << (_TIMER_WHEEL_SLOT_BITS * _TIMER_WHEEL_LEVELS);
+
+	/* Never in the past, never beyond what the top level can hold */
+	expiry_tick = std::clamp(expiry_tick, current_tick, (current_tick | (wheel_span - 1)));
+
+	size_t level = 0;
+
+	while (level + 1 < _TIMER_WHEEL_LEVELS &&
+		(expiry_tick >> (_TIMER_WHEEL_SLOT_BITS * (level + 1))) !=
+		(current_tick >> (_TIMER_WHEEL_SLOT_BITS * (level + 1))))
+		++level;
+
+	const size_t slot = level * _SLOTS_PER_LEVEL
+					  + ((expiry_tick >> (_TIMER_WHEEL_SLOT_BITS * level)) & _SLOT_MASK);
+
+	TimerNode& timer_node = timer_nodes[static_cast<size_t>(key)];
+
+	timer_node.expiry_tick	= expiry_tick;
+	timer_node.slot			= static_cast<int32_t>(slot);
+	timer_node.previous		= -1;
+	timer_node.next			= slot_heads[slot];
+
+	if (timer_node.next >= 0)
+		timer_nodes[static_cast<size_t>(timer_node.next)].previous = key;
+
+	slot_heads[slot] = key;
+}
+
+void TimerWheel::unlink_timer(const int key) noexcept
+{
+	TimerNode& timer_node = timer_nodes[static_cast<size_t>(key)];
+
+	if (timer_node.previous >= 0)
+		timer_nodes[static_cast<size_t>(timer_node.previous)].next = timer_node.next;
+	else
+		slot_heads[static_cast<size_t>(timer_node.slot)] = timer_node.next;
+
+	if (timer_node.next >= 0)
+		timer_nodes[static_cast<size_t>(timer_node.next)].previous = timer_node.previous;
+
+	timer_node.previous	= -1;
+	timer_node.next		= -1;
+	timer_node.slot		= -1;
+}
+
+void TimerWheel::schedule(const int key, const std::chrono::milliseconds delay)
+{
+	if (key < 0)
+		return;
+
+	if (static_cast<size_t>(key) >= timer_nodes.size())
+		timer_nodes.resize(static_cast<size_t>(key) + 1);
+
+	if (timer_nodes[static_cast<size_t>(key)].slot >= 0)
+		unlink_timer(key);
+	else
+		++timer_count;
+
+	/* The slot of the current tick has already been processed */
+	link_timer(key, std::max(get_tick(Clock::now() + delay, true), current_tick + 1));
+}
+
+void TimerWheel::cancel(const int key) noexcept
+{
+	if (!is_scheduled(key))
+		return;
+
+	unlink_timer(key);
+	--timer_count;
+}
+
+void TimerWheel::cascade_slot(const size_t level, const size_t slot_index) noexcept
+{
+	const size_t slot = level * _SLOTS_PER_LEVEL + slot_index;
+
+	int32_t key = slot_heads[slot];
+
+	slot_heads[slot] = -1;
+
+	while (key >= 0)
+	{
+		const int32_t next_key = timer_nodes[static_cast<size_t>(key)].next;
+
+		link_timer(key, timer_nodes[static_cast<size_t>(key)].expiry_tick);
+		key = next_key;
+	}
+}
+
+void TimerWheel::advance(std::vector<int>& expired_keys)
+{
+	expired_keys.clear();
+
+	const uint64_t target_tick = get_tick(Clock::now(), false);
+
+	/* Nothing to expire, skip the idle period at once */
+	if (!timer_count)
+	{
+		current_tick = std::max(current_tick, target_tick);
+		return;
+	}
+
+	while (current_tick < target_tick)
+	{
+		++current_tick;
+
+		/* Entering a new block of a level pulls its timers down, highest level first */
+		size_t cascade_level = 1;
+
+		while (cascade_level < _TIMER_WHEEL_LEVELS &&
+			!(current_tick & ((uint64_t(1) << (_TIMER_WHEEL_SLOT_BITS * cascade_level)) - 1)))
+			++cascade_level;
+
+		for (size_t level = cascade_level - 1; level >= 1; --level)
+			cascade_slot(level, (current_tick >> (_TIMER_WHEEL_SLOT_BITS * level)) & _SLOT_MASK);
+
+		const size_t slot = current_tick & _SLOT_MASK;
+
+		int32_t key = slot_heads[slot];
+
+		while (key >= 0)
+		{
+			const int32_t next_key = timer_nodes[static_cast<size_t>(key)].next;
+
+			unlink_timer(key);
+			--timer_count;
+
+			expired_keys.push_back(key);
+			key = next_key;
+		}
+
+		if (!timer_count)
+		{
+			current_tick = target_tick;
+			break;
+		}
+	}
+}
+
+int TimerWheel::get_wait_timeout_milliseconds() const
+{
+	if (!timer_count)
+		return -1;
+
+	/* Next non-empty level 0 slot, or the end of the current block at the latest */
+	uint64_t wake_tick = (current_tick | _SLOT_MASK) + 1;
+
+	for (uint64_t tick = current_tick + 1; tick < wake_tick; ++tick)
+		if (slot_heads[tick & _SLOT_MASK] >= 0)
+		{
+			wake_tick = tick;
+			break;
+		}
+
+	const auto wake_time = start_time + std::chrono::milliseconds(wake_tick * _TIMER_WHEEL_TICK_MILLISECONDS);
+	const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(wake_time - Clock::now()).count();
+
+	return remaining > 0 ? static_cast<int>(remaining) : 0;
+}
@@ -0,0 +1,389 @@
+#include <ctime>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "server/UringEventLoop.hpp"
+
+/* Completions carrying this user data belong to cancellations and are dropped */
+static constexpr uint64_t _URING_IGNORED_USER_DATA = UINT64_MAX;
+
+static inline uint64_t encode_user_data(const int file_descriptor, const uint32_t generation)
+{
+	return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(file_descriptor);
+}
+
+UringEventLoop::UringEventLoop()
+	:	uring_file_descriptor(-1),
+		submission_ring(MAP_FAILED),
+		completion_ring(MAP_FAILED),
+		submission_entries(static_cast<io_uring_sqe*>(MAP_FAILED)),
+		submission_ring_size(0),
+		completion_ring_size(0),
+		submission_entries_size(0),
+		submission_head(nullptr),
+		submission_tail(nullptr),
+		submission_mask(nullptr),
+		submission_array(nullptr),
+		completion_head(nullptr),
+		completion_tail(nullptr),
+		completion_mask(nullptr),
+		completion_entries(nullptr),
+		queued_submissions(0)
+{
+	io_uring_params uring_parameters = {};
+
+	uring_parameters.flags		= IORING_SETUP_CQSIZE;
+	uring_parameters.cq_entries	= _URING_COMPLETION_ENTRIES;
+
+	uring_file_descriptor = static_cast<int>(syscall(
+		__NR_io_uring_setup, _URING_SUBMISSION_ENTRIES, &uring_parameters
+	));
+
+	if (uring_file_descriptor < 0)
+		throw std::runtime_error(
+			"io_uring_setup failed: " + std::string(strerror(errno))
+		);
+
+	if (!(uring_parameters.features & IORING_FEAT_EXT_ARG) ||
+		!(uring_parameters.features & IORING_FEAT_NODROP))
+	{
+		close(uring_file_descriptor);
+		throw std::runtime_error(
+			"io_uring is missing required features (Linux 5.11+ needed)"
+		);
+	}
+
+	submission_ring_size	= uring_parameters.sq_off.array
+							+ uring_parameters.sq_entries * sizeof(uint32_t);
+	completion_ring_size	= uring_parameters.cq_off.cqes
+							+ uring_parameters.cq_entries * sizeof(io_uring_cqe);
+	submission_entries_size	= uring_parameters.sq_entries * sizeof(io_uring_sqe);
+
+	const bool single_mapping = uring_parameters.features & IORING_FEAT_SINGLE_MMAP;
+
+	if (single_mapping)
+		submission_ring_size = completion_ring_size = std::max(
+			submission_ring_size, completion_ring_size
+		);
+
+	submission_ring = mmap(
+		nullptr, submission_ring_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, uring_file_descriptor, IORING_OFF_SQ_RING
+	);
+
+	completion_ring = single_mapping ? submission_ring : mmap(
+		nullptr, completion_ring_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, uring_file_descriptor, IORING_OFF_CQ_RING
+	);
+
+	submission_entries = static_cast<io_uring_sqe*>(mmap(
+		nullptr, submission_entries_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, uring_file_descriptor, IORING_OFF_SQES
+	));
+
+	if (submission_ring == MAP_FAILED || completion_ring == MAP_FAILED ||
+		submission_entries == MAP_FAILED)
+	{
+		const std::string error = strerror(errno);
+
+		release_uring_resources();
+		throw std::runtime_error(
+			"Failed to map io_uring rings: " + error
+		);
+	}
+
+	char* submission_base = static_cast<char*>(submission_ring);
+	char* completion_base = static_cast<char*>(completion_ring);
+
+	submission_head		= reinterpret_cast<uint32_t*>(submission_base + uring_parameters.sq_off.head);
+	submission_tail		= reinterpret_cast<uint32_t*>(submission_base + uring_parameters.sq_off.tail);
+	submission_mask		= reinterpret_cast<uint32_t*>(submission_base + uring_parameters.sq_off.ring_mask);
+	submission_array	= reinterpret_cast<uint32_t*>(submission_base + uring_parameters.sq_off.array);
+
+	completion_head		= reinterpret_cast<uint32_t*>(completion_base + uring_parameters.cq_off.head);
+	completion_tail		= reinterpret_cast<uint32_t*>(completion_base + uring_parameters.cq_off.tail);
+	completion_mask		= reinterpret_cast<uint32_t*>(completion_base + uring_parameters.cq_off.ring_mask);
+	completion_entries	= reinterpret_cast<io_uring_cqe*>(completion_base + uring_parameters.cq_off.cqes);
+}
+
+UringEventLoop::~UringEventLoop()
+{
+	release_uring_resources();
+}
+
+void UringEventLoop::release_uring_resources() noexcept
+{
+	if (submission_entries != MAP_FAILED)
+		munmap(submission_entries, submission_entries_size);
+
+	if (completion_ring != MAP_FAILED && completion_ring != submission_ring)
+		munmap(completion_ring, completion_ring_size);
+
+	if (submission_ring != MAP_FAILED)
+		munmap(submission_ring, submission_ring_size);
+
+	if (uring_file_descriptor >= 0)
+		close(uring_file_descriptor);
+
+	submission_entries		= static_cast<io_uring_sqe*>(MAP_FAILED);
+	completion_ring			= MAP_FAILED;
+	submission_ring			= MAP_FAILED;
+	uring_file_descriptor	= -1;
+}
+
+UringEventLoop::UringFileDescriptorState& UringEventLoop::get_file_descriptor_state(
+	const int file_descriptor)
+{
+	const size_t state_index = static_cast<size_t>(file_descriptor);
+
+	if (state_index >= file_descriptor_states.size())
+		file_descriptor_states.resize(state_index + 1);
+
+	return file_descriptor_states[state_index];
+}
+
+io_uring_sqe* UringEventLoop::get_submission_entry()
+{
+	const uint32_t tail = *submission_tail;
+
+	/* Writing before the kernel consumed the entry would lose a poll request or its cancellation */
+	while (tail - __atomic_load_n(submission_head, __ATOMIC_ACQUIRE) > *submission_mask)
+	{
+		if (enter_uring(0, 0))
+			continue;
+
+		/* Completions waiting to be reaped (EBUSY) are kept for the next wait_for_events() */
+		if (errno == EBUSY)
+			defer_completions();
+	}
+
+	const uint32_t index = tail & *submission_mask;
+
+	io_uring_sqe* submission_entry = &submission_entries[index];
+	std::memset(submission_entry, 0, sizeof(*submission_entry));
+
+	submission_array[index] = index;
+	__atomic_store_n(submission_tail, tail + 1, __ATOMIC_RELEASE);
+
+	++queued_submissions;
+
+	return submission_entry;
+}
+
+void UringEventLoop::queue_poll_remove(const int file_descriptor, UringFileDescriptorState& state)
+{
+	io_uring_sqe* submission_entry = get_submission_entry();
+
+	submission_entry->opcode	= IORING_OP_POLL_REMOVE;
+	submission_entry->fd		= -1;
+	submission_entry->addr		= encode_user_data(file_descriptor, state.generation);
+	submission_entry->user_data	= _URING_IGNORED_USER_DATA;
+
+	state.armed = false;
+	++state.generation;
+}
+
+void UringEventLoop::add_file_descriptor(const int file_descriptor, const uint32_t events)
+{
+	UringFileDescriptorState& state = get_file_descriptor_state(file_descriptor);
+
+	if (state.registered)
+		throw std::runtime_error(
+			"File descriptor is already monitored: " + std::to_string(file_descriptor)
+		);
+
+	state.events		= events;
+	state.registered	= true;
+
+	if (!state.pending)
+	{
+		state.pending = true;
+		pending_file_descriptors.push_back(file_descriptor);
+	}
+}
+
+void UringEventLoop::modify_file_descriptor(const int file_descriptor, const uint32_t events)
+{
+	UringFileDescriptorState& state = get_file_descriptor_state(file_descriptor);
+
+	if (!state.registered)
+		throw std::runtime_error(
+			"File descriptor is not monitored: " + std::to_string(file_descriptor)
+		);
+
+	if (state.events == events)
+		return;
+
+	state.events = events;
+
+	if (state.armed)
+		queue_poll_remove(file_descriptor, state);
+
+	if (!state.pending)
+	{
+		state.pending = true;
+		pending_file_descriptors.push_back(file_descriptor);
+	}
+}
+
+void UringEventLoop::remove_file_descriptor(const int file_descriptor)
+{
+	if (static_cast<size_t>(file_descriptor) >= file_descriptor_states.size())
+		return;
+
+	UringFileDescriptorState& state = file_descriptor_states[static_cast<size_t>(file_descriptor)];
+
+	if (state.armed)
+		queue_poll_remove(file_descriptor, state);
+
+	state.registered = false;
+	++state.generation;
+}
+
+void UringEventLoop::queue_pending_poll_requests()
+{
+	for (const int file_descriptor : pending_file_descriptors)
+	{
+		UringFileDescriptorState& state = file_descriptor_states[static_cast<size_t>(file_descriptor)];
+
+		state.pending = false;
+
+		if (!state.registered || state.armed)
+			continue;
+
+		io_uring_sqe* submission_entry = get_submission_entry();
+
+		submission_entry->opcode		= IORING_OP_POLL_ADD;
+		submission_entry->fd			= file_descriptor;
+		submission_entry->poll32_events	= state.events;
+		submission_entry->user_data		= encode_user_data(file_descriptor, state.generation);
+
+		state.armed = true;
+	}
+
+	pending_file_descriptors.clear();
+}
+
+bool UringEventLoop::enter_uring(const uint32_t minimum_completions, const int timeout_milliseconds)
+{
+	__kernel_timespec timeout = {};
+
+	io_uring_getevents_arg wait_argument = {};
+
+	wait_argument.sigmask_sz = _NSIG / 8;
+
+	if (timeout_milliseconds >= 0)
+	{
+		timeout.tv_sec	= timeout_milliseconds / 1000;
+		timeout.tv_nsec	= static_cast<long long>(timeout_milliseconds % 1000) * 1000000;
+
+		wait_argument.ts = reinterpret_cast<uint64_t>(&timeout);
+	}
+
+	const uint32_t enter_flags = minimum_completions
+							   ? IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG
+							   : IORING_ENTER_EXT_ARG;
+
+	const long enter_result = syscall(
+		__NR_io_uring_enter, uring_file_descriptor,
+		queued_submissions, minimum_completions, enter_flags,
+		&wait_argument, sizeof(wait_argument)
+	);
+
+	++backend_syscall_count;
+
+	if (enter_result < 0)
+	{
+		if (errno == EINTR || errno == ETIME || errno == EBUSY || errno == EAGAIN)
+			return false;
+
+		throw std::runtime_error(
+			"io_uring_enter syscall failed: " + std::string(strerror(errno))
+		);
+	}
+
+	queued_submissions -= static_cast<uint32_t>(enter_result);
+
+	return true;
+}
+
+size_t UringEventLoop::wait_for_events(
+	std::vector<EventLoopEvent>&	ready_events,
+	const int						timeout_milliseconds)
+{
+	ready_events.clear();
+
+	queue_pending_poll_requests();
+
+	uint32_t head = *completion_head;
+
+	/* Only block when nothing is waiting in the completion ring or was deferred already */
+	if (head == __atomic_load_n(completion_tail, __ATOMIC_ACQUIRE) && deferred_completions.empty())
+		enter_uring(1, timeout_milliseconds);
+
+	else if (queued_submissions)
+		enter_uring(0, 0);
+
+	for (const io_uring_cqe& completion_entry : deferred_completions)
+		handle_completion(completion_entry, ready_events);
+
+	deferred_completions.clear();
+
+	const uint32_t tail = __atomic_load_n(completion_tail, __ATOMIC_ACQUIRE);
+
+	for (; head != tail; ++head)
+		handle_completion(completion_entries[head & *completion_mask], ready_events);
+
+	__atomic_store_n(completion_head, head, __ATOMIC_RELEASE);
+
+	return ready_events.size();
+}
+
+void UringEventLoop::defer_completions()
+{
+	uint32_t		head = *completion_head;
+	const uint32_t	tail = __atomic_load_n(completion_tail, __ATOMIC_ACQUIRE);
+
+	for (; head != tail; ++head)
+		deferred_completions.push_back(completion_entries[head & *completion_mask]);
+
+	__atomic_store_n(completion_head, head, __ATOMIC_RELEASE);
+}
+
+void UringEventLoop::handle_completion(const io_uring_cqe& completion_entry, std::vector<EventLoopEvent>& ready_events)
+{
+	if (completion_entry.user_data == _URING_IGNORED_USER_DATA)
+		return;
+
+	const int		file_descriptor	= static_cast<int>(completion_entry.user_data & 0xffffffffu);
+	const uint32_t	generation		= static_cast<uint32_t>(completion_entry.user_data >> 32);
+
+	UringFileDescriptorState& state = file_descriptor_states[static_cast<size_t>(file_descriptor)];
+
+	/* Completion of a request that was cancelled or replaced */
+	if (!state.registered || state.generation != generation)
+		return;
+
+	state.armed = false;
+
+	if (!state.pending)
+	{
+		state.pending = true;
+		pending_file_descriptors.push_back(file_descriptor);
+	}
+
+	if (completion_entry.res == -ECANCELED)
+		return;
+
+	ready_events.push_back({
+		file_descriptor,
+		completion_entry.res < 0 ? static_cast<uint32_t>(POLLERR)
+								 : static_cast<uint32_t>(completion_entry.res)
+	});
+}
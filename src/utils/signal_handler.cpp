@@ -1,34 +1,69 @@
 #include "utils/utils.hpp"
 
-#include <stdexcept>
-#include <iostream>
+#include <ctime>
+#include <cerrno>
 #include <csignal>
-#include <cstdlib>
-
-#include "server/Server.hpp"
-
-static Server* __g_instance = nullptr;
+#include <cstring>
+#include <stdexcept>
+#include <pthread.h>
 
-static void SignalHandler(int __signo)
+/* Never async-signal-unsafe, only sigemptyset() and sigaddset() */
+static sigset_t get_server_signal_set() noexcept
 {
-	std::cout << "\nInterrupt signal (" << __signo << ") received.\n";
-	if (__g_instance) __g_instance->set_server_running(false);
+	sigset_t server_signal_set;
+
+	sigemptyset(&server_signal_set);
+	sigaddset(&server_signal_set, SIGINT);
+	sigaddset(&server_signal_set, SIGTERM);
+	sigaddset(&server_signal_set, SIGQUIT);
+	sigaddset(&server_signal_set, SIGHUP);
+	sigaddset(&server_signal_set, SIGUSR2);
 
-	/* By this point no leaks should exist */
-	std::exit(EXIT_SUCCESS);
+	return server_signal_set;
 }
 
-void Utils::register_signal_handler(Server* instance)
+void Utils::block_server_signals()
 {
-	__g_instance = instance;
+	const sigset_t server_signal_set = get_server_signal_set();
 
-	if (std::signal(SIGINT, SignalHandler) == SIG_ERR)
+	const int error_code = pthread_sigmask(SIG_BLOCK, &server_signal_set, nullptr);
+
+	if (error_code)
 		throw std::runtime_error(
-			"Failed to register SIGINT signal handler"
+			"Failed to block the server signals: " + std::string(strerror(error_code))
 		);
+}
+
+void Utils::unblock_server_signals() noexcept
+{
+	const sigset_t server_signal_set = get_server_signal_set();
+
+	sigprocmask(SIG_UNBLOCK, &server_signal_set, nullptr);
+
+	/* Ignored dispositions survive execve() too, unlike handlers */
+	signal(SIGPIPE, SIG_DFL);
+}
+
+int Utils::wait_for_server_signal(const int timeout_milliseconds)
+{
+	const sigset_t server_signal_set = get_server_signal_set();
+
+	const timespec timeout = {
+		timeout_milliseconds / 1000,
+		static_cast<long>(timeout_milliseconds % 1000) * 1000000L
+	};
+
+	const int signal_number = sigtimedwait(&server_signal_set, nullptr, &timeout);
+
+	if (signal_number < 0)
+	{
+		if (errno == EAGAIN || errno == EINTR)
+			return 0;
 
-	if (std::signal(SIGQUIT, SignalHandler) == SIG_ERR)
 		throw std::runtime_error(
-			"Failed to register SIGQUIT signal handler"
+			"Failed to wait for server signals: " + std::string(strerror(errno))
 		);
+	}
+
+	return signal_number;
 }